@@ -0,0 +1,201 @@
+#include <math.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "base_aircraft.h"
+
+LOG_MODULE_REGISTER(base_aircraft, LOG_LEVEL_ERR);
+
+#define BASE_AIRCRAFT_SLOTS CONFIG_BASE_AIRCRAFT_TABLE_SIZE
+#define BASE_AIRCRAFT_EXPIRY_MS (CONFIG_BASE_AIRCRAFT_EXPIRY_S * 1000U)
+
+BUILD_ASSERT(IS_POWER_OF_TWO(BASE_AIRCRAFT_SLOTS),
+             "CONFIG_BASE_AIRCRAFT_TABLE_SIZE must be a power of two");
+BUILD_ASSERT(BASE_AIRCRAFT_SLOTS >= BASE_AIRCRAFT_PROBE);
+
+/*
+ * Addresses are probed on their own so a window of them shares a cache
+ * line; the aircraft in slot i is aircraft[i]
+ */
+static uint32_t icaos[BASE_AIRCRAFT_SLOTS];
+static struct base_aircraft aircraft[BASE_AIRCRAFT_SLOTS];
+static int count;
+
+/* Next slot base_aircraft_expire() checks */
+static uint32_t expire_cursor;
+
+/* First slot of an address's window (Fibonacci hashing) */
+static inline uint32_t base_aircraft_hash(uint32_t icao)
+{
+    return (icao * 2654435769U) >> (32 - LOG2(BASE_AIRCRAFT_SLOTS));
+}
+
+static inline uint32_t base_aircraft_probe(uint32_t start, int i)
+{
+    return (start + i) & (BASE_AIRCRAFT_SLOTS - 1);
+}
+
+static void base_aircraft_free(uint32_t slot)
+{
+    icaos[slot] = 0;
+    aircraft[slot].icao = 0;
+    count--;
+}
+
+/* Field by field, the padding after the callsign is never written */
+static bool base_aircraft_fix_equal(const struct base_aircraft_state *a,
+                                    const struct base_aircraft_state *b)
+{
+    return a->lat == b->lat && a->lon == b->lon &&
+           a->altitude == b->altitude && a->track == b->track &&
+           a->speed == b->speed;
+}
+
+/* The predictor takes the state in its own units */
+static void base_aircraft_fix(const struct base_aircraft_state *state,
+                              struct adsb_predict_fix *fix)
+{
+    fix->lat = state->lat;
+    fix->lon = state->lon;
+    fix->altitude = state->altitude;
+    fix->speed = state->speed;
+    fix->track = state->track;
+}
+
+extern struct base_aircraft *base_aircraft_find(uint32_t icao)
+{
+    icao &= BASE_AIRCRAFT_ICAO_MASK;
+    if (!icao) {
+        return NULL;
+    }
+
+    /* Free slots don't end the search, removals leave them anywhere */
+    uint32_t start = base_aircraft_hash(icao);
+    for (int i = 0; i < BASE_AIRCRAFT_PROBE; i++) {
+        uint32_t slot = base_aircraft_probe(start, i);
+        if (icaos[slot] == icao) {
+            return &aircraft[slot];
+        }
+    }
+    return NULL;
+}
+
+extern struct base_aircraft *base_aircraft_update(
+    uint32_t icao, const struct base_aircraft_state *state, uint32_t now_ms)
+{
+    struct base_aircraft *entry = base_aircraft_find(icao);
+
+    icao &= BASE_AIRCRAFT_ICAO_MASK;
+    if (!icao) {
+        return NULL;
+    }
+
+    bool added = !entry;
+    if (added) {
+        /* Take the first free slot, or the least recently updated */
+        uint32_t start = base_aircraft_hash(icao);
+        uint32_t victim = start;
+        for (int i = 0; i < BASE_AIRCRAFT_PROBE; i++) {
+            uint32_t slot = base_aircraft_probe(start, i);
+            if (!icaos[slot]) {
+                victim = slot;
+                break;
+            }
+            if (now_ms - aircraft[slot].updated_ms >
+                now_ms - aircraft[victim].updated_ms) {
+                victim = slot;
+            }
+        }
+
+        if (icaos[victim]) {
+            LOG_DBG("Evicting %06x for %06x", icaos[victim], icao);
+            base_aircraft_free(victim);
+        }
+
+        /*
+         * Revisions carry on from the slot's last aircraft, so one readded
+         * to the same slot never repeats a revision already sent
+         */
+        entry = &aircraft[victim];
+        uint32_t revision = entry->revision;
+        memset(entry, 0, sizeof(*entry));
+        entry->revision = revision;
+        entry->icao = icao;
+        icaos[victim] = icao;
+        count++;
+    }
+
+    bool moved = added ||
+                 !base_aircraft_fix_equal(&entry->latest, state);
+
+    /* A repeated report is not a new measurement of where it is */
+    if (moved) {
+        struct adsb_predict_fix fix;
+        base_aircraft_fix(state, &fix);
+        adsb_predict_update(&entry->predict, &fix, now_ms);
+    }
+
+    if (moved || strncmp(entry->latest.flight, state->flight,
+                         sizeof(state->flight))) {
+        entry->latest = *state;
+        entry->revision++;
+    }
+    entry->updated_ms = now_ms;
+    return entry;
+}
+
+extern void base_aircraft_predict(const struct base_aircraft *entry,
+                                  uint32_t now_ms,
+                                  struct base_aircraft_state *state)
+{
+    struct adsb_predict_fix fix;
+
+    *state = entry->latest;
+    adsb_predict_at(&entry->predict, now_ms, &fix);
+    state->lat = fix.lat;
+    state->lon = fix.lon;
+    state->altitude = MAX(lroundf(fix.altitude), 0);
+}
+
+extern struct base_aircraft *base_aircraft_at(int slot)
+{
+    return icaos[slot] ? &aircraft[slot] : NULL;
+}
+
+extern void base_aircraft_remove(struct base_aircraft *entry)
+{
+    if (entry->icao) {
+        base_aircraft_free(entry - aircraft);
+    }
+}
+
+extern int base_aircraft_expire(uint32_t now_ms, int budget)
+{
+    int expired = 0;
+
+    for (int i = 0; i < budget; i++) {
+        uint32_t slot = expire_cursor;
+
+        expire_cursor = base_aircraft_probe(expire_cursor, 1);
+        if (icaos[slot] &&
+            now_ms - aircraft[slot].updated_ms >= BASE_AIRCRAFT_EXPIRY_MS) {
+            base_aircraft_free(slot);
+            expired++;
+        }
+    }
+    return expired;
+}
+
+extern int base_aircraft_count(void)
+{
+    return count;
+}
+
+extern void base_aircraft_clear(void)
+{
+    memset(icaos, 0, sizeof(icaos));
+    memset(aircraft, 0, sizeof(aircraft));
+    count = 0;
+    expire_cursor = 0;
+}
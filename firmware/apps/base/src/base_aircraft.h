@@ -0,0 +1,136 @@
+/**
+ * @file base_aircraft.h
+ *
+ * @brief Table of the aircraft the base station is tracking.
+ *
+ * Aircraft are keyed by their 24-bit ICAO address. The table has a fixed,
+ * power of two capacity and uses open addressing: an aircraft lives in one
+ * of BASE_AIRCRAFT_PROBE consecutive slots starting at its hash, and every
+ * lookup checks exactly that window, so lookups, updates and removals take
+ * constant time. The addresses are kept in an array of their own, so a
+ * lookup reads a single cache line. When an aircraft's window is full, the
+ * aircraft in it that was updated longest ago is evicted.
+ *
+ * Each aircraft holds its latest state and a revision that only changes
+ * with it, so repeated updates from the Pi are not sent to the displays
+ * again. Revisions carry on across the aircraft a slot holds, so they never
+ * repeat within a slot. Each also has a predictor (adsb_predict.h),
+ * corrected by every update that moves the aircraft, so its position can be
+ * given for any time between updates. Aircraft not updated for
+ * CONFIG_BASE_AIRCRAFT_EXPIRY_S are expired a few slots at a time by
+ * base_aircraft_expire().
+ */
+
+#ifndef BASE_AIRCRAFT_H_
+#define BASE_AIRCRAFT_H_
+
+#include <zephyr/kernel.h>
+
+#include "adsb_predict.h"
+
+/* Number of slots an aircraft can occupy, starting at its hash */
+#define BASE_AIRCRAFT_PROBE 8
+
+/* ICAO addresses are 24 bits; 0 marks a free slot */
+#define BASE_AIRCRAFT_ICAO_MASK 0xFFFFFFU
+
+/* Callsign length, ADSBData.flight's max_size in phaethon.options */
+#define BASE_AIRCRAFT_FLIGHT_LEN 10
+
+/**
+ * @brief State of an aircraft, as reported by the Pi.
+ */
+struct base_aircraft_state {
+    char flight[BASE_AIRCRAFT_FLIGHT_LEN];  /* Callsign, NUL terminated */
+    float lat;           /* Degrees */
+    float lon;           /* Degrees */
+    uint32_t altitude;   /* Feet */
+    uint32_t track;      /* Degrees */
+    uint32_t speed;      /* Knots */
+};
+
+/**
+ * @brief A tracked aircraft.
+ */
+struct base_aircraft {
+    struct base_aircraft_state latest;  /* Last update received */
+    uint32_t updated_ms;                /* Uptime of the last update */
+    uint32_t revision;                  /* Changes when latest does */
+    uint32_t icao;
+    struct adsb_predict predict;        /* Position between updates */
+};
+
+/**
+ * @brief Records an update for an aircraft, adding it if it is new.
+ *
+ * The aircraft's revision is bumped if @p state differs from its latest.
+ *
+ * @param icao ICAO address, masked to 24 bits. Address 0 is rejected.
+ * @param state Latest state.
+ * @param now_ms Current uptime in milliseconds.
+ * @return The aircraft, or NULL if @p icao is 0.
+ */
+extern struct base_aircraft *base_aircraft_update(
+    uint32_t icao, const struct base_aircraft_state *state, uint32_t now_ms);
+
+/**
+ * @brief Predicts an aircraft's state.
+ *
+ * @param aircraft Tracked aircraft.
+ * @param now_ms Uptime to predict for, in milliseconds.
+ * @param state Receives the latest state with the position predicted for
+ *              @p now_ms.
+ */
+extern void base_aircraft_predict(const struct base_aircraft *aircraft,
+                                  uint32_t now_ms,
+                                  struct base_aircraft_state *state);
+
+/**
+ * @brief Finds a tracked aircraft.
+ *
+ * @param icao ICAO address.
+ * @return The aircraft, or NULL if it is not tracked.
+ */
+extern struct base_aircraft *base_aircraft_find(uint32_t icao);
+
+/**
+ * @brief Returns the aircraft in a slot of the table.
+ *
+ * Lets every tracked aircraft be visited, and state be kept alongside the
+ * table, indexed by slot.
+ *
+ * @param slot Slot, below CONFIG_BASE_AIRCRAFT_TABLE_SIZE.
+ * @return The aircraft, or NULL if the slot is free.
+ */
+extern struct base_aircraft *base_aircraft_at(int slot);
+
+/**
+ * @brief Removes an aircraft from the table.
+ *
+ * @param aircraft Tracked aircraft.
+ */
+extern void base_aircraft_remove(struct base_aircraft *aircraft);
+
+/**
+ * @brief Expires aircraft not updated for CONFIG_BASE_AIRCRAFT_EXPIRY_S.
+ *
+ * Checks the next @p budget slots after where the last call stopped, so
+ * calling it once per update keeps the table clean in constant time.
+ *
+ * @param now_ms Current uptime in milliseconds.
+ * @param budget Number of slots to check.
+ * @return Number of aircraft expired.
+ */
+extern int base_aircraft_expire(uint32_t now_ms, int budget);
+
+/**
+ * @brief Returns the number of tracked aircraft.
+ */
+extern int base_aircraft_count(void);
+
+/**
+ * @brief Removes every aircraft.
+ */
+extern void base_aircraft_clear(void);
+
+#endif // BASE_AIRCRAFT_H_
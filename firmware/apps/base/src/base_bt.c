@@ -60,6 +60,13 @@ extern int base_bt_wsu_data_recv(wsu_data_packet *pkt, k_timeout_t timeout)
     return k_msgq_get(&wsu_dataq, pkt, timeout);
 }
 
+/* Initialise a poll event which is ready when WSU data can be received */
+extern void base_bt_wsu_event_init(struct k_poll_event *evt)
+{
+    k_poll_event_init(evt, K_POLL_TYPE_MSGQ_DATA_AVAILABLE,
+                      K_POLL_MODE_NOTIFY_ONLY, &wsu_dataq);
+}
+
 /* Initialise Bluetooth */
 static inline bool base_bt_init(void)
 {
@@ -34,5 +34,6 @@ typedef struct {
 /* Prototypes */
 extern void base_bt_cmd_send(base_bt_cmd_t *cmd, k_timeout_t timeout);
 extern int base_bt_wsu_data_recv(wsu_data_packet *pkt, k_timeout_t timeout);
+extern void base_bt_wsu_event_init(struct k_poll_event *evt);
 
 #endif
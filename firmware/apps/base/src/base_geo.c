@@ -0,0 +1,120 @@
+#include <math.h>
+#include <zephyr/kernel.h>
+
+#include "base_geo.h"
+
+#define PI 3.14159265358979323846f
+
+// Convert degrees to radians
+static inline float degrees_to_radians(float degrees)
+{
+    return degrees * PI / 180.0f;
+}
+
+// Convert radians to degrees
+static inline float radians_to_degrees(float radians)
+{
+    return radians * 180.0f / PI;
+}
+
+extern bool base_geo_frame_update(struct base_geo_frame *frame, float lat,
+                                  float lon, float alt)
+{
+    if (frame->valid && frame->lat == lat && frame->lon == lon &&
+        frame->alt == alt) {
+        return false;
+    }
+
+    float phi = degrees_to_radians(lat);
+    float metres_per_deg = BASE_GEO_EARTH_RADIUS_M * degrees_to_radians(1.0f);
+
+    frame->lat = lat;
+    frame->lon = lon;
+    frame->alt = alt;
+    frame->north_per_deg = metres_per_deg;
+    frame->east_per_deg = metres_per_deg * cosf(phi);
+
+    /* cos(phi + d/2) ~= cos(phi) - sin(phi) * d / 2, d in radians */
+    frame->east_per_deg2 = -metres_per_deg * sinf(phi) *
+                           degrees_to_radians(0.5f);
+    frame->valid = true;
+    return true;
+}
+
+extern void base_geo_enu(const struct base_geo_frame *frame, float lat,
+                         float lon, float alt, struct base_geo_enu *enu)
+{
+    float dlat = lat - frame->lat;
+    float dlon = lon - frame->lon;
+
+    /* Take the short way across the antimeridian */
+    if (dlon > 180.0f) {
+        dlon -= 360.0f;
+    } else if (dlon < -180.0f) {
+        dlon += 360.0f;
+    }
+
+    enu->north = dlat * frame->north_per_deg;
+    enu->east = dlon * (frame->east_per_deg + dlat * frame->east_per_deg2);
+
+    /* The ground falls away from the tangent plane by d^2 / 2R */
+    enu->up = alt - frame->alt -
+              (enu->east * enu->east + enu->north * enu->north) *
+              (0.5f / BASE_GEO_EARTH_RADIUS_M);
+}
+
+extern void base_geo_look(const struct base_geo_enu *enu,
+                          struct base_geo_look *look)
+{
+    float ground2 = enu->east * enu->east + enu->north * enu->north;
+
+    look->azimuth = radians_to_degrees(atan2f(enu->east, enu->north));
+    if (look->azimuth < 0) {
+        look->azimuth += 360.0f;
+    }
+    look->elevation = radians_to_degrees(atan2f(enu->up, sqrtf(ground2)));
+    look->range = sqrtf(ground2 + enu->up * enu->up);
+}
+
+// Calculate the bearing between two points using the rhumb line technique
+extern float base_geo_rhumb_bearing(float lat1, float lon1, float lat2,
+                                    float lon2)
+{
+    /* Precalculate repeated values */
+    static const float PI_ON_4 = PI / 4.0f;
+    static const float TWO_PI = 2.0f * PI;
+
+    // Convert latitudes and longitudes from degrees to radians
+    float phi1 = degrees_to_radians(lat1);
+    float phi2 = degrees_to_radians(lat2);
+    float lambda1 = degrees_to_radians(lon1);
+    float lambda2 = degrees_to_radians(lon2);
+
+    // Calculate the projected latitude difference (Δψ)
+    float delta_psi = logf(tanf(PI_ON_4 + phi2 / 2.0f) / tanf(PI_ON_4 + phi1 / 2.0f));
+
+    // Calculate the difference in longitudes (Δλ)
+    float delta_lambda = lambda2 - lambda1;
+
+    // Adjust the difference in longitudes (Δλ) if necessary
+    if (fabsf(delta_lambda) > PI) {
+        if (delta_lambda > 0) {
+            delta_lambda = -(TWO_PI - delta_lambda);
+        } else {
+            delta_lambda = TWO_PI + delta_lambda;
+        }
+    }
+
+    // Calculate the bearing (brng)
+    float bearing = atan2f(delta_lambda, delta_psi);
+
+    // Convert the bearing from radians to degrees
+    bearing = radians_to_degrees(bearing);
+
+    // Normalize the bearing to be within the range [0, 360) degrees
+    if (bearing < 0) {
+        bearing += 360.0f;
+    }
+
+    return bearing;
+}
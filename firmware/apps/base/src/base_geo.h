@@ -0,0 +1,101 @@
+/**
+ * @file base_geo.h
+ *
+ * @brief Aircraft positions relative to the base station.
+ *
+ * The observer's local East-North-Up frame is cached in a base_geo_frame and
+ * only recomputed when the GPS fix moves. Projecting an aircraft into the
+ * frame then takes a handful of multiply-adds: the frame is tangent to the
+ * Earth at the observer, longitude is scaled by the cosine of the latitude
+ * midway to the aircraft, and the Earth's curvature is taken off the height.
+ * Within ADS-B range this agrees with the rhumb line bearing to a few
+ * hundredths of a degree.
+ */
+
+#ifndef BASE_GEO_H_
+#define BASE_GEO_H_
+
+#include <zephyr/kernel.h>
+
+/* Mean Earth radius, metres */
+#define BASE_GEO_EARTH_RADIUS_M 6371008.8f
+
+#define BASE_GEO_FT_TO_M(ft) ((float)(ft) * 0.3048f)
+
+/**
+ * @brief Cached East-North-Up frame at the observer.
+ */
+struct base_geo_frame {
+    float lat;              /* Origin, degrees */
+    float lon;              /* Origin, degrees */
+    float alt;              /* Origin, metres */
+    float north_per_deg;    /* Metres north per degree of latitude */
+    float east_per_deg;     /* Metres east per degree of longitude */
+    float east_per_deg2;    /* Change in east_per_deg per degree north */
+    bool valid;
+};
+
+/**
+ * @brief Position in an observer's East-North-Up frame, metres.
+ */
+struct base_geo_enu {
+    float east;
+    float north;
+    float up;
+};
+
+/**
+ * @brief Direction and distance of a position from the observer.
+ */
+struct base_geo_look {
+    float azimuth;    /* Degrees clockwise from north, [0, 360) */
+    float elevation;  /* Degrees above the horizon, [-90, 90] */
+    float range;      /* Slant range, metres */
+};
+
+/**
+ * @brief Moves the frame's origin to the observer's position.
+ *
+ * @param frame Frame to update.
+ * @param lat Observer latitude, degrees.
+ * @param lon Observer longitude, degrees.
+ * @param alt Observer altitude, metres.
+ * @return true if the frame was recomputed, false if the observer has not
+ *         moved.
+ */
+extern bool base_geo_frame_update(struct base_geo_frame *frame, float lat,
+                                  float lon, float alt);
+
+/**
+ * @brief Projects a position into the observer's frame.
+ *
+ * @param frame Valid frame.
+ * @param lat Latitude, degrees.
+ * @param lon Longitude, degrees.
+ * @param alt Altitude, metres.
+ * @param enu Filled with the position in the frame.
+ */
+extern void base_geo_enu(const struct base_geo_frame *frame, float lat,
+                         float lon, float alt, struct base_geo_enu *enu);
+
+/**
+ * @brief Converts a position in the frame to azimuth, elevation and range.
+ *
+ * @param enu Position in the frame.
+ * @param look Filled with the direction and distance.
+ */
+extern void base_geo_look(const struct base_geo_enu *enu,
+                          struct base_geo_look *look);
+
+/**
+ * @brief Rhumb line bearing between two points.
+ *
+ * The reference the frame is checked against; it costs a logf(), two
+ * tanf() and an atan2f() per call.
+ *
+ * @return Bearing from the first point to the second, degrees [0, 360).
+ */
+extern float base_geo_rhumb_bearing(float lat1, float lon1, float lat2,
+                                    float lon2);
+
+#endif // BASE_GEO_H_
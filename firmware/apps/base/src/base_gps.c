@@ -51,6 +51,14 @@ int base_gps_i2c_data_recv(gps_base_data *gps_struct, k_timeout_t timeout) {
 
 }
 
+/* Initialise a poll event which is ready when a gps data struct is queued */
+void base_gps_event_init(struct k_poll_event *evt) {
+
+    k_poll_event_init(evt, K_POLL_TYPE_MSGQ_DATA_AVAILABLE,
+                      K_POLL_MODE_NOTIFY_ONLY, &gps_base_msgq);
+
+}
+
 /* *** FUNCTIONS WHICH RUN IN THREAD *** */
 bool gps_init(const struct device *dev) {
     if (!device_is_ready(dev)) {
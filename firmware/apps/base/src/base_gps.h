@@ -12,5 +12,6 @@ typedef struct {
 
 /* Prototypes */
 int base_gps_i2c_data_recv(gps_base_data *gps_struct, k_timeout_t timeout);
+void base_gps_event_init(struct k_poll_event *evt);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <pb_decode.h>
+
+#include "dlt_api.h"
+#include "base_pi.h"
+
+LOG_MODULE_REGISTER(base_pi, LOG_LEVEL_ERR);
+
+extern int base_pi_read(uint8_t ep, ADSBData *message)
+{
+    uint8_t data[ADSBData_size];
+    uint8_t msg_type;
+
+    uint16_t len = dlt_read(ep, &msg_type, data, sizeof(data), K_NO_WAIT);
+    if (!len) {
+        return -EAGAIN;
+    }
+
+    *message = (ADSBData)ADSBData_init_zero;
+    pb_istream_t stream = pb_istream_from_buffer(data, len);
+    if (!pb_decode(&stream, ADSBData_fields, message)) {
+        LOG_ERR("Decoding failed: %s", PB_GET_ERROR(&stream));
+        return -EBADMSG;
+    }
+    return 0;
+}
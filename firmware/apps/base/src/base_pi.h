@@ -0,0 +1,32 @@
+/**
+ * @file base_pi.h
+ *
+ * @brief ADS-B updates from the Pi.
+ *
+ * The Pi sends each aircraft update as an ADSBData protobuf message over
+ * its DLT link. A worst-case update is larger than the UART link's MTU, so
+ * the Pi fragments it; updates are read through dlt_read(), which
+ * reassembles them, before they are decoded.
+ */
+
+#ifndef BASE_PI_H_
+#define BASE_PI_H_
+
+#include <zephyr/kernel.h>
+
+#include "phaethon.pb.h"
+
+/**
+ * @brief Reads the next ADS-B update the Pi sent.
+ *
+ * Does not wait for an update to arrive, but once the first fragment of
+ * one is read, waits up to CONFIG_DLT_REASSEMBLY_TIMEOUT_MS for the rest.
+ *
+ * @param ep Endpoint of the Pi's link.
+ * @param message Receives the decoded update.
+ * @return 0 on success, -EAGAIN if no update was queued or it was dropped
+ *         while reassembling, or -EBADMSG if it did not decode.
+ */
+extern int base_pi_read(uint8_t ep, ADSBData *message);
+
+#endif // BASE_PI_H_
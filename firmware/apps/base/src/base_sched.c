@@ -0,0 +1,187 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "base_sched.h"
+
+LOG_MODULE_REGISTER(base_sched, LOG_LEVEL_ERR);
+
+#define BASE_SCHED_SLOTS CONFIG_BASE_AIRCRAFT_TABLE_SIZE
+
+/* Tokens saved up while idle, enough for one message at any budget */
+#define BASE_SCHED_BURST_PERIODS 2
+#define BASE_SCHED_MIN_BURST     64
+
+/* A candidate aircraft and its rank, lower is better */
+struct base_sched_rank {
+    int slot;
+    float score;
+};
+
+/* Aircraft positions for this run, shared by every display */
+static struct base_sky_batch base_sched_batch;
+
+/* Each aircraft against the display being ranked */
+static float base_sched_cos[BASE_SCHED_SLOTS];
+static uint32_t base_sched_enter[BASE_SKY_MASK_WORDS];
+static uint32_t base_sched_leave[BASE_SKY_MASK_WORDS];
+
+extern void base_sched_init(struct base_sched_display *display,
+                            uint32_t budget, uint32_t now_ms)
+{
+    memset(display, 0, sizeof(*display));
+    display->budget = budget;
+    display->refilled_ms = now_ms;
+}
+
+extern void base_sched_point(struct base_sched_display *display, float yaw,
+                             float pitch, float aperture, float max_range)
+{
+    base_sky_patch_set(&display->enter, yaw, pitch, aperture, max_range);
+    base_sky_patch_set(&display->leave, yaw, pitch,
+                       MIN(aperture + CONFIG_BASE_SCHED_HYSTERESIS_DEG, 180.f),
+                       max_range);
+}
+
+/* Add the budget earned since the last run, returns what can be sent now */
+static size_t base_sched_refill(struct base_sched_display *display,
+                                uint32_t now_ms)
+{
+    if (!display->budget) {
+        return SIZE_MAX;
+    }
+
+    int32_t cap = MAX(display->budget * BASE_SCHED_BURST_PERIODS *
+                      CONFIG_BASE_SCHED_PERIOD_MS / 1000,
+                      BASE_SCHED_MIN_BURST);
+    uint64_t earned = (uint64_t)(now_ms - display->refilled_ms) *
+                      display->budget / 1000;
+
+    display->tokens = MIN(display->tokens + (int64_t)earned, cap);
+    display->refilled_ms = now_ms;
+    return display->tokens;
+}
+
+/* Insert a candidate into the best K so far, kept sorted */
+static int base_sched_insert(struct base_sched_rank *best, int n, int slot,
+                             float score)
+{
+    int i = MIN(n, CONFIG_BASE_SCHED_TOP_K);
+
+    if (i == CONFIG_BASE_SCHED_TOP_K && score >= best[i - 1].score) {
+        return n;
+    }
+
+    for (; i > 0 && best[i - 1].score > score; i--) {
+        if (i < CONFIG_BASE_SCHED_TOP_K) {
+            best[i] = best[i - 1];
+        }
+    }
+    best[i].slot = slot;
+    best[i].score = score;
+    return MIN(n + 1, CONFIG_BASE_SCHED_TOP_K);
+}
+
+/* Rank the aircraft a display should be sent, returns how many */
+static int base_sched_rank(struct base_sched_display *display,
+                           uint32_t now_ms, struct base_sched_rank *best)
+{
+    /* Angles off the boresight as a fraction of the aperture */
+    float off_scale = MAX(1.0f - display->enter.cos_aperture, 1e-6f);
+    int n = 0;
+
+    /* Every aircraft against where the display points now, the patches
+     * share a boresight */
+    base_sky_batch_cos(&display->enter, &base_sched_batch, base_sched_cos);
+    base_sky_batch_mask(&display->enter, &base_sched_batch, base_sched_cos,
+                        base_sched_enter);
+    base_sky_batch_mask(&display->leave, &base_sched_batch, base_sched_cos,
+                        base_sched_leave);
+
+    for (int slot = 0; slot < BASE_SCHED_SLOTS; slot++) {
+        struct base_aircraft *aircraft = base_aircraft_at(slot);
+        struct base_sched_slot *state = &display->slots[slot];
+
+        if (!aircraft) {
+            state->icao = 0;
+            continue;
+        }
+
+        /* The slot has been taken by another aircraft */
+        if (state->icao != aircraft->icao) {
+            *state = (struct base_sched_slot){.icao = aircraft->icao};
+        }
+
+        state->in_view = base_sky_mask_test(
+            state->in_view ? base_sched_leave : base_sched_enter, slot);
+        if (!state->in_view) {
+            continue;
+        }
+
+        uint32_t age = now_ms - state->sent_ms;
+        if (state->revision == aircraft->revision &&
+            age < CONFIG_BASE_AIRCRAFT_REFRESH_MS) {
+            continue;
+        }
+
+        float off = (1.0f - base_sched_cos[slot]) / off_scale;
+        float stale = state->revision ?
+                      (float)MIN(age, CONFIG_BASE_SCHED_STALE_MS) /
+                      CONFIG_BASE_SCHED_STALE_MS : 1.0f;
+        n = base_sched_insert(best, n, slot, off - stale);
+    }
+
+    return n;
+}
+
+extern int base_sched_run(struct base_sched_display *displays, int count,
+                          const struct base_geo_frame *frame, uint32_t now_ms,
+                          base_sched_send_t send, void *user_data)
+{
+    struct base_sched_rank best[CONFIG_BASE_SCHED_TOP_K];
+    int sent = 0;
+
+    base_sky_batch_clear(&base_sched_batch);
+    for (int slot = 0; slot < BASE_SCHED_SLOTS; slot++) {
+        const struct base_aircraft *aircraft = base_aircraft_at(slot);
+        struct base_aircraft_state state;
+        struct base_geo_enu enu;
+
+        /* Where the aircraft is now, not where it was last reported */
+        if (aircraft) {
+            base_aircraft_predict(aircraft, now_ms, &state);
+            base_geo_enu(frame, state.lat, state.lon,
+                         BASE_GEO_FT_TO_M(state.altitude), &enu);
+            base_sky_batch_set(&base_sched_batch, slot, &enu);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        struct base_sched_display *display = &displays[i];
+        int n = base_sched_rank(display, now_ms, best);
+        size_t budget = base_sched_refill(display, now_ms);
+
+        for (int j = 0; j < n; j++) {
+            struct base_aircraft *aircraft = base_aircraft_at(best[j].slot);
+            struct base_sched_slot *state = &display->slots[best[j].slot];
+
+            int ret = send(i, aircraft, budget, user_data);
+            if (ret < 0) {
+                LOG_DBG("Display %d: stopped at %d of %d (err %d)", i, j, n,
+                        ret);
+                break;
+            }
+
+            state->revision = aircraft->revision;
+            state->sent_ms = now_ms;
+            sent++;
+
+            if (display->budget) {
+                display->tokens -= ret;
+                budget = display->tokens;
+            }
+        }
+    }
+
+    return sent;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file base_sched.h
+ *
+ * @brief Chooses which aircraft each M5 display is sent.
+ *
+ * Rather than forwarding every update as it arrives, the base runs the
+ * scheduler every CONFIG_BASE_SCHED_PERIOD_MS. For each display it ranks the
+ * tracked aircraft predicted to be in the display's patch of sky that have
+ * changed since the display was last sent them, or are due a refresh.
+ * Aircraft nearer the boresight rank higher, as do those the display has not
+ * been sent for longer. Up to CONFIG_BASE_SCHED_TOP_K of the best are then sent, in order,
+ * while the display's bytes-per-second budget allows.
+ *
+ * An aircraft enters a patch within its aperture, but only leaves it beyond
+ * the aperture plus CONFIG_BASE_SCHED_HYSTERESIS_DEG, so aircraft at the
+ * edge don't flicker in and out as the WSU jitters.
+ */
+
+#ifndef BASE_SCHED_H_
+#define BASE_SCHED_H_
+
+#include <zephyr/kernel.h>
+
+#include "base_aircraft.h"
+#include "base_geo.h"
+#include "base_sky.h"
+
+/**
+ * @brief What a display was last sent of the aircraft in one table slot.
+ */
+struct base_sched_slot {
+    uint32_t icao;      /* Aircraft the rest refers to, 0 for none */
+    uint32_t revision;  /* Revision last sent, 0 never */
+    uint32_t sent_ms;   /* Uptime last sent */
+    bool in_view;       /* Within the patch, with hysteresis */
+};
+
+/**
+ * @brief Scheduler state for one display.
+ */
+struct base_sched_display {
+    struct base_sky_patch enter;  /* Aperture */
+    struct base_sky_patch leave;  /* Aperture plus the hysteresis */
+    uint32_t budget;              /* Bytes per second, 0 for unlimited */
+    int32_t tokens;               /* Bytes that can be sent now */
+    uint32_t refilled_ms;
+    struct base_sched_slot slots[CONFIG_BASE_AIRCRAFT_TABLE_SIZE];
+};
+
+/**
+ * @brief Sends an aircraft to a display.
+ *
+ * @param display Index of the display in the array passed to
+ *                base_sched_run().
+ * @param aircraft Aircraft to send.
+ * @param budget Bytes the display can be sent now.
+ * @param user_data As passed to base_sched_run().
+ * @return Bytes sent. -ENOSPC if the message would exceed @p budget, or
+ *         another negative errno if nothing more can be sent to the display
+ *         this period.
+ */
+typedef int (*base_sched_send_t)(int display,
+                                 const struct base_aircraft *aircraft,
+                                 size_t budget, void *user_data);
+
+/**
+ * @brief Initialises a display's scheduler state.
+ *
+ * @param display Display to initialise.
+ * @param budget Bytes per second the display can be sent, 0 for unlimited.
+ * @param now_ms Current uptime in milliseconds.
+ */
+extern void base_sched_init(struct base_sched_display *display,
+                            uint32_t budget, uint32_t now_ms);
+
+/**
+ * @brief Points a display's patch of sky.
+ *
+ * @see base_sky_patch_set()
+ */
+extern void base_sched_point(struct base_sched_display *display, float yaw,
+                             float pitch, float aperture, float max_range);
+
+/**
+ * @brief Sends each display the best of the aircraft in its patch.
+ *
+ * @param displays Displays to schedule.
+ * @param count Number of displays.
+ * @param frame Observer's frame, valid.
+ * @param now_ms Current uptime in milliseconds.
+ * @param send Called for each aircraft chosen, best first.
+ * @param user_data Passed to @p send.
+ * @return Number of aircraft sent, over all displays.
+ */
+extern int base_sched_run(struct base_sched_display *displays, int count,
+                          const struct base_geo_frame *frame, uint32_t now_ms,
+                          base_sched_send_t send, void *user_data);
+
+#endif // BASE_SCHED_H_
@@ -0,0 +1,139 @@
+#include <math.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+
+#ifdef CONFIG_BASE_SKY_CMSIS_DSP
+#include <arm_math.h>
+#endif
+
+#include "base_sky.h"
+
+#define PI 3.14159265358979323846f
+
+// Convert degrees to radians
+static inline float degrees_to_radians(float degrees)
+{
+    return degrees * PI / 180.0f;
+}
+
+extern void base_sky_patch_set(struct base_sky_patch *patch, float yaw,
+                               float pitch, float aperture, float max_range)
+{
+    float psi = degrees_to_radians(yaw);
+    float theta = degrees_to_radians(pitch);
+
+    patch->boresight.east = sinf(psi) * cosf(theta);
+    patch->boresight.north = cosf(psi) * cosf(theta);
+    patch->boresight.up = sinf(theta);
+
+    patch->cos_aperture = cosf(degrees_to_radians(aperture));
+    patch->cos2_aperture = patch->cos_aperture * patch->cos_aperture;
+    /* No limit is an infinite range, so every test is the same compare */
+    patch->max_range2 = max_range > 0 ? max_range * max_range : INFINITY;
+}
+
+extern bool base_sky_patch_contains(const struct base_sky_patch *patch,
+                                    const struct base_geo_enu *enu)
+{
+    if (IS_ENABLED(CONFIG_BASE_SKY_HORIZON) && enu->up < 0) {
+        return false;
+    }
+
+    float range2 = enu->east * enu->east + enu->north * enu->north +
+                   enu->up * enu->up;
+    if (range2 > patch->max_range2) {
+        return false;
+    }
+
+    /* Within the aperture when dot / range >= cos(aperture), squared to
+     * avoid the square root, so the sign of each side decides first */
+    float dot = enu->east * patch->boresight.east +
+                enu->north * patch->boresight.north +
+                enu->up * patch->boresight.up;
+    if (patch->cos_aperture >= 0) {
+        return dot >= 0 && dot * dot >= patch->cos2_aperture * range2;
+    }
+    return dot >= 0 || dot * dot <= patch->cos2_aperture * range2;
+}
+
+extern float base_sky_patch_cos(const struct base_sky_patch *patch,
+                                const struct base_geo_enu *enu)
+{
+    float range = sqrtf(enu->east * enu->east + enu->north * enu->north +
+                        enu->up * enu->up);
+    float dot = enu->east * patch->boresight.east +
+                enu->north * patch->boresight.north +
+                enu->up * patch->boresight.up;
+
+    return range > 0 ? dot / range : 1.0f;
+}
+
+extern void base_sky_batch_clear(struct base_sky_batch *batch)
+{
+    memset(batch, 0, sizeof(*batch));
+}
+
+extern void base_sky_batch_set(struct base_sky_batch *batch, int slot,
+                               const struct base_geo_enu *enu)
+{
+    float range2 = enu->east * enu->east + enu->north * enu->north +
+                   enu->up * enu->up;
+    float scale = range2 > 0 ? 1.0f / sqrtf(range2) : 0.0f;
+
+    batch->east[slot] = enu->east * scale;
+    batch->north[slot] = enu->north * scale;
+    batch->up[slot] = enu->up * scale;
+    batch->range2[slot] = range2;
+    batch->present[slot / 32] |= BIT(slot % 32);
+}
+
+#ifdef CONFIG_BASE_SKY_CMSIS_DSP
+/* Partial dot products, only used from base_sky_batch_cos() */
+static float32_t base_sky_scratch[BASE_SKY_BATCH_SIZE];
+
+extern void base_sky_batch_cos(const struct base_sky_patch *patch,
+                               const struct base_sky_batch *batch, float *cos)
+{
+    arm_scale_f32(batch->east, patch->boresight.east, cos,
+                  BASE_SKY_BATCH_SIZE);
+    arm_scale_f32(batch->north, patch->boresight.north, base_sky_scratch,
+                  BASE_SKY_BATCH_SIZE);
+    arm_add_f32(cos, base_sky_scratch, cos, BASE_SKY_BATCH_SIZE);
+    arm_scale_f32(batch->up, patch->boresight.up, base_sky_scratch,
+                  BASE_SKY_BATCH_SIZE);
+    arm_add_f32(cos, base_sky_scratch, cos, BASE_SKY_BATCH_SIZE);
+}
+#else
+extern void base_sky_batch_cos(const struct base_sky_patch *patch,
+                               const struct base_sky_batch *batch, float *cos)
+{
+    const float east = patch->boresight.east;
+    const float north = patch->boresight.north;
+    const float up = patch->boresight.up;
+
+    for (int i = 0; i < BASE_SKY_BATCH_SIZE; i++) {
+        cos[i] = batch->east[i] * east + batch->north[i] * north +
+                 batch->up[i] * up;
+    }
+}
+#endif
+
+extern void base_sky_batch_mask(const struct base_sky_patch *patch,
+                                const struct base_sky_batch *batch,
+                                const float *cos, uint32_t *mask)
+{
+    for (int word = 0; word < BASE_SKY_MASK_WORDS; word++) {
+        uint32_t bits = 0;
+        int base = word * 32;
+
+        for (int bit = 0; bit < MIN(32, BASE_SKY_BATCH_SIZE - base); bit++) {
+            int i = base + bit;
+            bool in = cos[i] >= patch->cos_aperture &&
+                      batch->range2[i] <= patch->max_range2 &&
+                      (!IS_ENABLED(CONFIG_BASE_SKY_HORIZON) ||
+                       batch->up[i] >= 0);
+            bits |= (uint32_t)in << bit;
+        }
+        mask[word] = bits & batch->present[word];
+    }
+}
@@ -0,0 +1,148 @@
+/**
+ * @file base_sky.h
+ *
+ * @brief Patch of sky a display is pointed at.
+ *
+ * A patch is a cone around the boresight given by the WSU's yaw and pitch,
+ * optionally cut off at a maximum slant range and at the observer's horizon.
+ * Setting a patch costs a few sines and cosines; testing an aircraft's
+ * position in the observer's East-North-Up frame against it is a dot
+ * product and a few compares, with no square roots or trigonometry.
+ *
+ * When the WSU turns, every tracked aircraft has to be tested against the
+ * new patch. The batch functions do this for the whole table at once, over
+ * a struct-of-arrays copy of the positions indexed by table slot. The
+ * positions are reduced to unit vectors once, so each patch then costs
+ * three multiply-adds and a few compares per slot, with no branches in the
+ * dot products. With CONFIG_BASE_SKY_CMSIS_DSP the dot products use
+ * CMSIS-DSP's vector functions, otherwise a portable loop.
+ */
+
+#ifndef BASE_SKY_H_
+#define BASE_SKY_H_
+
+#include <zephyr/kernel.h>
+
+#include "base_geo.h"
+
+/**
+ * @brief Cone of sky around a boresight.
+ */
+struct base_sky_patch {
+    struct base_geo_enu boresight;  /* Unit vector */
+    float cos_aperture;
+    float cos2_aperture;
+    float max_range2;               /* Metres squared, INFINITY for no limit */
+};
+
+/** Slots in a batch, one per aircraft table slot */
+#define BASE_SKY_BATCH_SIZE CONFIG_BASE_AIRCRAFT_TABLE_SIZE
+
+/** Words in a batch mask, one bit per slot */
+#define BASE_SKY_MASK_WORDS DIV_ROUND_UP(BASE_SKY_BATCH_SIZE, 32)
+
+/**
+ * @brief Positions of the tracked aircraft as separate arrays, by slot.
+ */
+struct base_sky_batch {
+    float east[BASE_SKY_BATCH_SIZE];   /* Unit vector to each aircraft */
+    float north[BASE_SKY_BATCH_SIZE];
+    float up[BASE_SKY_BATCH_SIZE];
+    float range2[BASE_SKY_BATCH_SIZE]; /* Metres squared */
+    uint32_t present[BASE_SKY_MASK_WORDS];
+};
+
+/**
+ * @brief Points a patch.
+ *
+ * @param patch Patch to set.
+ * @param yaw Boresight azimuth, degrees clockwise from north.
+ * @param pitch Boresight elevation, degrees above the horizon.
+ * @param aperture Cone half-angle, degrees (0, 180].
+ * @param max_range Furthest slant range, metres. 0 means no limit: every
+ *                  range is within the patch, for base_sky_patch_contains()
+ *                  and the batch mask alike.
+ */
+extern void base_sky_patch_set(struct base_sky_patch *patch, float yaw,
+                               float pitch, float aperture, float max_range);
+
+/**
+ * @brief Checks whether a position falls within a patch.
+ *
+ * With CONFIG_BASE_SKY_HORIZON, positions below the observer's horizon are
+ * never within it.
+ *
+ * @param patch Patch to test against.
+ * @param enu Position in the observer's frame.
+ */
+extern bool base_sky_patch_contains(const struct base_sky_patch *patch,
+                                    const struct base_geo_enu *enu);
+
+/**
+ * @brief Cosine of the angle between a position and a patch's boresight.
+ *
+ * Ranks positions by how close they are to where the display is pointed;
+ * costs a square root.
+ *
+ * @param patch Patch to measure from.
+ * @param enu Position in the observer's frame.
+ * @return The cosine, 1 on the boresight, -1 straight behind it.
+ */
+extern float base_sky_patch_cos(const struct base_sky_patch *patch,
+                                const struct base_geo_enu *enu);
+
+/**
+ * @brief Empties a batch.
+ *
+ * @param batch Batch to empty.
+ */
+extern void base_sky_batch_clear(struct base_sky_batch *batch);
+
+/**
+ * @brief Adds an aircraft's position to a batch.
+ *
+ * @param batch Batch to add to.
+ * @param slot Slot, less than BASE_SKY_BATCH_SIZE.
+ * @param enu Position in the observer's frame.
+ */
+extern void base_sky_batch_set(struct base_sky_batch *batch, int slot,
+                               const struct base_geo_enu *enu);
+
+/**
+ * @brief Cosine of the angle off a patch's boresight of every slot.
+ *
+ * As base_sky_patch_cos() for each slot. Empty slots, and an aircraft at the
+ * observer, give 0. Not reentrant with CONFIG_BASE_SKY_CMSIS_DSP.
+ *
+ * @param patch Patch to measure from.
+ * @param batch Positions to measure.
+ * @param cos Receives BASE_SKY_BATCH_SIZE cosines.
+ */
+extern void base_sky_batch_cos(const struct base_sky_patch *patch,
+                               const struct base_sky_batch *batch, float *cos);
+
+/**
+ * @brief Marks the aircraft in a batch that fall within a patch.
+ *
+ * As base_sky_patch_contains() for each present slot.
+ *
+ * @param patch Patch to test against.
+ * @param batch Positions to test.
+ * @param cos Cosines from base_sky_batch_cos() for a patch with the same
+ *            boresight.
+ * @param mask Receives BASE_SKY_MASK_WORDS words, a bit set for each slot
+ *             within the patch.
+ */
+extern void base_sky_batch_mask(const struct base_sky_patch *patch,
+                                const struct base_sky_batch *batch,
+                                const float *cos, uint32_t *mask);
+
+/**
+ * @brief Checks a slot's bit in a batch mask.
+ */
+static inline bool base_sky_mask_test(const uint32_t *mask, int slot)
+{
+    return mask[slot / 32] & BIT(slot % 32);
+}
+
+#endif // BASE_SKY_H_
@@ -3,13 +3,16 @@
 
 #include <zephyr/kernel.h>
 
-/* Set the number of endpoints */
-#define DLT_NUM_ENDPOINTS 2 
+/* Set the number of endpoints, one per M5 display after the Pi */
+#define DLT_NUM_ENDPOINTS (M5_NUS + CONFIG_DLT_NUS_MAX_DISPLAYS)
 
 /* Define your endpoints*/
 enum dlt_endpoints {
     PI_UART = 0,
-    M5_NUS = 1,
+    M5_NUS = 1,  /* First M5 display, the rest follow */
 };
 
+/* Endpoint of the nth M5 display */
+#define M5_NUS_EP(n) (M5_NUS + (n))
+
 #endif // DLT_ENDPOINTS_H_
\ No newline at end of file
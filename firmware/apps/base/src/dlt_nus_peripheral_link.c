@@ -2,10 +2,15 @@
 #include <zephyr/device.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
 #include <zephyr/bluetooth/services/nus.h>
 
 #include "dlt_api.h"
+#include "dlt_ble.h"
 #include "dlt_endpoints.h"
+#include "dlt_nus_peripheral_link.h"
+#include "dlt_parser.h"
 
 /* Thread parameters */
 #define DLT_NUS_STACKSIZE 2048
@@ -15,8 +20,59 @@
 #define DEVICE_NAME		CONFIG_BT_DEVICE_NAME
 #define DEVICE_NAME_LEN		(sizeof(DEVICE_NAME) - 1)
 
+/* ATT opcode and handle in front of each notification payload */
+#define BT_ATT_NOTIFY_OVERHEAD	3
+
+/* Advertise every 30-60 ms so a display that lost its link finds the base
+ * within a few tens of milliseconds */
+#define DLT_NUS_ADV_PARAM BT_LE_ADV_PARAM(BT_LE_ADV_OPT_CONNECTABLE, \
+					  BT_GAP_ADV_FAST_INT_MIN_1, \
+					  BT_GAP_ADV_FAST_INT_MAX_1, NULL)
+
 LOG_MODULE_REGISTER(dlt_nus_link, LOG_LEVEL_ERR);
 
+BUILD_ASSERT(DLT_NUM_ENDPOINTS <= DLT_MAX_ENDPOINTS,
+             "CONFIG_DLT_MAX_ENDPOINTS must cover every M5 display");
+
+/*
+ * One connected M5 display. Each has its own DLT endpoint, so its own queue
+ * and flow control, and its own window of notifications in flight: a
+ * display that falls behind only stops taking packets from its own queue,
+ * which coalesces while the others keep going.
+ */
+struct dlt_nus_display {
+    /* NULL while the slot is free. Set and cleared under dlt_nus_lock. */
+    struct bt_conn *conn;
+    uint8_t ep;
+
+    /* Packets sent as notifications but not yet on air, oldest first.
+     * Guarded by dlt_nus_lock. */
+    struct dlt_buf *inflight[CONFIG_DLT_NUS_TX_INFLIGHT];
+    uint8_t inflight_head;
+    uint8_t inflight_count;
+
+    /* Frames the display writes to the NUS RX characteristic */
+    struct dlt_parser parser;
+    uint32_t rx_dropped;
+
+#ifdef CONFIG_DLT_BLE
+    struct dlt_ble_link ble;  /* Connection profile */
+#endif
+};
+
+static struct dlt_nus_display dlt_nus_displays[CONFIG_DLT_NUS_MAX_DISPLAYS];
+static struct k_spinlock dlt_nus_lock;
+
+/* Raised when a notification slot frees up or a display comes or goes */
+static struct k_poll_signal dlt_nus_signal =
+    K_POLL_SIGNAL_INITIALIZER(dlt_nus_signal);
+
+/* NUS TX characteristic value notifications are sent from */
+static const struct bt_gatt_attr *dlt_nus_tx_attr;
+
+/* Restarts advertising once a display slot frees up */
+static struct k_work dlt_nus_adv_work;
+
 static const struct bt_data ad[] = {
 	BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
 	BT_DATA(BT_DATA_NAME_COMPLETE, DEVICE_NAME, DEVICE_NAME_LEN),
@@ -26,22 +82,48 @@ static const struct bt_data sd[] = {
 	BT_DATA_BYTES(BT_DATA_UUID128_ALL, BT_UUID_NUS_SRV_VAL),
 };
 
+/* Find the display on a connection, NULL for other connections */
+static struct dlt_nus_display *dlt_nus_display_get(struct bt_conn *conn)
+{
+    for (int i = 0; i < CONFIG_DLT_NUS_MAX_DISPLAYS; i++) {
+        if (dlt_nus_displays[i].conn == conn) {
+            return &dlt_nus_displays[i];
+        }
+    }
+    return NULL;
+}
+
 static void notif_enabled(bool enabled, void *ctx)
 {
 	ARG_UNUSED(ctx);
 
+	/* Subscriptions are checked per connection when sending */
 	LOG_INF("%s() - %s\n", __func__, (enabled ? "Enabled" : "Disabled"));
 }
 
+/*
+ * A write holds one or more whole DLT frames, submitted to the display's
+ * endpoint like the M5 does with notifications. Routes pass them on from
+ * there.
+ */
 static void received(struct bt_conn *conn, const void *data, uint16_t len, void *ctx)
 {
-	char message[CONFIG_BT_L2CAP_TX_MTU + 1] = "";
+	struct dlt_nus_display *display = dlt_nus_display_get(conn);
 
-	ARG_UNUSED(conn);
 	ARG_UNUSED(ctx);
 
-	memcpy(message, data, MIN(sizeof(message) - 1, len));
-	LOG_INF("%s() - Len: %d, Message: %s\n", __func__, len, message);
+	if (!display) {
+		return;
+	}
+
+	size_t used = dlt_parser_feed(&display->parser, data, len);
+	if (used < len || dlt_parser_busy(&display->parser)) {
+		dlt_parser_reset(&display->parser);
+		display->rx_dropped += len - used;
+		LOG_WRN("Dropped %u bytes from endpoint %u (%u total)\n",
+			(unsigned int)(len - used), display->ep,
+			display->rx_dropped);
+	}
 }
 
 struct bt_nus_cb nus_listener = {
@@ -49,6 +131,282 @@ struct bt_nus_cb nus_listener = {
 	.received = received,
 };
 
+/* Fragment DLT packets to fit the display's negotiated ATT MTU */
+static void mtu_updated(struct bt_conn *conn, uint16_t tx, uint16_t rx)
+{
+	struct dlt_nus_display *display = dlt_nus_display_get(conn);
+
+	LOG_INF("ATT MTU updated - TX: %d, RX: %d\n", tx, rx);
+	if (display) {
+		dlt_link_set_mtu(display->ep, MIN(tx, rx) - BT_ATT_NOTIFY_OVERHEAD);
+	}
+}
+
+static struct bt_gatt_cb gatt_callbacks = {
+	.att_mtu_updated = mtu_updated,
+};
+
+/*
+ * Release a display's oldest in-flight packets and their notification
+ * slots. Notifications on a connection go on air in order. The packets are
+ * completed outside the lock, as their callbacks may do anything.
+ */
+static void dlt_nus_release(struct dlt_nus_display *display, uint8_t count,
+                            int status)
+{
+    struct dlt_buf *sent[CONFIG_DLT_NUS_TX_INFLIGHT];
+    k_spinlock_key_t key = k_spin_lock(&dlt_nus_lock);
+
+    count = MIN(count, display->inflight_count);
+    for (uint8_t i = 0; i < count; i++) {
+        sent[i] = display->inflight[display->inflight_head];
+        display->inflight_head = (display->inflight_head + 1) %
+                                 CONFIG_DLT_NUS_TX_INFLIGHT;
+        display->inflight_count--;
+    }
+    k_spin_unlock(&dlt_nus_lock, key);
+
+    for (uint8_t i = 0; i < count; i++) {
+        dlt_buf_complete(sent[i], status);
+    }
+    k_poll_signal_raise(&dlt_nus_signal, 0);
+}
+
+/* A notification went on air, so the link is done with its packet */
+static void dlt_nus_sent(struct bt_conn *conn, void *user_data)
+{
+    struct dlt_nus_display *display = dlt_nus_display_get(conn);
+
+    ARG_UNUSED(user_data);
+
+    if (display) {
+        dlt_nus_release(display, 1, 0);
+    }
+}
+
+/* Whether a display has a free notification slot */
+static bool dlt_nus_can_send(struct dlt_nus_display *display)
+{
+    k_spinlock_key_t key = k_spin_lock(&dlt_nus_lock);
+    bool ret = display->conn &&
+               display->inflight_count < CONFIG_DLT_NUS_TX_INFLIGHT;
+
+    k_spin_unlock(&dlt_nus_lock, key);
+    return ret;
+}
+
+/*
+ * Take a reference to a display's connection, so a disconnect can't free it
+ * while in use. NULL while the display is not connected.
+ */
+static struct bt_conn *dlt_nus_conn_get(struct dlt_nus_display *display)
+{
+    k_spinlock_key_t key = k_spin_lock(&dlt_nus_lock);
+    struct bt_conn *conn = display->conn ? bt_conn_ref(display->conn) : NULL;
+
+    k_spin_unlock(&dlt_nus_lock, key);
+    return conn;
+}
+
+/* Whether a display's connection takes notifications */
+static bool dlt_nus_subscribed(struct dlt_nus_display *display)
+{
+    struct bt_conn *conn = dlt_nus_conn_get(display);
+
+    if (!conn) {
+        return false;
+    }
+
+    bool ret = bt_gatt_is_subscribed(conn, dlt_nus_tx_attr, BT_GATT_CCC_NOTIFY);
+
+    bt_conn_unref(conn);
+    return ret;
+}
+
+/* Notify a display of a packet, keeping it in flight until it is sent */
+static int dlt_nus_send(struct dlt_nus_display *display, struct dlt_buf *buf)
+{
+    struct bt_gatt_notify_params params = {
+        .attr = dlt_nus_tx_attr,
+        .data = buf->packet,
+        .len = buf->len,
+        .func = dlt_nus_sent,
+    };
+
+    struct bt_conn *conn = dlt_nus_conn_get(display);
+    if (!conn) {
+        return -ENOTCONN;
+    }
+    if (!bt_gatt_is_subscribed(conn, dlt_nus_tx_attr, BT_GATT_CCC_NOTIFY)) {
+        bt_conn_unref(conn);
+        return -ENOTCONN;
+    }
+
+    /* Track the packet first, the callback can run before the call returns */
+    k_spinlock_key_t key = k_spin_lock(&dlt_nus_lock);
+    display->inflight[(display->inflight_head + display->inflight_count) %
+                      CONFIG_DLT_NUS_TX_INFLIGHT] = buf;
+    display->inflight_count++;
+    k_spin_unlock(&dlt_nus_lock, key);
+
+    int err = bt_gatt_notify_cb(conn, &params);
+    if (err) {
+        /* Nothing newer is in flight, as only this thread sends, but a
+         * disconnect may have released the packet already */
+        key = k_spin_lock(&dlt_nus_lock);
+        uint8_t newest = (display->inflight_head + display->inflight_count +
+                          CONFIG_DLT_NUS_TX_INFLIGHT - 1) %
+                         CONFIG_DLT_NUS_TX_INFLIGHT;
+        if (display->inflight_count && display->inflight[newest] == buf) {
+            display->inflight_count--;
+        } else {
+            err = 0;
+        }
+        k_spin_unlock(&dlt_nus_lock, key);
+    }
+    bt_conn_unref(conn);
+    return err;
+}
+
+extern bool dlt_nus_display_ready(uint8_t ep)
+{
+    if (ep < M5_NUS || ep >= M5_NUS_EP(CONFIG_DLT_NUS_MAX_DISPLAYS)) {
+        return false;
+    }
+
+    return dlt_nus_subscribed(&dlt_nus_displays[ep - M5_NUS]);
+}
+
+/* Keep advertising while there are free display slots */
+static void dlt_nus_adv_restart(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	if (!dlt_nus_display_get(NULL)) {
+		return;
+	}
+
+	int err = bt_le_adv_start(DLT_NUS_ADV_PARAM, ad, ARRAY_SIZE(ad), sd,
+				  ARRAY_SIZE(sd));
+	if (err && err != -EALREADY) {
+		LOG_ERR("Failed to restart advertising: %d\n", err);
+	}
+}
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+	struct bt_conn_info info;
+
+	/* Only M5 displays connect to the base, the WSU is its peripheral */
+	if (err || bt_conn_get_info(conn, &info) ||
+	    info.role != BT_CONN_ROLE_PERIPHERAL) {
+		return;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&dlt_nus_lock);
+	struct dlt_nus_display *display = dlt_nus_display_get(NULL);
+	if (display) {
+		display->conn = bt_conn_ref(conn);
+	}
+	k_spin_unlock(&dlt_nus_lock, key);
+
+	if (!display) {
+		LOG_WRN("No free display slot, disconnecting\n");
+		bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+		return;
+	}
+
+	/* The slot may have served a display with a larger MTU, packets must
+	 * fit the default until this one's exchange completes */
+	LOG_INF("Display on endpoint %u connected\n", display->ep);
+	dlt_link_set_mtu(display->ep,
+			 BT_ATT_DEFAULT_LE_MTU - BT_ATT_NOTIFY_OVERHEAD);
+	k_poll_signal_raise(&dlt_nus_signal, 0);
+
+#ifdef CONFIG_DLT_BLE
+	/* Ask for low latency, the M5 and controllers settle the rest */
+	(void)dlt_ble_connected(&display->ble, conn);
+#endif
+
+	k_work_submit(&dlt_nus_adv_work);
+}
+
+/* Notifications still queued are never sent, release their packets */
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+	struct dlt_nus_display *display = dlt_nus_display_get(conn);
+
+	if (!display) {
+		return;
+	}
+
+	LOG_INF("Display on endpoint %u disconnected (reason 0x%02x)\n",
+		display->ep, reason);
+	k_spinlock_key_t key = k_spin_lock(&dlt_nus_lock);
+	display->conn = NULL;
+	k_spin_unlock(&dlt_nus_lock, key);
+	bt_conn_unref(conn);
+	dlt_nus_release(display, CONFIG_DLT_NUS_TX_INFLIGHT, -ENOTCONN);
+#ifdef CONFIG_DLT_BLE
+	dlt_ble_disconnected(&display->ble, reason);
+#endif
+
+	k_work_submit(&dlt_nus_adv_work);
+}
+
+#ifdef CONFIG_DLT_BLE
+/* Report the parameters each display's link settled on to DLT statistics */
+static void param_updated(struct bt_conn *conn, uint16_t interval,
+			  uint16_t latency, uint16_t timeout)
+{
+	struct dlt_nus_display *display = dlt_nus_display_get(conn);
+
+	LOG_INF("Connection interval %u, latency %u\n", interval, latency);
+	if (display) {
+		dlt_ble_updated(&display->ble, conn);
+	}
+}
+
+#ifdef CONFIG_BT_USER_PHY_UPDATE
+static void phy_updated(struct bt_conn *conn, struct bt_conn_le_phy_info *info)
+{
+	struct dlt_nus_display *display = dlt_nus_display_get(conn);
+
+	LOG_INF("PHY updated - TX: %u, RX: %u\n", info->tx_phy, info->rx_phy);
+	if (display) {
+		dlt_ble_updated(&display->ble, conn);
+	}
+}
+#endif
+
+#ifdef CONFIG_BT_USER_DATA_LEN_UPDATE
+static void data_len_updated(struct bt_conn *conn,
+			     struct bt_conn_le_data_len_info *info)
+{
+	struct dlt_nus_display *display = dlt_nus_display_get(conn);
+
+	LOG_INF("Data length updated - TX: %u\n", info->tx_max_len);
+	if (display) {
+		dlt_ble_updated(&display->ble, conn);
+	}
+}
+#endif
+#endif
+
+BT_CONN_CB_DEFINE(dlt_nus_conn_callbacks) = {
+	.connected = connected,
+	.disconnected = disconnected,
+#ifdef CONFIG_DLT_BLE
+	.le_param_updated = param_updated,
+#ifdef CONFIG_BT_USER_PHY_UPDATE
+	.le_phy_updated = phy_updated,
+#endif
+#ifdef CONFIG_BT_USER_DATA_LEN_UPDATE
+	.le_data_len_updated = data_len_updated,
+#endif
+#endif
+};
+
 /* Initialise the NUS Link */
 static bool dlt_nus_peripheral_init()
 {
@@ -58,13 +416,31 @@ static bool dlt_nus_peripheral_init()
 		return false;
 	}
 
+	bt_gatt_cb_register(&gatt_callbacks);
+
+	for (int i = 0; i < CONFIG_DLT_NUS_MAX_DISPLAYS; i++) {
+		dlt_nus_displays[i].ep = M5_NUS_EP(i);
+		dlt_parser_init(&dlt_nus_displays[i].parser, M5_NUS_EP(i));
+#ifdef CONFIG_DLT_BLE
+		dlt_ble_link_init(&dlt_nus_displays[i].ble, M5_NUS_EP(i));
+#endif
+	}
+	k_work_init(&dlt_nus_adv_work, dlt_nus_adv_restart);
+
+	dlt_nus_tx_attr = bt_gatt_find_by_uuid(NULL, 0, BT_UUID_NUS_TX_CHAR);
+	if (!dlt_nus_tx_attr) {
+		LOG_ERR("NUS TX characteristic not found\n");
+		return false;
+	}
+
     err = bt_enable(NULL);
 	if (err) {
 		LOG_ERR("Failed to enable bluetooth: %d\n", err);
 		return false;
 	}
 
-	err = bt_le_adv_start(BT_LE_ADV_CONN, ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
+	err = bt_le_adv_start(DLT_NUS_ADV_PARAM, ad, ARRAY_SIZE(ad), sd,
+			      ARRAY_SIZE(sd));
 	if (err) {
 		LOG_ERR("Failed to start advertising: %d\n", err);
 		return false;
@@ -73,49 +449,97 @@ static bool dlt_nus_peripheral_init()
     return true;
 }
 
+/*
+ * Send the next packet queued for a display, or drop what is queued for a
+ * display that is not connected
+ */
+static void dlt_nus_service(struct dlt_nus_display *display)
+{
+    struct dlt_buf *buf;
+
+    if (!display->conn) {
+        while ((buf = dlt_poll_buf(display->ep, K_NO_WAIT)) != NULL) {
+            dlt_buf_complete(buf, -ENOTCONN);
+        }
+        return;
+    }
+
+    /* Queued packets come out aggregated into one notification */
+    buf = dlt_poll_buf(display->ep, K_NO_WAIT);
+    if (!buf) {
+        return;
+    }
+
+    int err = dlt_nus_send(display, buf);
+    if (err) {
+        LOG_INF("Data send - Result: %d\n", err);
+        dlt_buf_complete(buf, err);
+    }
+}
+
 /**
  * Thread function for DLT Communication.
- * 
- * @brief Periodically polls the DLT interface for packets to transmit and 
- *        forwards any received packets.
+ *
+ * @brief Sleeps until a display with a free notification slot has packets
+ *        queued, and sends them to it. Up to CONFIG_DLT_NUS_TX_INFLIGHT
+ *        notifications per display are in flight at once, so several go
+ *        out each connection interval, and a display whose window is full
+ *        is left out of the wait so it never holds up the others.
  */
 void dlt_nus_peripheral_thread(void) {
     /* Initialise the UART peripheral and register Link with DLT driver */
     k_tid_t link_tid = k_current_get();
     dlt_nus_peripheral_init();
-    dlt_link_register(M5_NUS, link_tid);
+    for (int i = 0; i < CONFIG_DLT_NUS_MAX_DISPLAYS; i++) {
+        dlt_link_register(M5_NUS_EP(i), link_tid);
+    }
 
 	LOG_INF("Initialization complete\n");
-    int err = 0;
-
-    uint8_t dlt_recv_buf[DLT_MAX_PACKET_LEN] = {0};
 
     /* Sleep to let the main thread setup DLT */
     k_sleep(K_MSEC(100));
 
+    /* Pack bursts of packets into as few notifications as possible. All
+     * displays share this thread, so only packets already queued are
+     * packed rather than holding the others up for the window. */
+#ifdef CONFIG_DLT_AGGREGATION
+    for (int i = 0; i < CONFIG_DLT_NUS_MAX_DISPLAYS; i++) {
+        dlt_link_set_aggregation(M5_NUS_EP(i), true);
+        dlt_link_set_aggregation_window(M5_NUS_EP(i), 0);
+    }
+#endif
+
+    struct k_poll_event events[CONFIG_DLT_NUS_MAX_DISPLAYS + 1];
+    struct dlt_nus_display *polled[CONFIG_DLT_NUS_MAX_DISPLAYS];
+
 	while (true) {
-        /* Poll DLT Interface for packets to transmit */
-        uint8_t msg_len = dlt_poll(M5_NUS, dlt_recv_buf, 50, K_MSEC(5));
-        if (msg_len) {
-            LOG_INF("DLT mail received.");
-
-            /* Transmit the DLT packet via UART */
-            LOG_INF("Transmitting DLT packet.");
-            // for (int i = 0; i < msg_len; i++) {
-            //     LOG_INF("  packet[%i]: %" PRIx8, i, dlt_recv_buf[i]);
-            // }
-            err = bt_nus_send(NULL, dlt_recv_buf, msg_len);
-            LOG_INF("Data send - Result: %d\n", err);
-            if (err < 0 && (err != -EAGAIN) && (err != -ENOTCONN)) {
-                LOG_ERR("Unknown error. Aborting.");
-                return;
+        /* Wait on the displays that can take a notification, and on slots
+         * freeing up or displays coming and going */
+        int n = 0;
+        for (int i = 0; i < CONFIG_DLT_NUS_MAX_DISPLAYS; i++) {
+            struct dlt_nus_display *display = &dlt_nus_displays[i];
+
+            if (!display->conn) {
+                dlt_nus_service(display);
+            } else if (dlt_nus_can_send(display)) {
+                dlt_poll_event_init(display->ep, &events[n]);
+                polled[n++] = display;
             }
         }
-        k_sleep(K_MSEC(5));
-	}
+        k_poll_event_init(&events[n], K_POLL_TYPE_SIGNAL,
+                          K_POLL_MODE_NOTIFY_ONLY, &dlt_nus_signal);
 
+        k_poll(events, n + 1, K_FOREVER);
+        k_poll_signal_reset(&dlt_nus_signal);
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].state != K_POLL_STATE_NOT_READY) {
+                dlt_nus_service(polled[i]);
+            }
+        }
+	}
 }
 
 /* Register the thread */
 K_THREAD_DEFINE(dlt_nus_peripheral, DLT_NUS_STACKSIZE, dlt_nus_peripheral_thread,
-                NULL, NULL, NULL, DLT_NUS_PRIORITY, 0, 0);
\ No newline at end of file
+                NULL, NULL, NULL, DLT_NUS_PRIORITY, 0, 0);
@@ -0,0 +1,17 @@
+#ifndef DLT_NUS_PERIPHERAL_LINK_H_
+#define DLT_NUS_PERIPHERAL_LINK_H_
+
+#include <zephyr/kernel.h>
+
+/**
+ * @brief Checks whether an M5 display is connected and taking notifications.
+ *
+ * Devices only send to displays that are ready; packets queued for a
+ * display that disconnects are dropped.
+ *
+ * @param ep Endpoint identifier of the display, see M5_NUS_EP().
+ * @return true if packets sent to @p ep will be notified.
+ */
+extern bool dlt_nus_display_ready(uint8_t ep);
+
+#endif // DLT_NUS_PERIPHERAL_LINK_H_
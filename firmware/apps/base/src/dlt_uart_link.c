@@ -1,23 +1,97 @@
+#include <string.h>
 #include <zephyr/kernel.h>
 #include <zephyr/device.h>
 #include <zephyr/drivers/uart.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/ring_buffer.h>
 
 #include "dlt_api.h"
 #include "dlt_endpoints.h"
+#include "dlt_parser.h"
 
 /* Thread parameters */
 #define DLT_COMMS_STACKSIZE 1024
 #define DLT_COMMS_PRIORITY  6
 
-/* Timeout for UART DMA */
-#define DLT_UART_RX_TIMEOUT (10 * USEC_PER_MSEC)
+/* Line idle time after which the UART DMA hands over what it has */
+#define DLT_UART_RX_TIMEOUT 200
+
+/* Time to wait for the rest of a frame before dropping it */
+#define DLT_UART_FRAME_TIMEOUT_MS 10
+
+/* Time to wait for a pool buffer before retrying the parser */
+#define DLT_UART_RETRY K_MSEC(5)
+
+/* Time the Pi has to confirm new link settings before falling back */
+#define DLT_UART_CONFIRM_TIMEOUT_MS 500
+
+/* Bytes of noise, with no frame, that make unconfirmed settings fall back */
+#define DLT_UART_NOISE_LIMIT 64
+
+/* Time without a frame that makes confirmed settings fall back. The Pi
+ * sends keepalives well within it while it uses them. */
+#define DLT_UART_KEEPALIVE_TIMEOUT_MS 2000
+
+/* Bytes the UART may still be shifting out once its DMA reports the
+ * transfer done, with margin */
+#define DLT_UART_DRAIN_BYTES 4
+
+/* Interval to check on a link negotiation in progress */
+#define DLT_UART_NEGOTIATE_POLL K_MSEC(1)
 
 LOG_MODULE_REGISTER(dlt_uart_link, LOG_LEVEL_ERR);
 
-/* UART DMA Semaphore for data reception */
+/* Given whenever received bytes are added to the ring buffer */
 K_SEM_DEFINE(dlt_rx_sem, 0, 1);
 
+/* Given when a full transmit queue gets room again */
+K_SEM_DEFINE(dlt_tx_sem, 0, 1);
+
+/* Events the link thread waits on */
+enum dlt_uart_events {
+    DLT_UART_EVT_TX = 0,
+    DLT_UART_EVT_RX,
+    DLT_UART_EVT_COUNT,
+};
+
+/*
+ * Frames waiting for the UART, oldest first. The link thread adds frames and
+ * the UART callback chains each transfer from the completion of the last,
+ * releasing the frames it sent.
+ */
+static struct dlt_buf *dlt_tx_queue[CONFIG_DLT_UART_TX_QUEUE_LEN];
+static uint8_t dlt_tx_head;      /* Oldest frame */
+static uint8_t dlt_tx_count;     /* Frames queued, including those in flight */
+static uint8_t dlt_tx_inflight;  /* Frames in the transfer in flight */
+static struct k_spinlock dlt_tx_lock;
+
+/* Baud rates the Pi can negotiate */
+static const uint32_t dlt_uart_baudrates[] = {
+    115200, 230400, 460800, 921600, 1000000,
+};
+
+/* Settings from devicetree, used at boot and whenever negotiation fails */
+static struct uart_config dlt_uart_fallback;
+static struct uart_config dlt_uart_current;
+
+/* Settings to switch to once the reply accepting them is sent */
+static struct uart_config dlt_uart_next;
+static bool dlt_uart_switching;
+
+/* When the Pi must have confirmed the current settings by, 0 if it has */
+static int64_t dlt_uart_confirm_by;
+
+/* The DMA receives into one buffer while the other is handed over */
+static uint8_t dlt_rx_dma[2][CONFIG_DLT_UART_RX_BUF_SIZE];
+static uint8_t dlt_rx_next;
+
+/* Received bytes waiting to be parsed, filled by the UART callback */
+RING_BUF_DECLARE(dlt_rx_ring, CONFIG_DLT_UART_RX_RING_SIZE);
+
+/* Bytes lost to a full ring buffer */
+static atomic_t dlt_rx_overruns;
+
 /* UART device reference */
 #ifdef CONFIG_SHELL_BACKEND_RTT
 static const struct device *dlt_uart =
@@ -30,6 +104,262 @@ static const struct device *dlt_uart = DEVICE_DT_GET(DT_ALIAS(dlt_uart));
 static void uart_cb(const struct device *dev, struct uart_event *evt,
                     void *user_data);
 
+/* Frame at a position in the transmit queue, 0 for the oldest */
+static inline struct dlt_buf *dlt_uart_tx_at(uint8_t i)
+{
+    return dlt_tx_queue[(dlt_tx_head + i) % CONFIG_DLT_UART_TX_QUEUE_LEN];
+}
+
+/*
+ * Release the frames of the transfer in flight, and tell the link thread if
+ * the queue has room again. The frames are completed outside the lock, as
+ * their callbacks may do anything.
+ */
+static void dlt_uart_tx_release(int status)
+{
+    struct dlt_buf *sent[CONFIG_DLT_UART_TX_QUEUE_LEN];
+    k_spinlock_key_t key = k_spin_lock(&dlt_tx_lock);
+    bool full = dlt_tx_count == CONFIG_DLT_UART_TX_QUEUE_LEN;
+    uint8_t count = dlt_tx_inflight;
+
+    for (uint8_t i = 0; i < count; i++) {
+        sent[i] = dlt_uart_tx_at(i);
+    }
+    dlt_tx_head = (dlt_tx_head + count) % CONFIG_DLT_UART_TX_QUEUE_LEN;
+    dlt_tx_count -= count;
+    dlt_tx_inflight = 0;
+    k_spin_unlock(&dlt_tx_lock, key);
+
+    for (uint8_t i = 0; i < count; i++) {
+        dlt_buf_complete(sent[i], status);
+    }
+    if (full) {
+        k_sem_give(&dlt_tx_sem);
+    }
+}
+
+/*
+ * Start transmitting the oldest queued frames if the UART is idle. Frames
+ * queued behind the first are copied onto its end while they fit, so a run
+ * of small frames goes out as one transfer. The lock only covers claiming
+ * the frames: once they are in flight nothing else touches them, so they
+ * are merged and handed to the UART without it.
+ */
+static void dlt_uart_tx_start(void)
+{
+    while (true) {
+        k_spinlock_key_t key = k_spin_lock(&dlt_tx_lock);
+        if (dlt_tx_inflight || !dlt_tx_count) {
+            k_spin_unlock(&dlt_tx_lock, key);
+            return;
+        }
+
+        struct dlt_buf *buf = dlt_uart_tx_at(0);
+        uint16_t len = buf->len;
+        uint8_t count = 1;
+
+#ifdef CONFIG_DLT_UART_TX_MERGE
+        while (count < dlt_tx_count &&
+               len + dlt_uart_tx_at(count)->len <= sizeof(buf->packet)) {
+            len += dlt_uart_tx_at(count)->len;
+            count++;
+        }
+#endif
+        dlt_tx_inflight = count;
+        k_spin_unlock(&dlt_tx_lock, key);
+
+        for (uint8_t i = 1; i < count; i++) {
+            struct dlt_buf *next = dlt_uart_tx_at(i);
+            memcpy(&buf->packet[buf->len], next->packet, next->len);
+            buf->len += next->len;
+        }
+
+        int ret = uart_tx(dlt_uart, buf->packet, buf->len, SYS_FOREVER_US);
+        if (!ret) {
+            return;
+        }
+        LOG_ERR("DLT UART transmission failed.");
+        dlt_uart_tx_release(ret);
+    }
+}
+
+/*
+ * Add a frame to the transmit queue, starting the UART if it is idle. Only
+ * the link thread adds frames, so a queue it saw room in can't fill first.
+ */
+static void dlt_uart_tx_queue(struct dlt_buf *buf)
+{
+    k_spinlock_key_t key = k_spin_lock(&dlt_tx_lock);
+    dlt_tx_queue[(dlt_tx_head + dlt_tx_count) %
+                 CONFIG_DLT_UART_TX_QUEUE_LEN] = buf;
+    dlt_tx_count++;
+    k_spin_unlock(&dlt_tx_lock, key);
+
+    dlt_uart_tx_start();
+}
+
+/*
+ * Move the frames DLT has for the Pi into the transmit queue. Returns false
+ * if the queue filled up.
+ */
+static bool dlt_uart_tx_fill(void)
+{
+    while (dlt_tx_count < CONFIG_DLT_UART_TX_QUEUE_LEN) {
+        struct dlt_buf *buf = dlt_poll_buf(PI_UART, K_NO_WAIT);
+        if (!buf) {
+            return true;
+        }
+        dlt_uart_tx_queue(buf);
+    }
+    return false;
+}
+
+/*
+ * Apply link settings, keeping the current ones if the UART rejects them.
+ * UART_TX_DONE only means the DMA is done, so the last bytes of a transfer
+ * are given time to leave the line at the current baud rate first.
+ */
+static void dlt_uart_configure(const struct uart_config *cfg)
+{
+    k_usleep(DIV_ROUND_UP(DLT_UART_DRAIN_BYTES * 10 * USEC_PER_SEC,
+                          dlt_uart_current.baudrate));
+
+    int ret = uart_configure(dlt_uart, cfg);
+    if (ret) {
+        LOG_ERR("DLT UART configure failed (%d).", ret);
+        return;
+    }
+    dlt_uart_current = *cfg;
+    LOG_INF("DLT UART at %u baud, flow control %s.", cfg->baudrate,
+            cfg->flow_ctrl == UART_CFG_FLOW_CTRL_RTS_CTS ? "on" : "off");
+}
+
+static bool dlt_uart_baudrate_valid(uint32_t baudrate)
+{
+    ARRAY_FOR_EACH(dlt_uart_baudrates, i) {
+        if (dlt_uart_baudrates[i] == baudrate) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Queue a link control reply carrying a status and link settings */
+static void dlt_uart_link_reply(uint8_t opcode, uint8_t status,
+                                const struct uart_config *cfg)
+{
+    struct dlt_buf *buf;
+
+    if (dlt_tx_count == CONFIG_DLT_UART_TX_QUEUE_LEN ||
+        (buf = dlt_buf_alloc(K_NO_WAIT)) == NULL) {
+        LOG_WRN("No room for DLT link reply.");
+        return;
+    }
+
+    uint8_t *data = dlt_buf_data(buf);
+    data[0] = opcode | DLT_CTRL_REPLY;
+    data[1] = status;
+    sys_put_le32(cfg->baudrate, &data[2]);
+    data[6] = cfg->flow_ctrl == UART_CFG_FLOW_CTRL_RTS_CTS ?
+              DLT_LINK_FLOW_RTS_CTS : 0;
+
+    buf->packet[0] = DLT_PREAMBLE;
+    buf->packet[1] = DLT_CONTROL_CODE;
+    buf->packet[2] = 7;
+    buf->len = DLT_PROTOCOL_BYTES + 7;
+    dlt_uart_tx_queue(buf);
+}
+
+/*
+ * Answer link control packets from the Pi, passing every other frame on.
+ * A configuration request is accepted or rejected at the current settings
+ * and applied once the reply is sent; a confirm request at the new settings
+ * stops them falling back.
+ */
+static bool dlt_uart_link_frame(struct dlt_parser *parser, struct dlt_buf *buf)
+{
+    uint8_t *data = dlt_buf_data(buf);
+    uint8_t len = dlt_buf_data_len(buf);
+
+    if (dlt_buf_msg_type(buf) != DLT_CONTROL_CODE || len == 0 ||
+        (data[0] != DLT_CTRL_LINK_CONFIG && data[0] != DLT_CTRL_LINK_CONFIRM)) {
+        return false;
+    }
+
+    if (data[0] == DLT_CTRL_LINK_CONFIRM) {
+        dlt_uart_confirm_by = 0;
+        dlt_uart_link_reply(DLT_CTRL_LINK_CONFIRM, 0, &dlt_uart_current);
+    } else if (len == 6 && dlt_uart_baudrate_valid(sys_get_le32(&data[1])) &&
+               !(data[5] & ~DLT_LINK_FLOW_RTS_CTS)) {
+        dlt_uart_next = dlt_uart_fallback;
+        dlt_uart_next.baudrate = sys_get_le32(&data[1]);
+        dlt_uart_next.flow_ctrl = data[5] & DLT_LINK_FLOW_RTS_CTS ?
+                                  UART_CFG_FLOW_CTRL_RTS_CTS :
+                                  UART_CFG_FLOW_CTRL_NONE;
+        dlt_uart_switching = true;
+        dlt_uart_link_reply(DLT_CTRL_LINK_CONFIG, 0, &dlt_uart_next);
+    } else {
+        LOG_WRN("Rejecting DLT link configuration.");
+        dlt_uart_link_reply(DLT_CTRL_LINK_CONFIG, EINVAL, &dlt_uart_current);
+    }
+
+    dlt_buf_free(buf);
+    return true;
+}
+
+/*
+ * Move a link negotiation on: switch settings once the reply accepting them
+ * has gone out, and fall back if the Pi doesn't confirm them in time or only
+ * noise arrives at them. Once confirmed, settings only fall back when the
+ * Pi's keepalives stop, as when it restarts at the fallback settings, so a
+ * burst of line noise on a busy link can't strand the Pi.
+ */
+static void dlt_uart_negotiate(struct dlt_parser *parser)
+{
+    static uint32_t frames;
+    static uint32_t skipped;
+    static int64_t heard;
+    int64_t now = k_uptime_get();
+
+    if (parser->frames != frames) {
+        frames = parser->frames;
+        skipped = parser->skipped;
+        heard = now;
+    }
+
+    if (dlt_uart_switching) {
+        if (dlt_tx_count == 0) {
+            dlt_uart_switching = false;
+            dlt_uart_configure(&dlt_uart_next);
+            dlt_uart_confirm_by = now + DLT_UART_CONFIRM_TIMEOUT_MS;
+            skipped = parser->skipped;
+        }
+        return;
+    }
+
+    bool negotiated = dlt_uart_current.baudrate != dlt_uart_fallback.baudrate ||
+                      dlt_uart_current.flow_ctrl != dlt_uart_fallback.flow_ctrl;
+    bool unconfirmed = dlt_uart_confirm_by && now >= dlt_uart_confirm_by;
+    bool noisy = dlt_uart_confirm_by &&
+                 parser->skipped - skipped > DLT_UART_NOISE_LIMIT;
+    bool silent = negotiated && !dlt_uart_confirm_by &&
+                  now - heard >= DLT_UART_KEEPALIVE_TIMEOUT_MS;
+    if (unconfirmed || noisy || silent) {
+        LOG_WRN("DLT UART settings lost, falling back.");
+        dlt_uart_confirm_by = 0;
+        dlt_uart_configure(&dlt_uart_fallback);
+        skipped = parser->skipped;
+    }
+}
+
+/* Start continuous reception, alternating between the DMA buffers */
+static int dlt_uart_rx_start(void)
+{
+    dlt_rx_next = 1;
+    return uart_rx_enable(dlt_uart, dlt_rx_dma[0], sizeof(dlt_rx_dma[0]),
+                          DLT_UART_RX_TIMEOUT);
+}
+
 /* Intialise the DLT UART Link thread */
 extern void dlt_uart_init()
 {
@@ -38,13 +368,44 @@ extern void dlt_uart_init()
         LOG_ERR("DLT COMMS init failed.");
         return;
     }
+
+    /* Start at the devicetree settings, the Pi negotiates from there */
+    ret = uart_config_get(dlt_uart, &dlt_uart_fallback);
+    if (ret) {
+        LOG_ERR("DLT UART config unavailable.");
+    }
+    dlt_uart_current = dlt_uart_fallback;
+}
+
+/*
+ * Parse the received bytes in the ring buffer. Returns false if parsing
+ * stopped early because the pool had no buffer for the next frame.
+ */
+static bool dlt_uart_parse(struct dlt_parser *parser)
+{
+    uint8_t *data;
+    uint32_t len;
+
+    while ((len = ring_buf_get_claim(&dlt_rx_ring, &data,
+                                     CONFIG_DLT_UART_RX_RING_SIZE)) > 0) {
+        size_t used = dlt_parser_feed(parser, data, len);
+        ring_buf_get_finish(&dlt_rx_ring, used);
+        if (used < len) {
+            return false;
+        }
+    }
+    return true;
 }
 
 /**
  * Thread function for DLT Communication.
  * 
- * @brief Periodically polls the DLT interface for packets to transmit and 
- *        forwards any received packets.
+ * @brief Sleeps until the DLT interface has packets to transmit or bytes are
+ *        received. Packets are queued for the UART, which chains transfers
+ *        from its completion callback, so the thread only wakes again when
+ *        more packets arrive or the queue was full. Received bytes are parsed
+ *        into frames as they arrive, so back-to-back frames from the Pi are
+ *        neither merged nor delayed by an RX timeout.
  */
 void dlt_uart_thread(void)
 {
@@ -53,55 +414,84 @@ void dlt_uart_thread(void)
     dlt_uart_init();
     dlt_link_register(PI_UART, link_tid);
 
-    /* Buffers */
-    uint8_t dlt_recv_buf[DLT_MAX_PACKET_LEN] = {0};
-    uint8_t uart_recv_buffer[DLT_MAX_PACKET_LEN] = {0};
-
     /* State variables */
-    bool rx_on = false;
+    struct dlt_parser parser;
+    bool rx_stalled = false;
+    int64_t rx_time = 0;
+    bool tx_full = false;
     int ret = 0;
 
+    dlt_parser_init(&parser, PI_UART);
+    dlt_parser_set_handler(&parser, dlt_uart_link_frame);
+
+    struct k_poll_event events[DLT_UART_EVT_COUNT];
+
     /* Sleep to let the main thread setup DLT */
     k_sleep(K_MSEC(100));
+    dlt_link_set_mtu(PI_UART, CONFIG_DLT_UART_MTU);
+#ifdef CONFIG_DLT_AGGREGATION
+    dlt_link_set_aggregation(PI_UART, true);
+#endif
+
+    ret = dlt_uart_rx_start();
+    if (ret) {
+        LOG_ERR("DLT UART RX enable failed.");
+        return;
+    }
 
     while (1) {
-        /* Poll DLT Interface for packets to transmit */
-        uint8_t msg_len = dlt_poll(PI_UART, dlt_recv_buf, 50, K_MSEC(5));
-        if (msg_len) {
-            LOG_INF("DLT mail received.");
-
-            /* Transmit the DLT packet via UART */
-            LOG_INF("Transmitting DLT packet.");
-            for (int i = 0; i < msg_len; i++) {
-                LOG_INF("  packet[%i]: %" PRIx8, i, dlt_recv_buf[i]);
-            }
-            ret = uart_tx(dlt_uart, dlt_recv_buf, msg_len, SYS_FOREVER_US);
-            if (ret) {
-                LOG_ERR("DLT UART transmission failed.");
-                break;
-            }
-        }
-
-        /* Receive DLT messsages */ 
-        if (!rx_on) {
-            /* Start UART RX */
-            ret = uart_rx_enable(dlt_uart, uart_recv_buffer,
-                                 DLT_MAX_PACKET_LEN, DLT_UART_RX_TIMEOUT);
-            if (ret) {
-                LOG_ERR("DLT UART RX enable failed.");
-                break;
-            }
-            rx_on = true;
-
-        } else if (rx_on && (k_sem_take(&dlt_rx_sem, K_NO_WAIT) == 0)) {
-            /* Submit the whole packet to DLT interface */
-            LOG_INF("DLT UART packet received, %d bytes. Submitting.",
-                    uart_recv_buffer[2] + DLT_PROTOCOL_BYTES);
-            dlt_submit(PI_UART, uart_recv_buffer,
-                       uart_recv_buffer[2] + DLT_PROTOCOL_BYTES, true);
-            rx_on = false;
-        }
-        k_sleep(K_MSEC(5));
+
+        /* Wait for packets to transmit, or for room to queue them. DLT
+         * traffic is held while link settings change, so none is lost. */
+        bool tx_hold = dlt_uart_switching || dlt_uart_confirm_by;
+        if (tx_full || tx_hold) {
+            k_poll_event_init(&events[DLT_UART_EVT_TX],
+                              K_POLL_TYPE_SEM_AVAILABLE,
+                              K_POLL_MODE_NOTIFY_ONLY, &dlt_tx_sem);
+        } else {
+            dlt_poll_event_init(PI_UART, &events[DLT_UART_EVT_TX]);
+        }
+        k_poll_event_init(&events[DLT_UART_EVT_RX], K_POLL_TYPE_SEM_AVAILABLE,
+                          K_POLL_MODE_NOTIFY_ONLY, &dlt_rx_sem);
+
+        /* Retry if the pool had no buffer for a frame, and give up on a
+         * frame whose remaining bytes never arrive */
+        k_timeout_t timeout = K_FOREVER;
+        if (rx_stalled) {
+            timeout = DLT_UART_RETRY;
+        } else if (dlt_parser_busy(&parser)) {
+            timeout = K_MSEC(DLT_UART_FRAME_TIMEOUT_MS);
+        }
+        if (tx_hold) {
+            timeout = DLT_UART_NEGOTIATE_POLL;
+        }
+        k_poll(events, DLT_UART_EVT_COUNT, timeout);
+
+        k_sem_take(&dlt_tx_sem, K_NO_WAIT);
+        if (!tx_hold) {
+            tx_full = !dlt_uart_tx_fill();
+        }
+
+        bool rx_ready = k_sem_take(&dlt_rx_sem, K_NO_WAIT) == 0;
+        if (rx_ready) {
+            rx_time = k_uptime_get();
+        }
+
+        if (rx_ready || rx_stalled) {
+            /* Submit every complete frame to DLT interface */
+            rx_stalled = !dlt_uart_parse(&parser);
+        } else if (dlt_parser_busy(&parser) &&
+                   k_uptime_get() - rx_time >= DLT_UART_FRAME_TIMEOUT_MS) {
+            LOG_WRN("DLT UART frame incomplete, dropping it.");
+            dlt_parser_reset(&parser);
+        }
+
+        dlt_uart_negotiate(&parser);
+
+        if (atomic_get(&dlt_rx_overruns)) {
+            LOG_WRN("DLT UART receive overrun, %d bytes lost.",
+                    (int)atomic_clear(&dlt_rx_overruns));
+        }
     }
 }
 
@@ -112,7 +502,9 @@ K_THREAD_DEFINE(dlt_comms, DLT_COMMS_STACKSIZE, dlt_uart_thread, NULL, NULL,
 /*
  * UART Async API callback function
  *
- * @brief The callback function gives the dlt_rx semaphore when RX is complete.
+ * @brief The callback function queues received bytes for the parser, keeps
+ *        the DMA supplied with receive buffers, and releases transmitted
+ *        frames and starts the next transfer when TX is complete.
  */
 static void uart_cb(const struct device *dev, struct uart_event *evt,
                     void *user_data)
@@ -120,15 +512,28 @@ static void uart_cb(const struct device *dev, struct uart_event *evt,
     switch (evt->type) {
 
     case UART_TX_DONE:
-
+    case UART_TX_ABORTED:
+        /* The DMA is the final consumer of the frames, release them and
+         * send the next ones */
+        dlt_uart_tx_release(evt->type == UART_TX_DONE ? 0 : -ECANCELED);
+        dlt_uart_tx_start();
         break;
 
-    case UART_RX_RDY:
-        /* Disable UART after the RX is ready */
-        uart_rx_disable(dlt_uart);
+    case UART_RX_RDY: {
+        /* Queue the new bytes for the parser */
+        uint32_t len = ring_buf_put(&dlt_rx_ring,
+                                    evt->data.rx.buf + evt->data.rx.offset,
+                                    evt->data.rx.len);
+        if (len < evt->data.rx.len) {
+            atomic_add(&dlt_rx_overruns, evt->data.rx.len - len);
+        }
+        k_sem_give(&dlt_rx_sem);
         break;
+    }
 
     case UART_RX_DISABLED:
+        /* Reception stops after an error, start it again */
+        dlt_uart_rx_start();
         break;
 
     case UART_RX_STOPPED:
@@ -136,12 +541,13 @@ static void uart_cb(const struct device *dev, struct uart_event *evt,
         break;
 
     case UART_RX_BUF_REQUEST:
+        /* Hand over the buffer the DMA is not using */
+        uart_rx_buf_rsp(dlt_uart, dlt_rx_dma[dlt_rx_next],
+                        sizeof(dlt_rx_dma[0]));
+        dlt_rx_next ^= 1;
         break;
 
     case UART_RX_BUF_RELEASED:
-        LOG_INF("DLT UART DMA reception complete.");
-        LOG_INF("Signalling thread.");
-        k_sem_give(&dlt_rx_sem);
         break;
 
     default:
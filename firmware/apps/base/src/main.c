@@ -1,11 +1,11 @@
 #include "zephyr/logging/log_core.h"
-#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include <zephyr/kernel.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/uart.h>
 #include <zephyr/logging/log.h>
 #include <pb_encode.h>
-#include <pb_decode.h>
 
 #ifdef CONFIG_SHELL_BACKEND_RTT
 #include <zephyr/shell/shell_rtt.h>
@@ -15,92 +15,190 @@
 
 #include "dlt_api.h"
 #include "dlt_endpoints.h"
+#include "dlt_nus_peripheral_link.h"
+#include "base_aircraft.h"
 #include "base_bt.h"
+#include "base_geo.h"
 #include "base_gps.h"
+#include "base_pi.h"
+#include "base_sched.h"
 #include "phaethon.pb.h"
 
 LOG_MODULE_REGISTER(base_main, LOG_LEVEL_INF);
 
-#define PI 3.14159265358979323846f
-
-/* Filter window for compass */
+/* Default half-angle of the patch of sky each display is pointed at */
 #define BEARING_FILTER_APERTURE  30.f
 
-// Convert degrees to radians
-static inline float degrees_to_radians(float degrees)
-{
-    return degrees * PI / 180.0f;
-}
+/* Aircraft updates queued for the M5 before older ones are replaced */
+#define M5_NUS_QUEUE_DEPTH 8
+
+/* Aircraft table slots checked for expiry each pass of the main loop */
+#define AIRCRAFT_EXPIRE_BUDGET 4
+
+/* Filter of the stream sent to one M5 display */
+struct base_display {
+    float aperture;   /* Degrees either side of the boresight */
+    float max_range;  /* Metres, 0 for no limit */
+};
+
+static struct base_display displays[CONFIG_DLT_NUS_MAX_DISPLAYS];
+
+/* What each display is sent, by base_sched_run() */
+static struct base_sched_display scheds[CONFIG_DLT_NUS_MAX_DISPLAYS];
 
-// Convert radians to degrees
-static inline float radians_to_degrees(float radians)
+/* Input sources the main loop waits on */
+enum base_events {
+    BASE_EVT_PI = 0,
+    BASE_EVT_WSU,
+    BASE_EVT_GPS,
+    BASE_EVT_DISPLAY,  /* First M5 display, the rest follow */
+    BASE_EVT_COUNT = BASE_EVT_DISPLAY + CONFIG_DLT_NUS_MAX_DISPLAYS,
+};
+
+/* Encode an aircraft from the table and send it to a display */
+static int base_send_aircraft(int display, const struct base_aircraft *aircraft,
+                              size_t budget, void *user_data)
 {
-    return radians * 180.0f / PI;
+    uint8_t ep = M5_NUS_EP(display);
+
+    if (!dlt_nus_display_ready(ep)) {
+        return -ENOTCONN;
+    }
+
+    struct dlt_buf *buf = dlt_buf_alloc(K_NO_WAIT);
+    if (!buf) {
+        return -ENOMEM;
+    }
+
+    /* Where the aircraft is as it is sent, the display predicts on from
+     * there */
+    struct base_aircraft_state state;
+    base_aircraft_predict(aircraft, k_uptime_get_32(), &state);
+
+    ADSBData message = ADSBData_init_zero;
+    snprintf(message.hex, sizeof(message.hex), "%06x", aircraft->icao);
+    strncpy(message.flight, state.flight, sizeof(message.flight) - 1);
+    message.lat = state.lat;
+    message.lon = state.lon;
+    message.altitude = state.altitude;
+    message.track = state.track;
+    message.speed = state.speed;
+
+    pb_ostream_t stream = pb_ostream_from_buffer(dlt_buf_data(buf),
+                                                 DLT_MAX_DATA_LEN);
+    if (!pb_encode(&stream, ADSBData_fields, &message)) {
+        LOG_ERR("Encoding failed: %s", PB_GET_ERROR(&stream));
+        dlt_buf_free(buf);
+        return -EIO;
+    }
+
+    size_t len = stream.bytes_written + DLT_PROTOCOL_BYTES;
+    if (len > budget) {
+        dlt_buf_free(buf);
+        return -ENOSPC;
+    }
+
+    /* Updates are coalesced by ICAO address on each display */
+    dlt_buf_set_key(buf, aircraft->icao);
+    int err = dlt_request_buf(ep, buf, stream.bytes_written);
+    return err ? err : (int)len;
 }
 
-// Calculate the bearing between two points using the rhumb line technique
-static float calculate_rhumb_line_bearing(float lat1, float lon1, float lat2,
-                                          float lon2)
+static int cmd_display_aperture(const struct shell *sh, size_t argc,
+                                char **argv)
 {
-    
-    /* Precalculate repeated values */
-    const static float PI_ON_4 = PI / 4.0f;
-    const static float TWO_PI = 2.0f * PI;
-    
-    // Convert latitudes and longitudes from degrees to radians
-    float phi1 = degrees_to_radians(lat1);
-    float phi2 = degrees_to_radians(lat2);
-    float lambda1 = degrees_to_radians(lon1);
-    float lambda2 = degrees_to_radians(lon2);
-
-    // Calculate the projected latitude difference (Δψ)
-    float delta_psi = logf(tanf(PI_ON_4 + phi2 / 2.0f) / tanf(PI_ON_4 + phi1 / 2.0f));
-
-    // Calculate the difference in longitudes (Δλ)
-    float delta_lambda = lambda2 - lambda1;
-
-    // Adjust the difference in longitudes (Δλ) if necessary
-    if (fabsf(delta_lambda) > PI) {
-        if (delta_lambda > 0) {
-            delta_lambda = -(TWO_PI - delta_lambda);
-        } else {
-            delta_lambda = TWO_PI + delta_lambda;
-        }
+    int n = atoi(argv[1]);
+    float aperture = strtof(argv[2], NULL);
+
+    if (n < 0 || n >= CONFIG_DLT_NUS_MAX_DISPLAYS || aperture <= 0.f ||
+        aperture > 180.f) {
+        shell_error(sh, "Usage: display aperture <0-%d> <degrees, 0-180>",
+                    CONFIG_DLT_NUS_MAX_DISPLAYS - 1);
+        return -EINVAL;
     }
 
-    // Calculate the bearing (brng)
-    float bearing = atan2f(delta_lambda, delta_psi);
+    displays[n].aperture = aperture;
+    return 0;
+}
 
-    // Convert the bearing from radians to degrees
-    bearing = radians_to_degrees(bearing);
+static int cmd_display_range(const struct shell *sh, size_t argc, char **argv)
+{
+    int n = atoi(argv[1]);
+    float range = strtof(argv[2], NULL);
 
-    // Normalize the bearing to be within the range [0, 360) degrees
-    if (bearing < 0) {
-        bearing += 360.0f;
+    if (n < 0 || n >= CONFIG_DLT_NUS_MAX_DISPLAYS || range < 0.f) {
+        shell_error(sh, "Usage: display range <0-%d> <km, 0 for no limit>",
+                    CONFIG_DLT_NUS_MAX_DISPLAYS - 1);
+        return -EINVAL;
     }
 
-    return bearing;
+    displays[n].max_range = range * 1000.f;
+    return 0;
 }
 
-// Check if the calculated bearing is within 30 degrees of the reference bearing
-static bool is_within_bearing(float calculated_bearing, float reference_bearing) {
-    float difference = fabsf(calculated_bearing - reference_bearing);
+static int cmd_display_budget(const struct shell *sh, size_t argc,
+                              char **argv)
+{
+    int n = atoi(argv[1]);
+    int budget = atoi(argv[2]);
 
-    // Adjust the difference to be the smallest angle between the bearings
-    if (difference > 180.0f) {
-        difference = 360.0f - difference;
+    if (n < 0 || n >= CONFIG_DLT_NUS_MAX_DISPLAYS || budget < 0) {
+        shell_error(sh, "Usage: display budget <0-%d> <bytes/s, 0 for no "
+                    "limit>", CONFIG_DLT_NUS_MAX_DISPLAYS - 1);
+        return -EINVAL;
     }
 
-    // Return true if the difference is within 30 degrees
-    return difference <= BEARING_FILTER_APERTURE;
+    scheds[n].budget = budget;
+    return 0;
 }
 
+static int cmd_display_list(const struct shell *sh, size_t argc, char **argv)
+{
+    for (int i = 0; i < CONFIG_DLT_NUS_MAX_DISPLAYS; i++) {
+        shell_print(sh, "display %d: %s, aperture %.1f, range %.0f km, "
+                    "budget %u B/s", i,
+                    dlt_nus_display_ready(M5_NUS_EP(i)) ? "ready" : "idle",
+                    (double)displays[i].aperture,
+                    (double)(displays[i].max_range / 1000.f),
+                    scheds[i].budget);
+    }
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_display,
+    SHELL_CMD_ARG(aperture, NULL, "Set a display's sky patch half-angle.",
+                  cmd_display_aperture, 3, 0),
+    SHELL_CMD_ARG(range, NULL, "Set a display's maximum range.",
+                  cmd_display_range, 3, 0),
+    SHELL_CMD_ARG(budget, NULL, "Set a display's bytes per second.",
+                  cmd_display_budget, 3, 0),
+    SHELL_CMD(list, NULL, "List M5 displays and their filters.",
+              cmd_display_list),
+    SHELL_SUBCMD_SET_END
+);
+SHELL_CMD_REGISTER(display, &sub_display, "M5 display filters.", NULL);
+
 int main(void)
 {
     k_tid_t device_tid = k_current_get();
-    dlt_interface_init(2);
+    dlt_interface_init(DLT_NUM_ENDPOINTS);
     dlt_device_register(device_tid);
 
+    for (int i = 0; i < CONFIG_DLT_NUS_MAX_DISPLAYS; i++) {
+        displays[i].aperture = BEARING_FILTER_APERTURE;
+        displays[i].max_range = CONFIG_BASE_SKY_MAX_RANGE_KM * 1000.f;
+        base_sched_init(&scheds[i], CONFIG_BASE_SCHED_BUDGET,
+                        k_uptime_get_32());
+
+        /* Should a display's link fall behind its budget, only the latest
+         * update for each aircraft is kept queued */
+        dlt_link_set_flow(M5_NUS_EP(i), M5_NUS_QUEUE_DEPTH,
+                          DLT_OVERFLOW_COALESCE);
+
+        /* Pass anything the displays send straight on to the Pi */
+        dlt_route_add(M5_NUS_EP(i), DLT_ROUTE_ANY, PI_UART);
+    }
+
     /* Connect to the Thingy52 */
     LOG_INF("Connecting to Thingy52");
 #ifdef CONFIG_SHELL_BACKEND_RTT
@@ -109,88 +207,123 @@ int main(void)
     shell_execute_cmd(shell_backend_uart_get_ptr(), "blecon -s c8:91:07:19:03:58");
 #endif
 
-    uint8_t rx_data[DLT_MAX_DATA_LEN] = {0};
-    uint8_t tx_buf[DLT_MAX_DATA_LEN] = {0};
-    uint8_t resp_len = 0;
-    uint8_t msg_type = 0;
-
     wsu_data_packet wsu; 
     bool wsu_conn = false;
 
     gps_base_data gps;
     gps.good_data = false;
 
-    while (true) {
+    /* Observer's frame, moved with the GPS fix */
+    struct base_geo_frame observer = {0};
 
-        /* Check the PI UART Link for data */
-        resp_len = dlt_read(PI_UART, &msg_type, rx_data, DLT_MAX_DATA_LEN,
-                            K_NO_WAIT);
-        if (resp_len) {
+    /* Wake on any input source instead of polling them */
+    struct k_poll_event events[BASE_EVT_COUNT];
+    dlt_read_event_init(PI_UART, &events[BASE_EVT_PI]);
+    base_bt_wsu_event_init(&events[BASE_EVT_WSU]);
+    base_gps_event_init(&events[BASE_EVT_GPS]);
+    for (int i = 0; i < CONFIG_DLT_NUS_MAX_DISPLAYS; i++) {
+        dlt_read_event_init(M5_NUS_EP(i), &events[BASE_EVT_DISPLAY + i]);
+    }
 
-            /* Decode message */
-            bool status;
+    /* When the displays are next sent aircraft */
+    uint32_t next_sched = k_uptime_get_32();
 
-            /* Allocate space for the decoded message. */
-            ADSBData message = ADSBData_init_zero;
+    while (true) {
 
-            /* Create a stream that reads from the buffer. */
-            pb_istream_t stream = pb_istream_from_buffer(rx_data, resp_len);
+        /* Sleep until the Pi, the WSU or the GPS has data, or the
+         * displays are due aircraft, then handle only the sources that
+         * fired */
+        bool sched = wsu_conn && observer.valid && base_aircraft_count();
+        int32_t wait = next_sched - k_uptime_get_32();
+        k_poll(events, BASE_EVT_COUNT,
+               sched ? K_MSEC(MAX(wait, 0)) : K_FOREVER);
 
-            /* Now we are ready to decode the message. */
-            status = pb_decode(&stream, ADSBData_fields, &message);
+        /* Check the PI UART Link for data */
+        ADSBData message;
+        int rx = -EAGAIN;
+        if (events[BASE_EVT_PI].state != K_POLL_STATE_NOT_READY) {
+            rx = base_pi_read(PI_UART, &message);
+        }
+        if (rx != -EAGAIN) {
+            uint32_t now = k_uptime_get_32();
 
-            /* Check for errors */
-            if (status) {
+            if (!rx) {
                 /* Print the data contained in the message. */
                 LOG_INF("Got packet for hex: %s", (char *)message.hex);
-                // LOG_INF("flight: %s", message.flight);
-                // LOG_INF("lat: %f", (double)message.lat);
-                // LOG_INF("lon: %f", (double)message.lon);
-                // LOG_INF("alt: %d", message.altitude);
-                // LOG_INF("speed: %d", message.speed);
-                // LOG_INF("track: %d", message.track);
-            } else {
-                LOG_ERR("Decoding failed: %s\n", PB_GET_ERROR(&stream));
-            }
 
-            /* GPS not bad */
-            if (gps.good_data) {
-                /* Filter the message */
-                float rhumb_bearing = calculate_rhumb_line_bearing(gps.latitude,
-                                                                gps.longitude,
-                                                                message.lat,
-                                                                message.lon);
-
-                bool allow = is_within_bearing(rhumb_bearing, wsu.yaw);
-                if (allow && wsu_conn) {
-                    /* Forward message */
-                    LOG_INF("Forwarding packet to M5.");
-                    dlt_request(M5_NUS, tx_buf, rx_data, resp_len, true);
-                } else {
-                    LOG_INF("Ignoring packet. Not in heading.");
-                }
+                struct base_aircraft_state state = {
+                    .lat = message.lat,
+                    .lon = message.lon,
+                    .altitude = message.altitude,
+                    .track = message.track,
+                    .speed = message.speed,
+                };
+                strncpy(state.flight, message.flight,
+                        sizeof(state.flight) - 1);
+
+                /* The displays are sent it when the scheduler next runs */
+                base_aircraft_update(strtoul((char *)message.hex, NULL, 16),
+                                     &state, now);
             }
+
+            /* Forget aircraft the Pi has stopped reporting */
+            base_aircraft_expire(now, AIRCRAFT_EXPIRE_BUDGET);
         }
 
         /* Check IMU data */
-        if (!base_bt_wsu_data_recv(&wsu, K_NO_WAIT)) {
+        if (events[BASE_EVT_WSU].state != K_POLL_STATE_NOT_READY &&
+            !base_bt_wsu_data_recv(&wsu, K_NO_WAIT)) {
             /* Print the packet */
             // LOG_INF("p %f, r %f, y %f", (double)wsu.pitch,
             //         (double)wsu.roll, (double)wsu.yaw);
             LOG_INF("Yaw: %.02f", (double)wsu.yaw);
             wsu_conn = true;
+
+            /* Point every display's patch along the WSU */
+            for (int i = 0; i < CONFIG_DLT_NUS_MAX_DISPLAYS; i++) {
+                base_sched_point(&scheds[i], wsu.yaw, wsu.pitch,
+                                 displays[i].aperture, displays[i].max_range);
+            }
         }
 
         /* Check GPS data */
-        if (!base_gps_i2c_data_recv(&gps, K_NO_WAIT)) {
+        if (events[BASE_EVT_GPS].state != K_POLL_STATE_NOT_READY &&
+            !base_gps_i2c_data_recv(&gps, K_NO_WAIT)) {
                 if (gps.good_data) {
                     LOG_INF("lat: %f, lon %f", (double)gps.latitude, (double)gps.longitude);
+                    base_geo_frame_update(&observer, gps.latitude,
+                                          gps.longitude,
+                                          CONFIG_BASE_OBSERVER_ALTITUDE_M);
                 } else {
                     LOG_INF("GPS data is bad.");
                 }
         }
 
-        k_sleep(K_MSEC(3));
+        /* Reading answers control packets from the displays, the rest of
+         * what they send is routed to the Pi before it gets here */
+        for (int i = 0; i < CONFIG_DLT_NUS_MAX_DISPLAYS; i++) {
+            if (events[BASE_EVT_DISPLAY + i].state != K_POLL_STATE_NOT_READY) {
+                struct dlt_buf *other = dlt_read_buf(M5_NUS_EP(i), K_NO_WAIT);
+                if (other) {
+                    dlt_buf_free(other);
+                }
+            }
+        }
+
+        /* Sources with data left stay ready and wake the next poll */
+        for (int i = 0; i < BASE_EVT_COUNT; i++) {
+            events[i].state = K_POLL_STATE_NOT_READY;
+        }
+
+        /* Send the displays the aircraft they most need */
+        uint32_t now = k_uptime_get_32();
+        if ((int32_t)(now - next_sched) >= 0) {
+            next_sched = now + CONFIG_BASE_SCHED_PERIOD_MS;
+            if (wsu_conn && observer.valid) {
+                base_sched_run(scheds, CONFIG_DLT_NUS_MAX_DISPLAYS, &observer,
+                               now, base_send_aircraft, NULL);
+            }
+        }
     }
 
     return 0;
@@ -18,7 +18,9 @@
 #include <zephyr/sys/byteorder.h>
 
 #include "dlt_api.h"
+#include "dlt_ble.h"
 #include "dlt_endpoints.h"
+#include "dlt_parser.h"
 
 /* Thread parameters */
 #define DLT_NUS_CENTRAL_STACKSIZE 2048
@@ -31,21 +33,41 @@
 
 LOG_MODULE_REGISTER(dlt_nus_central_link, LOG_LEVEL_INF);
 
-typedef struct nus_packet_t {
-	uint8_t length;
-	uint8_t data[DLT_MAX_DATA_LEN];
-} nus_packet_t;
+/* ATT opcode and handle in front of each notification payload */
+#define BT_ATT_NOTIFY_OVERHEAD 3
 
-/* Define the message queue for passing data from BT driver to thread */
-K_MSGQ_DEFINE(nus_msgq, sizeof(nus_packet_t), 3, 1);
+/* Assembles notified DLT frames straight into pool buffers */
+static struct dlt_parser nus_parser;
+
+/* Notification bytes lost to an empty buffer pool or a truncated frame */
+static uint32_t nus_rx_dropped;
 
 // const char TARGET_ADDR_STR[] = "C8:91:07:19:03:58";  // thingy52
 const char TARGET_ADDR_STR[] = "D7:BA:ED:13:75:90";  // nrfdk sam
 
-static void start_scan(void);
+/* The base, parsed from TARGET_ADDR_STR once */
+static bt_addr_le_t target_addr;
+
+static void start_connect(void);
 
 static struct bt_conn *default_conn;
 
+/*
+ * NUS value and CCC handles found by the last discovery, 0 until then. The
+ * base's GATT table is fixed, so a reconnect subscribes with them straight
+ * away and only rediscovers if that fails.
+ */
+static uint16_t nus_value_handle;
+static uint16_t nus_ccc_handle;
+
+/* Uptime the link to the base dropped, 0 once notifications flow again */
+static int64_t link_lost_at;
+
+#ifdef CONFIG_DLT_BLE
+/* Connection profile of the link to the base */
+static struct dlt_ble_link dlt_nus_ble;
+#endif
+
 static struct bt_uuid_128 nus_uuid = BT_UUID_INIT_128(BT_UUID_NUS_SRV_VAL);
 static struct bt_uuid_16 discover_uuid;
 
@@ -59,22 +81,66 @@ static uint8_t notify_func(struct bt_conn *conn,
 {
 	if (!data) {
 		printk("[UNSUBSCRIBED]\n");
-		params->value_handle = 0U;
 		return BT_GATT_ITER_STOP;
 	}
 
-	printk("[NOTIFICATION] data %p length %u. Submitting.\n", data, length);
-
-	/* Send the packet to the handler thread */
-	nus_packet_t pkt;
-	pkt.length = (uint8_t) length;
-	memcpy(pkt.data, data, length);
-	k_msgq_put(&nus_msgq, &pkt, K_NO_WAIT);
+	if (link_lost_at) {
+		LOG_INF("Streaming %lld ms after the link dropped",
+			(long long)(k_uptime_get() - link_lost_at));
+		link_lost_at = 0;
+	}
 
+	/*
+	 * A notification holds one or more whole DLT frames, up to the ATT
+	 * MTU. Each is copied once, from the Bluetooth buffer into a pool
+	 * buffer, and submitted to DLT from here; containers are split there.
+	 */
+	size_t used = dlt_parser_feed(&nus_parser, data, length);
+	if (used < length || dlt_parser_busy(&nus_parser)) {
+		dlt_parser_reset(&nus_parser);
+		nus_rx_dropped += length - used;
+		LOG_WRN("Dropped %u notification bytes (%u total)",
+			(unsigned int)(length - used), nus_rx_dropped);
+	}
 
 	return BT_GATT_ITER_CONTINUE;
 }
 
+static void start_discovery(struct bt_conn *conn);
+
+/* The CCC write completed, or failed because the cached handles are stale */
+static void subscribed(struct bt_conn *conn, uint8_t err,
+		       struct bt_gatt_subscribe_params *params)
+{
+	if (!err) {
+		printk("[SUBSCRIBED]\n");
+		return;
+	}
+
+	LOG_WRN("Subscribe failed (ATT err 0x%02x), rediscovering", err);
+	nus_value_handle = 0U;
+	nus_ccc_handle = 0U;
+	start_discovery(conn);
+}
+
+/* Enable notifications on the cached NUS handles */
+static int subscribe(struct bt_conn *conn)
+{
+	int err;
+
+	subscribe_params.notify = notify_func;
+	subscribe_params.subscribe = subscribed;
+	subscribe_params.value = BT_GATT_CCC_NOTIFY;
+	subscribe_params.value_handle = nus_value_handle;
+	subscribe_params.ccc_handle = nus_ccc_handle;
+
+	err = bt_gatt_subscribe(conn, &subscribe_params);
+	if (err && err != -EALREADY) {
+		LOG_ERR("Subscribe failed (err %d)", err);
+	}
+	return err;
+}
+
 static uint8_t discover_func(struct bt_conn *conn,
 			     const struct bt_gatt_attr *attr,
 			     struct bt_gatt_discover_params *params)
@@ -125,18 +191,10 @@ static uint8_t discover_func(struct bt_conn *conn,
 
 	/* Handle discovery of RX service CCC, service0010/char0011/desc0013 */ 
 	} else {
-		/* Set the callback function */
-		subscribe_params.notify = notify_func;
-		subscribe_params.value = BT_GATT_CCC_NOTIFY;
-		subscribe_params.ccc_handle = attr->handle;
-
-		/* Attempt to subscribe */
-		err = bt_gatt_subscribe(conn, &subscribe_params);
-		if (err && err != -EALREADY) {
-			LOG_ERR("Subscribe failed (err %d)", err);
-		} else {
-			printk("[SUBSCRIBED]\n");
-		}
+		/* Remember the handles for the next connection */
+		nus_value_handle = subscribe_params.value_handle;
+		nus_ccc_handle = attr->handle;
+		(void)subscribe(conn);
 
 		return BT_GATT_ITER_STOP;
 	}
@@ -144,6 +202,7 @@ static uint8_t discover_func(struct bt_conn *conn,
 	return BT_GATT_ITER_STOP;
 }
 
+#ifndef CONFIG_BT_FILTER_ACCEPT_LIST
 static void device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type,
                          struct net_buf_simple *ad)
 {
@@ -162,23 +221,26 @@ static void device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type,
 	printk("Device found: %s (RSSI %d)\n", addr_str, rssi);
 
 	/* Compare the MACs */
-	bt_addr_le_t target_addr;
-    err = bt_addr_le_from_str(TARGET_ADDR_STR, "random", &target_addr);
 	if (bt_addr_le_cmp(&target_addr, addr)) {
 		return;
-	} 
+	}
 
 	/* Stop scanning for devices */
 	if (bt_le_scan_stop()) {
 		return;
 	}
 
-	/* Try to connect */
+	/* Try to connect, straight onto the link's connection profile */
+#ifdef CONFIG_DLT_BLE
+	err = bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN,
+				dlt_ble_conn_param(&dlt_nus_ble), &default_conn);
+#else
 	err = bt_conn_le_create(addr, BT_CONN_LE_CREATE_CONN,
 				BT_LE_CONN_PARAM_DEFAULT, &default_conn);
+#endif
 	if (err) {
 		LOG_ERR("Create conn to %s failed (%d)", addr_str, err);
-		start_scan();
+		start_connect();
 	}
 }
 
@@ -203,6 +265,56 @@ static void start_scan(void)
 
 	printk("Scanning successfully started\n");
 }
+#endif
+
+/*
+ * Connect to the base. With the filter accept list the controller scans
+ * continuously for the base alone and connects on its first advertisement,
+ * without reporting advertisements to the host; otherwise scan for it.
+ */
+static void start_connect(void)
+{
+#ifdef CONFIG_BT_FILTER_ACCEPT_LIST
+	const struct bt_conn_le_create_param *create_param =
+		BT_CONN_LE_CREATE_PARAM(BT_CONN_LE_OPT_NONE,
+					BT_GAP_SCAN_FAST_WINDOW,
+					BT_GAP_SCAN_FAST_WINDOW);
+#ifdef CONFIG_DLT_BLE
+	const struct bt_le_conn_param *conn_param =
+		dlt_ble_conn_param(&dlt_nus_ble);
+#else
+	const struct bt_le_conn_param *conn_param = BT_LE_CONN_PARAM_DEFAULT;
+#endif
+
+	int err = bt_conn_le_create_auto(create_param, conn_param);
+	if (err) {
+		LOG_ERR("Auto connect failed to start (err %d)", err);
+		return;
+	}
+
+	printk("Waiting for the base\n");
+#else
+	start_scan();
+#endif
+}
+
+/* Discover the NUS TX value and CCC handles, from the service down */
+static void start_discovery(struct bt_conn *conn)
+{
+	int err;
+
+	memcpy(&nus_uuid, BT_UUID_NUS, sizeof(nus_uuid));
+	discover_params.uuid = &nus_uuid.uuid;
+	discover_params.func = discover_func;
+	discover_params.start_handle = BT_ATT_FIRST_ATTRIBUTE_HANDLE;
+	discover_params.end_handle = BT_ATT_LAST_ATTRIBUTE_HANDLE;
+	discover_params.type = BT_GATT_DISCOVER_PRIMARY;
+
+	err = bt_gatt_discover(conn, &discover_params);
+	if (err) {
+		LOG_ERR("Discover failed(err %d)", err);
+	}
+}
 
 static void mtu_exchange_cb(struct bt_conn *conn, uint8_t err,
 			    struct bt_gatt_exchange_params *params)
@@ -210,6 +322,9 @@ static void mtu_exchange_cb(struct bt_conn *conn, uint8_t err,
 	printk("%s: MTU exchange %s (%u)\n", __func__,
 	       err == 0U ? "successful" : "failed",
 	       bt_gatt_get_mtu(conn));
+
+	/* Fragment DLT packets to the base to fit the negotiated MTU */
+	dlt_link_set_mtu(NRF_NUS, bt_gatt_get_mtu(conn) - BT_ATT_NOTIFY_OVERHEAD);
 }
 
 static struct bt_gatt_exchange_params mtu_exchange_params = {
@@ -234,36 +349,48 @@ static int mtu_exchange(struct bt_conn *conn)
 static void connected(struct bt_conn *conn, uint8_t conn_err)
 {
 	char addr[BT_ADDR_LE_STR_LEN];
-	int err;
 
 	bt_addr_le_to_str(bt_conn_get_dst(conn), addr, sizeof(addr));
 
 	if (conn_err) {
 		LOG_ERR("Failed to connect to %s (%u)", addr, conn_err);
 
-		bt_conn_unref(default_conn);
-		default_conn = NULL;
+		if (default_conn) {
+			bt_conn_unref(default_conn);
+			default_conn = NULL;
+		}
 
-		start_scan();
+		start_connect();
 		return;
 	}
 
+	/* Auto connect hands over the connection here */
+	if (!default_conn) {
+		default_conn = bt_conn_ref(conn);
+	}
+
 	printk("Connected: %s\n", addr);
-	(void)mtu_exchange(conn);
 
 	if (conn == default_conn) {
-		discover_params.uuid = &nus_uuid.uuid;
-		discover_params.func = discover_func;
-		discover_params.start_handle = BT_ATT_FIRST_ATTRIBUTE_HANDLE;
-		discover_params.end_handle = BT_ATT_LAST_ATTRIBUTE_HANDLE;
-		discover_params.type = BT_GATT_DISCOVER_PRIMARY;
-
-		err = bt_gatt_discover(default_conn, &discover_params);
-		if (err) {
-			LOG_ERR("Discover failed(err %d)", err);
-			return;
+#ifdef CONFIG_DLT_BLE
+		(void)dlt_ble_connected(&dlt_nus_ble, conn);
+#endif
+
+		/* Writes to the base must fit the default MTU until the
+		 * exchange completes, whatever the last connection used */
+		dlt_link_set_mtu(NRF_NUS,
+				 BT_ATT_DEFAULT_LE_MTU - BT_ATT_NOTIFY_OVERHEAD);
+
+		/* Subscribe first: the base holds its notifications to the
+		 * default MTU too until it sees the exchange */
+		if (nus_ccc_handle) {
+			(void)subscribe(conn);
+		} else {
+			start_discovery(conn);
 		}
 	}
+
+	(void)mtu_exchange(conn);
 }
 
 static void disconnected(struct bt_conn *conn, uint8_t reason)
@@ -280,14 +407,54 @@ static void disconnected(struct bt_conn *conn, uint8_t reason)
 
 	bt_conn_unref(default_conn);
 	default_conn = NULL;
+	link_lost_at = k_uptime_get();
+#ifdef CONFIG_DLT_BLE
+	dlt_ble_disconnected(&dlt_nus_ble, reason);
+#endif
 
-	printk("Restarting scan");
-	start_scan();
+	printk("Reconnecting\n");
+	start_connect();
 }
 
+#ifdef CONFIG_DLT_BLE
+/* Report the parameters the link settled on to the DLT statistics */
+static void param_updated(struct bt_conn *conn, uint16_t interval,
+			  uint16_t latency, uint16_t timeout)
+{
+	printk("Connection interval %u, latency %u\n", interval, latency);
+	dlt_ble_updated(&dlt_nus_ble, conn);
+}
+
+#ifdef CONFIG_BT_USER_PHY_UPDATE
+static void phy_updated(struct bt_conn *conn, struct bt_conn_le_phy_info *info)
+{
+	printk("PHY updated - TX: %u, RX: %u\n", info->tx_phy, info->rx_phy);
+	dlt_ble_updated(&dlt_nus_ble, conn);
+}
+#endif
+
+#ifdef CONFIG_BT_USER_DATA_LEN_UPDATE
+static void data_len_updated(struct bt_conn *conn,
+			     struct bt_conn_le_data_len_info *info)
+{
+	printk("Data length updated - TX: %u\n", info->tx_max_len);
+	dlt_ble_updated(&dlt_nus_ble, conn);
+}
+#endif
+#endif
+
 BT_CONN_CB_DEFINE(conn_callbacks) = {
 	.connected = connected,
 	.disconnected = disconnected,
+#ifdef CONFIG_DLT_BLE
+	.le_param_updated = param_updated,
+#ifdef CONFIG_BT_USER_PHY_UPDATE
+	.le_phy_updated = phy_updated,
+#endif
+#ifdef CONFIG_BT_USER_DATA_LEN_UPDATE
+	.le_data_len_updated = data_len_updated,
+#endif
+#endif
 };
 
 
@@ -295,7 +462,11 @@ void dlt_nus_central_thread(void)
 {
     /* Initialise the UART peripheral and register Link with DLT driver */
     k_tid_t link_tid = k_current_get();
+    dlt_parser_init(&nus_parser, NRF_NUS);
     dlt_link_register(NRF_NUS, link_tid);
+#ifdef CONFIG_DLT_BLE
+	dlt_ble_link_init(&dlt_nus_ble, NRF_NUS);
+#endif
 
 	int err;
 	err = bt_enable(NULL);
@@ -305,15 +476,24 @@ void dlt_nus_central_thread(void)
 		return;
 	}
 
-	start_scan();
+	err = bt_addr_le_from_str(TARGET_ADDR_STR, "random", &target_addr);
+	if (err) {
+		LOG_ERR("Invalid base address %s (err %d)", TARGET_ADDR_STR, err);
+		return;
+	}
 
-	nus_packet_t packet;
-	while (true) {
-		if (!k_msgq_get(&nus_msgq, &packet, K_FOREVER)) {
-			dlt_submit(NRF_NUS, packet.data, packet.length, true);
-		}
+#ifdef CONFIG_BT_FILTER_ACCEPT_LIST
+	err = bt_le_filter_accept_list_add(&target_addr);
+	if (err) {
+		LOG_ERR("Failed to add the base to the accept list (err %d)", err);
+		return;
 	}
-	return;
+#endif
+
+	start_connect();
+
+	/* Notifications are submitted from the Bluetooth callbacks */
+	k_sleep(K_FOREVER);
 }
 
 /* Register the thread */
@@ -1,4 +1,5 @@
 #include "zephyr/logging/log_core.h"
+#include <string.h>
 #include <zephyr/kernel.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/uart.h>
@@ -7,12 +8,24 @@
 #include <zephyr/device.h>
 #include <zephyr/display/cfb.h>
 
+#include "adsb_predict.h"
 #include "dlt_api.h"
 #include "dlt_endpoints.h"
 #include "phaethon.pb.h"
 
 LOG_MODULE_REGISTER(m5_main, LOG_LEVEL_INF);
 
+/* Clear the display after this long without data */
+#define M5_IDLE_TIMEOUT_MS 5000
+
+/* Redraw the aircraft where it is predicted to be this often */
+#define M5_REDRAW_MS 500
+
+/* The aircraft on the display */
+static char shown_hex[SIZEOF_FIELD(ADSBData, hex)];
+static char shown_flight[SIZEOF_FIELD(ADSBData, flight)];
+static struct adsb_predict shown;
+
 bool init_display(const struct device *dev)
 {
 	uint16_t x_res;
@@ -72,6 +85,51 @@ bool init_display(const struct device *dev)
     return true;
 }
 
+/* Draw the shown aircraft where it is predicted to be */
+static void draw_aircraft(const struct device *dev, uint32_t now_ms)
+{
+    struct adsb_predict_fix fix;
+    adsb_predict_at(&shown, now_ms, &fix);
+
+    cfb_framebuffer_clear(dev, false);
+    char pbuf[40]; // Buffer for formatting strings
+    int err = 0;
+    int y_pos = 0; // Starting y-coordinate
+
+    // Print each data field on a separate line, incrementing the y-coordinate each time
+    sprintf(pbuf, "%s", shown_flight);
+    err = cfb_print(dev, pbuf, 2, y_pos);
+    if (err) {
+        printk("Failed to print flight\n");
+    }
+    y_pos += 15; // Adjust y-coordinate for the next line
+
+    sprintf(pbuf, "%s", shown_hex);
+    err = cfb_print(dev, pbuf, 2, y_pos);
+    if (err) {
+        printk("Failed to print hex\n");
+    }
+    y_pos += 15; // Adjust y-coordinate for the next line
+
+    sprintf(pbuf, "Lat%.02f", (double)fix.lat);
+    err = cfb_print(dev, pbuf, 2, y_pos);
+    if (err) {
+        printk("Failed to print latitude\n");
+    }
+    y_pos += 15; // Adjust y-coordinate for the next line
+
+    sprintf(pbuf, "Lon%.02f", (double)fix.lon);
+    err = cfb_print(dev, pbuf, 2, y_pos);
+    if (err) {
+        printk("Failed to print longitude\n");
+    }
+    y_pos += 15; // Adjust y-coordinate for the next line
+
+    // Continue printing additional data fields in a similar fashion
+
+    cfb_framebuffer_finalize(dev);
+}
+
 int main(void)
 {
     /* Setup display */
@@ -84,25 +142,39 @@ int main(void)
 
     dlt_device_register(device_tid);
 
-    uint8_t rx_data[DLT_MAX_DATA_LEN] = {0};
-    uint8_t resp_len = 0;
-    uint8_t msg_type = 0;
     int64_t last_packet = 0;
+    int64_t last_draw = 0;
     int64_t now = 0;
+    bool idle = false;
+
+    struct k_poll_event evt;
+    dlt_read_event_init(NRF_NUS, &evt);
 
     LOG_INF("Starting main loop");
 
     while (true) {
 
+        /* Sleep until data arrives, the aircraft is due a redraw, or the
+         * display goes idle */
+        now = k_uptime_get();
+        int64_t wait = MIN(M5_IDLE_TIMEOUT_MS - (now - last_packet),
+                           M5_REDRAW_MS - (now - last_draw));
+        k_poll(&evt, 1, idle ? K_FOREVER : K_MSEC(MAX(0, wait)));
+        evt.state = K_POLL_STATE_NOT_READY;
+
         /* Get the system tick */
         now = k_uptime_get();
 
-        /* Check the PI UART Link for data */
-        resp_len = dlt_read(NRF_NUS, &msg_type, rx_data, DLT_MAX_DATA_LEN,
-                            K_NO_WAIT);
-        if (resp_len) {
+        /* Check the base's NUS Link for data. Updates sent before the MTU
+         * exchange arrive in fragments, which dlt_read() reassembles. */
+        uint8_t rx[ADSBData_size];
+        uint8_t rx_type;
+        uint16_t rx_len = dlt_read(NRF_NUS, &rx_type, rx, sizeof(rx),
+                                   K_NO_WAIT);
+        if (rx_len) {
             LOG_INF("Message received.");
             last_packet = now;
+            idle = false;
 
             /* Decode message */
             bool status;
@@ -110,8 +182,8 @@ int main(void)
             /* Allocate space for the decoded message. */
             ADSBData message = ADSBData_init_zero;
 
-            /* Create a stream that reads from the buffer. */
-            pb_istream_t stream = pb_istream_from_buffer(rx_data, resp_len);
+            /* Create a stream that reads from the message. */
+            pb_istream_t stream = pb_istream_from_buffer(rx, rx_len);
 
             /* Now we are ready to decode the message. */
             status = pb_decode(&stream, ADSBData_fields, &message);
@@ -127,55 +199,37 @@ int main(void)
                 LOG_INF("speed: %d", message.speed);
                 LOG_INF("track: %d", message.track);
 
-                /* Print to the display */
-                cfb_framebuffer_clear(dev, false);
-                char pbuf[40]; // Buffer for formatting strings
-                int err = 0;
-                int y_pos = 0; // Starting y-coordinate
-
-                // Print each data field on a separate line, incrementing the y-coordinate each time
-                sprintf(pbuf, "%s", message.flight);
-                err = cfb_print(dev, pbuf, 2, y_pos);
-                if (err) {
-                    printk("Failed to print flight\n");
+                /* Follow this aircraft from here */
+                if (strcmp(shown_hex, message.hex)) {
+                    shown.valid = false;
                 }
-                y_pos += 15; // Adjust y-coordinate for the next line
-
-                sprintf(pbuf, "%s", message.hex);
-                err = cfb_print(dev, pbuf, 2, y_pos);
-                if (err) {
-                    printk("Failed to print hex\n");
-                }
-                y_pos += 15; // Adjust y-coordinate for the next line
-
-                sprintf(pbuf, "Lat%.02f", (double)message.lat);
-                err = cfb_print(dev, pbuf, 2, y_pos);
-                if (err) {
-                    printk("Failed to print latitude\n");
-                }
-                y_pos += 15; // Adjust y-coordinate for the next line
-
-                sprintf(pbuf, "Lon%.02f", (double)message.lon);
-                err = cfb_print(dev, pbuf, 2, y_pos);
-                if (err) {
-                    printk("Failed to print longitude\n");
-                }
-                y_pos += 15; // Adjust y-coordinate for the next line
-
-                // Continue printing additional data fields in a similar fashion
-
-                cfb_framebuffer_finalize(dev);
+                strcpy(shown_hex, message.hex);
+                strcpy(shown_flight, message.flight);
+
+                struct adsb_predict_fix fix = {
+                    .lat = message.lat,
+                    .lon = message.lon,
+                    .altitude = message.altitude,
+                    .speed = message.speed,
+                    .track = message.track,
+                };
+                adsb_predict_update(&shown, &fix, (uint32_t)now);
+                draw_aircraft(dev, (uint32_t)now);
+                last_draw = now;
 
             } else {
                 LOG_ERR("Decoding failed: %s\n", PB_GET_ERROR(&stream));
             }
 
-        } else if (!resp_len && (now - last_packet > 5000)) {
+        } else if (!idle && now - last_packet >= M5_IDLE_TIMEOUT_MS) {
             printk("No data received in 5 seconds\n");
             cfb_framebuffer_clear(dev, true);
+            idle = true;
+        } else if (!idle && shown.valid && now - last_draw >= M5_REDRAW_MS) {
+            /* Move the aircraft on between updates */
+            draw_aircraft(dev, (uint32_t)now);
+            last_draw = now;
         }
-
-        k_sleep(K_MSEC(3));
     }
 
     return 0;
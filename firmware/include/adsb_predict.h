@@ -0,0 +1,98 @@
+/**
+ * @file adsb_predict.h
+ *
+ * @brief Aircraft position prediction between ADS-B updates.
+ *
+ * Aircraft only report their position every few seconds, less often still
+ * once the Pi stops sending updates it can predict. Between reports, an
+ * aircraft's position is extrapolated from its velocity. Each aircraft has a
+ * small constant-velocity Kalman filter per axis (north, east and up, in
+ * metres) that combines the reported positions with the reported speed and
+ * track. ADSBData has no vertical rate, so the vertical velocity is
+ * estimated from successive altitudes.
+ *
+ * Positions are kept relative to the latest report, so the filter only
+ * handles distances an aircraft covers between reports and single precision
+ * is enough. Predictions stop CONFIG_ADSB_PREDICT_HORIZON_S after the latest
+ * report, where the aircraft is held.
+ */
+
+#ifndef ADSB_PREDICT_H_
+#define ADSB_PREDICT_H_
+
+#include <zephyr/kernel.h>
+
+#ifdef CONFIG_ADSB_PREDICT
+/**
+ * @brief Position and velocity of an aircraft, in ADS-B's units.
+ */
+struct adsb_predict_fix {
+    float lat;       /* Degrees */
+    float lon;       /* Degrees */
+    float altitude;  /* Feet */
+    float speed;     /* Knots over the ground */
+    float track;     /* Degrees clockwise from north */
+};
+
+/**
+ * @brief Estimate along one axis.
+ */
+struct adsb_predict_axis {
+    float pos;  /* Metres from the latest report, altitude for up */
+    float vel;  /* Metres per second */
+    float p00;  /* Covariance of pos, vel */
+    float p01;
+    float p11;
+};
+
+/**
+ * @brief Predictor for one aircraft.
+ */
+struct adsb_predict {
+    float lat;            /* Latest report, the origin of north and east */
+    float lon;
+    float east_per_deg;   /* Metres per degree of longitude at lat */
+    struct adsb_predict_axis north;
+    struct adsb_predict_axis east;
+    struct adsb_predict_axis up;
+    uint32_t updated_ms;  /* Uptime of the latest report */
+    bool valid;
+};
+
+/**
+ * @brief Starts a predictor from an aircraft's first report.
+ *
+ * @param predict Predictor to start.
+ * @param fix Reported position and velocity.
+ * @param now_ms Uptime of the report in milliseconds.
+ */
+extern void adsb_predict_init(struct adsb_predict *predict,
+                              const struct adsb_predict_fix *fix,
+                              uint32_t now_ms);
+
+/**
+ * @brief Corrects a predictor with a new report.
+ *
+ * Starts the predictor if it is not valid.
+ *
+ * @param predict Predictor to correct.
+ * @param fix Reported position and velocity.
+ * @param now_ms Uptime of the report in milliseconds.
+ */
+extern void adsb_predict_update(struct adsb_predict *predict,
+                                const struct adsb_predict_fix *fix,
+                                uint32_t now_ms);
+
+/**
+ * @brief Predicts where an aircraft is.
+ *
+ * @param predict Valid predictor.
+ * @param now_ms Uptime to predict for, in milliseconds.
+ * @param fix Receives the predicted position, and the estimated speed and
+ *            track.
+ */
+extern void adsb_predict_at(const struct adsb_predict *predict,
+                            uint32_t now_ms, struct adsb_predict_fix *fix);
+#endif // CONFIG_ADSB_PREDICT
+
+#endif // ADSB_PREDICT_H_
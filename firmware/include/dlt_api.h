@@ -25,16 +25,149 @@
 #include <zephyr/kernel.h>
 
 /* DLT interface configuration */
-#define DLT_MAX_PACKET_LEN 50 
+#ifdef CONFIG_DLT_MAX_PACKET_LEN
+#define DLT_MAX_PACKET_LEN CONFIG_DLT_MAX_PACKET_LEN
+#else
+#define DLT_MAX_PACKET_LEN 50
+#endif
 #define DLT_PROTOCOL_BYTES 3  // don't change
-#define DLT_MAX_DATA_LEN   DLT_MAX_PACKET_LEN - DLT_PROTOCOL_BYTES
+#define DLT_MAX_DATA_LEN   (DLT_MAX_PACKET_LEN - DLT_PROTOCOL_BYTES)
+#ifdef CONFIG_DLT_MAX_ENDPOINTS
+#define DLT_MAX_ENDPOINTS CONFIG_DLT_MAX_ENDPOINTS
+#else
 #define DLT_MAX_ENDPOINTS 3
+#endif
 
 /* DLT Protocol Codes */
 #define DLT_PREAMBLE 0x77
 #define DLT_REQUEST_CODE 0x01
 #define DLT_RESPONSE_CODE 0x02
 
+/*
+ * Container packets carry several complete DLT packets, headers included,
+ * back to back in their data segment.
+ */
+#define DLT_AGGREGATE_CODE 0x03
+
+/*
+ * Control packets are answered by DLT when the device reads them rather
+ * than returned to it. The first data byte is the control opcode; replies
+ * carry the opcode with bit 7 set.
+ */
+#define DLT_CONTROL_CODE 0x04
+#define DLT_CTRL_REPLY   0x80
+#define DLT_CTRL_STATS   0x01
+
+/*
+ * Link control opcodes configure the physical link and are answered by the
+ * Link itself, so they never reach the device. A link configuration request
+ * carries the baud rate (u32, little endian) and DLT_LINK_FLOW_* flags; the
+ * reply adds a status byte, 0 if accepted, before them. Once the reply is
+ * sent the Link switches over, and falls back unless a confirm request
+ * arrives at the new settings.
+ */
+#define DLT_CTRL_LINK_CONFIG  0x02
+#define DLT_CTRL_LINK_CONFIRM 0x03
+#define DLT_LINK_FLOW_RTS_CTS 0x01
+
+/*
+ * Fragmented messages set the fragment flag in the message type of every
+ * frame. Each fragment's data segment starts with a header of message id,
+ * fragment index and total message length (little endian), followed by the
+ * next slice of the message.
+ */
+#define DLT_FRAGMENT_FLAG 0x80
+#define DLT_FRAGMENT_HEADER_LEN 4
+
+#ifdef CONFIG_DLT_BUF_POOL
+/**
+ * @brief Completion callback for a buffer sent by a device.
+ *
+ * May be called from the link thread or from interrupt context, so it must
+ * not block. The buffer has already been returned to the pool.
+ *
+ * @param status 0 once the link has transmitted the packet or its contents
+ *               were copied into other packets (fragments or a container),
+ *               negative errno if DLT or the link dropped it.
+ * @param user_data Pointer given to dlt_buf_set_done().
+ */
+typedef void (*dlt_buf_done_t)(int status, void *user_data);
+
+/**
+ * @brief DLT packet buffer.
+ *
+ * Buffers are allocated from a fixed-size pool and passed between Devices and
+ * Links by reference. Whoever holds the reference owns the buffer; handing it
+ * to a DLT function transfers ownership, and the final consumer must release
+ * it with dlt_buf_free() or dlt_buf_complete().
+ */
+struct dlt_buf {
+    void *fifo_reserved;                 /* Reserved for the endpoint queue */
+    dlt_buf_done_t done;                 /* Called once the buffer is released */
+    void *user_data;                     /* Passed to done */
+    uint32_t key;                        /* Coalescing key, 0 for none */
+    atomic_t ticket;                     /* Reserved for coalescing */
+#ifdef CONFIG_DLT_STATS
+    uint32_t stamp;                      /* Cycle count when queued */
+#endif
+    uint16_t len;                        /* Length of the encoded packet */
+    uint8_t packet[DLT_MAX_PACKET_LEN];  /* Encoded DLT packet */
+};
+
+/*
+ * Set the callback run when a sent buffer is released. Devices own the
+ * buffer until they send it and must not touch it afterwards; the callback
+ * tells them when the transfer finished, so many sends can be in flight.
+ */
+static inline void dlt_buf_set_done(struct dlt_buf *buf, dlt_buf_done_t done,
+                                    void *user_data)
+{
+    buf->done = done;
+    buf->user_data = user_data;
+}
+
+/*
+ * Set the coalescing key of a buffer. On links using DLT_OVERFLOW_COALESCE,
+ * sending a buffer replaces a still queued buffer with the same key, e.g.
+ * an older update for the same aircraft. 0 disables coalescing.
+ */
+static inline void dlt_buf_set_key(struct dlt_buf *buf, uint32_t key)
+{
+    buf->key = key;
+}
+
+/**
+ * @brief What happens when a device sends to a link with no credits left.
+ */
+enum dlt_overflow {
+    /** Drop the packet being sent */
+    DLT_OVERFLOW_DROP_NEWEST,
+    /** Drop the oldest packet still queued for the link */
+    DLT_OVERFLOW_DROP_OLDEST,
+    /** Replace the queued packet with the same key, see dlt_buf_set_key(),
+     *  otherwise drop the packet being sent */
+    DLT_OVERFLOW_COALESCE,
+};
+
+/* Get a pointer to the data segment of a buffer */
+static inline uint8_t *dlt_buf_data(struct dlt_buf *buf)
+{
+    return &buf->packet[DLT_PROTOCOL_BYTES];
+}
+
+/* Get the length of the data segment of an encoded buffer */
+static inline uint8_t dlt_buf_data_len(const struct dlt_buf *buf)
+{
+    return buf->packet[2];
+}
+
+/* Get the message type of an encoded buffer */
+static inline uint8_t dlt_buf_msg_type(const struct dlt_buf *buf)
+{
+    return buf->packet[1];
+}
+#endif
+
 /**
  * @brief Initializes the DLT interface with the specified number of endpoints.
  *
@@ -57,6 +190,21 @@ extern bool dlt_interface_init(uint8_t num_endpoints);
  */
 extern void dlt_device_register(k_tid_t dev_tid);
 
+/**
+ * @brief Registers a device thread for a single endpoint.
+ *
+ * Lets several device threads share the interface, each reading the
+ * endpoints registered to it. Endpoints without a device of their own use
+ * the one registered with dlt_device_register(). Register every device
+ * before any of them sends.
+ *
+ * @param ep Endpoint identifier.
+ * @param dev_tid Thread ID of the device thread for @p ep.
+ * @return 0 on success, or -EINVAL if @p ep is not below
+ *         CONFIG_DLT_MAX_ENDPOINTS.
+ */
+extern int dlt_device_register_ep(uint8_t ep, k_tid_t dev_tid);
+
 /**
  * @brief Registers a link thread with the DLT interface.
  *
@@ -75,12 +223,19 @@ extern void dlt_link_register(uint8_t ep, k_tid_t link_tid);
  *
  * @param ep Endpoint identifier for the link.
  * @param packet Pointer to a buffer used for storing and transferring the DLT encoded packet.
+ *               Unused when the buffer pool transport is enabled.
  * @param data Pointer to the data payload.
- * @param data_len Length of the data payload.
+ * @param data_len Length of the data payload. With fragmentation enabled,
+ *                 payloads that do not fit the link MTU are split into
+ *                 fragments, up to CONFIG_DLT_MAX_MESSAGE_LEN bytes.
  * @param async If true, the transfer is asynchronous; otherwise, it is synchronous.
+ *              With the mailbox transport an async @p packet must not be reused
+ *              until the link has read it. The buffer pool transports copy
+ *              @p data, so it may be reused as soon as the call returns; use
+ *              dlt_buf_set_done() with the buffer API to track completion.
  */
 extern void dlt_request(uint8_t ep, uint8_t *packet, uint8_t *data,
-                        uint8_t data_len, bool async);
+                        uint16_t data_len, bool async);
 
 /**
  * @brief Sends a DLT response from a device to a link for data transfer..
@@ -89,17 +244,26 @@ extern void dlt_request(uint8_t ep, uint8_t *packet, uint8_t *data,
  *
  * @param ep Endpoint identifier for the link.
  * @param packet Pointer to a buffer used for storing and transferring the DLT encoded packet.
+ *               Unused when the buffer pool transport is enabled.
  * @param data Pointer to the data payload.
  * @param data_len Length of the data payload.
  * @param async If true, the transfer is asynchronous; otherwise, it is synchronous.
+ *              With the mailbox transport an async @p packet must not be reused
+ *              until the link has read it. The buffer pool transports copy
+ *              @p data, so it may be reused as soon as the call returns; use
+ *              dlt_buf_set_done() with the buffer API to track completion.
  */
 extern void dlt_respond(uint8_t ep, uint8_t *packet, uint8_t *data,
-                        uint8_t data_len, bool async);
+                        uint16_t data_len, bool async);
 
 /**
  * @brief Reads data from a link for a device.
  *
- * This function reads data from a link for a device.
+ * This function reads data from a link for a device. With fragmentation
+ * enabled, fragmented messages are reassembled directly into @p data; once
+ * the first fragment is read, the call waits up to
+ * CONFIG_DLT_REASSEMBLY_TIMEOUT_MS for the rest. Whole packets received
+ * between the fragments are left queued for the next read.
  *
  * @param ep Endpoint identifier for the link.
  * @param msg_type Pointer to store the message type.
@@ -108,8 +272,8 @@ extern void dlt_respond(uint8_t ep, uint8_t *packet, uint8_t *data,
  * @param timeout Timeout value for reading data.
  * @return Number of bytes read, or 0 if no data is available within the timeout.
  */
-extern uint8_t dlt_read(uint8_t ep, uint8_t *msg_type, uint8_t *data,
-                        uint8_t data_len, k_timeout_t timeout);
+extern uint16_t dlt_read(uint8_t ep, uint8_t *msg_type, uint8_t *data,
+                         uint16_t data_len, k_timeout_t timeout);
 
 /**
  * @brief Submits a packet to be sent through a link.
@@ -121,7 +285,7 @@ extern uint8_t dlt_read(uint8_t ep, uint8_t *msg_type, uint8_t *data,
  * @param packet_len Length of the packet to be sent.
  * @param async If true, the submission is asynchronous; otherwise, it is synchronous.
  */
-extern void dlt_submit(uint8_t ep, uint8_t *packet, uint8_t packet_len,
+extern void dlt_submit(uint8_t ep, uint8_t *packet, uint16_t packet_len,
                        bool async);
 
 /**
@@ -135,7 +299,361 @@ extern void dlt_submit(uint8_t ep, uint8_t *packet, uint8_t packet_len,
  * @param timeout Timeout value for polling.
  * @return Number of bytes received, or 0 if no packet is available within the timeout.
  */
-extern uint8_t dlt_poll(uint8_t ep, uint8_t *packet, uint8_t packet_len,
-                        k_timeout_t timeout);
+extern uint16_t dlt_poll(uint8_t ep, uint8_t *packet, uint16_t packet_len,
+                         k_timeout_t timeout);
+
+#ifdef CONFIG_DLT_BUF_POOL
+/**
+ * @brief Sets the largest packet a link can transmit in one transfer.
+ *
+ * Packets queued for the link that are larger than @p mtu are split into
+ * fragments when fragmentation is enabled, and rejected otherwise. Links
+ * start with an MTU of DLT_MAX_PACKET_LEN and may update it at any time,
+ * e.g. after a BLE ATT MTU exchange.
+ *
+ * @param ep Endpoint identifier for the link.
+ * @param mtu Largest packet length, DLT header included.
+ */
+extern void dlt_link_set_mtu(uint8_t ep, uint16_t mtu);
+
+/**
+ * @brief Sets the flow control parameters of a link.
+ *
+ * Each packet queued for the link and not yet taken by it uses one of
+ * @p depth credits. Sending with no credits left applies @p policy; the
+ * dropped packet's completion callback sees -ENOBUFS and the send returns
+ * -ENOBUFS if it was the one dropped. Sends never block on a full link.
+ * Packets dropped from the queue still hold a pool buffer until the link
+ * discards them, at most @p depth of them per link. A fragmented message
+ * needs credits for all of its fragments, otherwise it is dropped whole.
+ *
+ * Call before the link starts transmitting. Links start with a depth of
+ * CONFIG_DLT_BUF_COUNT and DLT_OVERFLOW_DROP_NEWEST.
+ *
+ * @param ep Endpoint identifier for the link.
+ * @param depth Queue depth in packets, 1 to CONFIG_DLT_BUF_COUNT.
+ * @param policy Overflow policy.
+ * @return 0 on success, -EINVAL if @p depth is out of range.
+ */
+extern int dlt_link_set_flow(uint8_t ep, uint8_t depth,
+                             enum dlt_overflow policy);
+
+/**
+ * @brief Gets the number of packets a device can send to a link.
+ *
+ * Lets a device throttle or prioritise what it sends while the link is
+ * congested, instead of relying on the overflow policy.
+ *
+ * @param ep Endpoint identifier for the link.
+ * @return Remaining credits.
+ */
+extern int dlt_link_credits(uint8_t ep);
+
+/* Route packets of any message type */
+#define DLT_ROUTE_ANY 0x00
+
+/**
+ * @brief Routes packets received on one link straight to another link.
+ *
+ * Packets submitted by link @p src with message type @p msg_type, or any
+ * type for DLT_ROUTE_ANY, are queued for link @p dst as if a device had
+ * forwarded them, without waking a device. Containers are split first and
+ * each packet is routed on its own; fragments are routed by the message
+ * type they carry and forwarded unchanged. Control packets are never
+ * routed. The first matching route applies.
+ *
+ * Add routes before the links start. @p dst takes a lock around each send
+ * from then on, as it has more than one sender.
+ *
+ * @param src Endpoint identifier of the receiving link.
+ * @param msg_type Message type to route, or DLT_ROUTE_ANY.
+ * @param dst Endpoint identifier of the sending link.
+ * @return 0 on success, -EINVAL for an invalid endpoint or message type,
+ *         -ENOMEM if all CONFIG_DLT_MAX_ROUTES routes are in use.
+ */
+extern int dlt_route_add(uint8_t src, uint8_t msg_type, uint8_t dst);
+
+/**
+ * @brief Removes the routes from a link.
+ *
+ * @param src Endpoint identifier of the receiving link.
+ * @param msg_type Message type of the route, or DLT_ROUTE_ANY.
+ * @return 0 on success, -ENOENT if there was no such route.
+ */
+extern int dlt_route_remove(uint8_t src, uint8_t msg_type);
+
+#ifdef CONFIG_DLT_STATS
+/* Latency histogram bins, bin n counts latencies in [2^(n-1), 2^n) us */
+#define DLT_STATS_HIST_BINS 16
+
+/* Version of the binary statistics dump */
+#define DLT_STATS_VERSION 2
+
+/* Length of a binary statistics dump for n endpoints */
+#define DLT_STATS_HEADER_LEN 3
+#define DLT_STATS_RECORD_LEN (6 * 4 + 2 * 2 + 2 * DLT_STATS_HIST_BINS * 4 + \
+                              2 * 4 + 2 * 2)
+#define DLT_STATS_DUMP_LEN(n) (DLT_STATS_HEADER_LEN + (n) * DLT_STATS_RECORD_LEN)
+
+/**
+ * @brief Link parameters negotiated with the peer, as reported by the Link.
+ *
+ * Fields a link doesn't have are 0.
+ */
+struct dlt_link_info {
+    uint32_t bit_rate;       /* Physical layer bit rate (bit/s) */
+    uint32_t interval_us;    /* Connection interval */
+    uint16_t latency;        /* Connection events the peripheral may skip */
+    uint16_t data_len;       /* Largest link layer payload (bytes) */
+};
+
+/**
+ * @brief Statistics for one endpoint.
+ *
+ * TX counts packets from the device taken by the link, RX counts packets
+ * from the link taken by the device. Latencies run from when a packet is
+ * queued to when it is taken.
+ */
+struct dlt_stats {
+    uint32_t tx_msgs;
+    uint32_t tx_bytes;
+    uint32_t rx_msgs;
+    uint32_t rx_bytes;
+    uint32_t drops;          /* Packets dropped, for any reason */
+    uint32_t truncations;    /* Reads with a buffer too small for the packet */
+    uint16_t tx_max_depth;   /* Most packets queued for the link at once */
+    uint16_t rx_max_depth;   /* Most packets queued for the device at once */
+    uint32_t tx_latency[DLT_STATS_HIST_BINS];
+    uint32_t rx_latency[DLT_STATS_HIST_BINS];
+    struct dlt_link_info link;  /* Current link parameters, not reset */
+};
+
+/**
+ * @brief Reports the current parameters of a Link for its statistics.
+ *
+ * Links call this whenever the parameters change, e.g. on a BLE PHY or
+ * connection parameter update.
+ *
+ * @param ep Endpoint identifier.
+ * @param info Link parameters.
+ */
+extern void dlt_link_set_info(uint8_t ep, const struct dlt_link_info *info);
+
+/**
+ * @brief Takes a snapshot of the statistics of an endpoint.
+ *
+ * @param ep Endpoint identifier.
+ * @param stats Snapshot to fill.
+ * @return 0 on success, -EINVAL if @p ep was not initialised.
+ */
+extern int dlt_stats_get(uint8_t ep, struct dlt_stats *stats);
+
+/**
+ * @brief Clears the statistics of an endpoint.
+ *
+ * @param ep Endpoint identifier.
+ */
+extern void dlt_stats_reset(uint8_t ep);
+
+/**
+ * @brief Gets the number of endpoints the interface was initialised with.
+ *
+ * @return Number of endpoints.
+ */
+extern uint8_t dlt_stats_endpoints(void);
+
+/**
+ * @brief Encodes the statistics of all endpoints as a binary dump.
+ *
+ * The dump is the reply to a DLT_CTRL_STATS control packet: a header of
+ * version, endpoint count and histogram bin count, then per endpoint the
+ * fields of struct dlt_stats in order, link parameters included, little
+ * endian, without padding.
+ *
+ * @param out Buffer to encode into.
+ * @param len Size of @p out.
+ * @return Number of bytes written, or -ENOMEM if @p out is too small.
+ */
+extern int dlt_stats_encode(uint8_t *out, size_t len);
+#endif
+
+#ifdef CONFIG_DLT_AGGREGATION
+/**
+ * @brief Enables packing of queued packets into container packets for a link.
+ *
+ * While enabled, dlt_poll_buf() and dlt_poll() on @p ep append the packets
+ * queued behind the first one into a single container packet, up to the link
+ * MTU, waiting up to the link's aggregation window for more packets to
+ * arrive. The receiving side must split containers, which dlt_submit_buf()
+ * and dlt_submit() always do.
+ *
+ * @param ep Endpoint identifier for the link.
+ * @param enable true to aggregate packets, false to send them one by one.
+ */
+extern void dlt_link_set_aggregation(uint8_t ep, bool enable);
+
+/**
+ * @brief Sets how long aggregation on a link waits for more packets.
+ *
+ * Links start with CONFIG_DLT_AGGREGATION_WINDOW_US. A Link thread that
+ * serves several endpoints should set 0, so that only packets already
+ * queued are packed and one endpoint never holds up the others.
+ *
+ * @param ep Endpoint identifier for the link.
+ * @param window_us Longest wait for another packet, in microseconds.
+ */
+extern void dlt_link_set_aggregation_window(uint8_t ep, uint32_t window_us);
+#endif
+
+/**
+ * @brief Allocates a packet buffer from the DLT buffer pool.
+ *
+ * Devices write their payload directly into dlt_buf_data() and Links receive
+ * directly into dlt_buf::packet, so the packet is only written once.
+ *
+ * @param timeout Time to wait for a free buffer.
+ * @return Pointer to the buffer, or NULL if none became available.
+ */
+extern struct dlt_buf *dlt_buf_alloc(k_timeout_t timeout);
+
+/**
+ * @brief Returns a packet buffer to the DLT buffer pool.
+ *
+ * Runs the buffer's completion callback, if any, with a status of 0.
+ *
+ * @param buf Buffer to release. The caller must own the buffer.
+ */
+extern void dlt_buf_free(struct dlt_buf *buf);
+
+/**
+ * @brief Returns a packet buffer to the pool and reports the transfer result.
+ *
+ * Used by links to release a buffer they failed to transmit, so the sender's
+ * completion callback sees the error. Safe to call from interrupt context.
+ *
+ * @param buf Buffer to release. The caller must own the buffer.
+ * @param status 0 on success, negative errno on failure.
+ */
+extern void dlt_buf_complete(struct dlt_buf *buf, int status);
+
+/**
+ * @brief Completion callback that gives the semaphore in @p user_data.
+ *
+ * Lets a device wait for sends with a semaphore instead of a callback:
+ * dlt_buf_set_done(buf, dlt_buf_done_give, &sem). Counting semaphores allow
+ * several sends in flight.
+ *
+ * @param status Transfer result, ignored.
+ * @param user_data Pointer to a struct k_sem.
+ */
+extern void dlt_buf_done_give(int status, void *user_data);
+
+/**
+ * @brief Sends a DLT request from a device to a link without copying.
+ *
+ * The DLT header is written in place in front of the data segment and the
+ * buffer is queued for the link. Ownership of @p buf always passes to DLT,
+ * including on failure.
+ * If the packet exceeds the link MTU, it is copied into fragments instead.
+ *
+ * @param ep Endpoint identifier for the link.
+ * @param buf Buffer whose data segment holds the payload.
+ * @param data_len Length of the data payload.
+ * @return 0 on success, negative errno on failure.
+ */
+extern int dlt_request_buf(uint8_t ep, struct dlt_buf *buf,
+                           uint16_t data_len);
+
+/**
+ * @brief Sends a DLT response from a device to a link without copying.
+ *
+ * @see dlt_request_buf()
+ *
+ * @param ep Endpoint identifier for the link.
+ * @param buf Buffer whose data segment holds the payload.
+ * @param data_len Length of the data payload.
+ * @return 0 on success, negative errno on failure.
+ */
+extern int dlt_respond_buf(uint8_t ep, struct dlt_buf *buf,
+                           uint16_t data_len);
+
+/**
+ * @brief Forwards an already encoded packet from a device to a link.
+ *
+ * Used by devices to pass a packet read from one link straight on to another
+ * link, header included, without re-encoding it. Packets larger than the
+ * destination link MTU are fragmented. Ownership of @p buf always passes to
+ * DLT.
+ *
+ * @param ep Endpoint identifier for the destination link.
+ * @param buf Buffer holding an encoded DLT packet.
+ * @return 0 on success, negative errno on failure.
+ */
+extern int dlt_forward(uint8_t ep, struct dlt_buf *buf);
+
+/**
+ * @brief Submits a received packet buffer to the device without copying.
+ *
+ * dlt_buf::len must hold the number of bytes received into dlt_buf::packet.
+ * The packet is validated before it is queued, and container packets are
+ * split into the packets they carry. Ownership of @p buf always passes to
+ * DLT.
+ *
+ * @param ep Endpoint identifier for the link.
+ * @param buf Buffer holding the received packet.
+ * @return 0 on success, negative errno on failure.
+ */
+extern int dlt_submit_buf(uint8_t ep, struct dlt_buf *buf);
+
+/**
+ * @brief Reads a packet buffer from a link for a device.
+ *
+ * The caller takes ownership of the returned buffer and must either free it
+ * or pass it on, e.g. with dlt_forward(). Fragments are returned as they
+ * were received; use dlt_read() to reassemble fragmented messages.
+ *
+ * @param ep Endpoint identifier for the link.
+ * @param timeout Timeout value for reading data.
+ * @return Pointer to the buffer, or NULL if no packet is available.
+ */
+extern struct dlt_buf *dlt_read_buf(uint8_t ep, k_timeout_t timeout);
+
+/**
+ * @brief Polls for a packet buffer to transmit on a link.
+ *
+ * The caller takes ownership of the returned buffer and must free it once
+ * the packet has been transmitted.
+ *
+ * @param ep Endpoint identifier for the link.
+ * @param timeout Timeout value for polling.
+ * @return Pointer to the buffer, or NULL if no packet is available.
+ */
+extern struct dlt_buf *dlt_poll_buf(uint8_t ep, k_timeout_t timeout);
+
+/**
+ * @brief Initialises a poll event for packets a device can read.
+ *
+ * The event becomes ready when dlt_read_buf() or dlt_read() on @p ep has a
+ * packet, so a device thread can wait on DLT alongside other kernel objects
+ * in a single k_poll() call. After k_poll() returns, read with K_NO_WAIT and
+ * set the event state back to K_POLL_STATE_NOT_READY before polling again.
+ * The event stays ready while packets remain queued.
+ *
+ * @param ep Endpoint identifier for the link.
+ * @param evt Poll event to initialise.
+ */
+extern void dlt_read_event_init(uint8_t ep, struct k_poll_event *evt);
+
+/**
+ * @brief Initialises a poll event for packets a link can transmit.
+ *
+ * The link side counterpart of dlt_read_event_init(); the event becomes ready
+ * when dlt_poll_buf() or dlt_poll() on @p ep has a packet.
+ *
+ * @param ep Endpoint identifier for the link.
+ * @param evt Poll event to initialise.
+ */
+extern void dlt_poll_event_init(uint8_t ep, struct k_poll_event *evt);
+#endif
 
 #endif // DLT_API_H_
\ No newline at end of file
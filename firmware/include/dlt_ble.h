@@ -0,0 +1,101 @@
+/**
+ * @file dlt_ble.h
+ *
+ * @brief BLE connection profiles for DLT links.
+ *
+ * A BLE link's latency and throughput are set by its connection parameters,
+ * not by DLT. The performance profile asks for the 2M PHY, the largest link
+ * layer data length, a short connection interval and no peripheral latency,
+ * so notifications go out within a few milliseconds and several fit in each
+ * connection event. The range profile keeps the 1M PHY, the default data
+ * length and a longer interval and supervision timeout, which survive a
+ * weaker signal.
+ *
+ * Both ends of a link track its profile: a connection starts on the
+ * performance profile, falls back to the range profile after a supervision
+ * timeout, and tries the performance profile again once a range connection
+ * has been stable for CONFIG_DLT_BLE_UPGRADE_DELAY_S. The parameters the
+ * controllers settle on are reported to the endpoint's statistics.
+ */
+
+#ifndef DLT_BLE_H_
+#define DLT_BLE_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/conn.h>
+
+#ifdef CONFIG_DLT_BLE
+/**
+ * @brief Connection profiles, fastest first.
+ */
+enum dlt_ble_profile {
+    DLT_BLE_PROFILE_PERFORMANCE,
+    DLT_BLE_PROFILE_RANGE,
+};
+
+/**
+ * @brief Profile state for one BLE link.
+ */
+struct dlt_ble_link {
+    uint8_t ep;                        /* Endpoint statistics are kept for */
+    enum dlt_ble_profile profile;      /* Profile of the next connection */
+    struct bt_conn *conn;              /* Current connection, or NULL */
+    struct k_work_delayable upgrade;   /* Retries the performance profile */
+};
+
+/**
+ * @brief Initialises the profile state of a link.
+ *
+ * @param link Link state.
+ * @param ep Endpoint identifier of the link.
+ */
+extern void dlt_ble_link_init(struct dlt_ble_link *link, uint8_t ep);
+
+/**
+ * @brief Returns the connection parameters of the link's current profile.
+ *
+ * Centrals pass these to bt_conn_le_create() so the connection starts on
+ * the profile rather than switching after it is up.
+ *
+ * @param link Link state.
+ */
+extern const struct bt_le_conn_param *dlt_ble_conn_param(
+    const struct dlt_ble_link *link);
+
+/**
+ * @brief Requests the link's profile on a new connection.
+ *
+ * Requests the profile's PHY, data length and connection parameters. The
+ * peer and controllers may settle on less; the outcome arrives in the
+ * connection's update callbacks, which should call dlt_ble_updated().
+ *
+ * @param link Link state.
+ * @param conn New connection.
+ *
+ * @return 0 on success, or the first error from the Bluetooth stack.
+ */
+extern int dlt_ble_connected(struct dlt_ble_link *link, struct bt_conn *conn);
+
+/**
+ * @brief Records the end of the link's connection.
+ *
+ * A supervision timeout moves the link to the range profile.
+ *
+ * @param link Link state.
+ * @param reason HCI disconnect reason.
+ */
+extern void dlt_ble_disconnected(struct dlt_ble_link *link, uint8_t reason);
+
+/**
+ * @brief Reports the connection's current parameters to DLT statistics.
+ *
+ * Call from the connection's PHY, data length and parameter update
+ * callbacks.
+ *
+ * @param link Link state.
+ * @param conn Connection that was updated.
+ */
+extern void dlt_ble_updated(struct dlt_ble_link *link, struct bt_conn *conn);
+#endif
+
+#endif /* DLT_BLE_H_ */
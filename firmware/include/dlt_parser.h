@@ -0,0 +1,99 @@
+/**
+ * @file dlt_parser.h
+ *
+ * @brief Incremental DLT frame parser for byte stream links.
+ *
+ * Links such as UART receive a stream of bytes with no frame boundaries. The
+ * parser assembles DLT frames straight into pool buffers as bytes arrive, in
+ * chunks of any size, and submits each complete frame to its endpoint. Bytes
+ * outside a frame are skipped up to the next preamble, and a frame header
+ * that cannot be valid restarts the search inside it, so the parser resyncs
+ * after line noise or lost bytes.
+ */
+
+#ifndef DLT_PARSER_H_
+#define DLT_PARSER_H_
+
+#include <zephyr/kernel.h>
+
+#include "dlt_api.h"
+
+#ifdef CONFIG_DLT_BUF_POOL
+struct dlt_parser;
+
+/**
+ * @brief Called with each complete frame before it is submitted.
+ *
+ * Lets a link handle frames meant for itself, such as link control packets.
+ *
+ * @return true if the handler took the buffer, false to submit it.
+ */
+typedef bool (*dlt_parser_handler_t)(struct dlt_parser *parser,
+                                     struct dlt_buf *buf);
+
+/**
+ * @brief Parser state for one link.
+ */
+struct dlt_parser {
+    uint8_t ep;                    /* Endpoint frames are submitted to */
+    dlt_parser_handler_t handler;  /* Optional frame handler */
+    struct dlt_buf *buf;           /* Frame in progress, NULL between frames */
+    uint32_t frames;               /* Frames completed */
+    uint32_t skipped;              /* Bytes skipped looking for a frame */
+};
+
+/**
+ * @brief Initialises a parser.
+ *
+ * @param parser Parser to initialise.
+ * @param ep Endpoint identifier of the link the bytes arrive on.
+ */
+extern void dlt_parser_init(struct dlt_parser *parser, uint8_t ep);
+
+/**
+ * @brief Sets the handler offered each complete frame.
+ *
+ * @param parser Parser state.
+ * @param handler Frame handler, or NULL to submit every frame.
+ */
+extern void dlt_parser_set_handler(struct dlt_parser *parser,
+                                   dlt_parser_handler_t handler);
+
+/**
+ * @brief Feeds received bytes to the parser.
+ *
+ * Every frame completed by @p data is submitted with dlt_submit_buf(),
+ * unless the parser's handler takes it. If
+ * the buffer pool is empty when a frame starts, parsing stops at its
+ * preamble; feed the remaining bytes again once buffers are free.
+ *
+ * @param parser Parser state.
+ * @param data Received bytes.
+ * @param len Number of bytes in @p data.
+ * @return Number of bytes consumed.
+ */
+extern size_t dlt_parser_feed(struct dlt_parser *parser, const uint8_t *data,
+                              size_t len);
+
+/**
+ * @brief Checks whether the parser is part way through a frame.
+ *
+ * @param parser Parser state.
+ * @return true if a frame has started but not completed.
+ */
+static inline bool dlt_parser_busy(const struct dlt_parser *parser)
+{
+    return parser->buf && parser->buf->len;
+}
+
+/**
+ * @brief Drops any partly received frame.
+ *
+ * Used by links to give up on a frame whose remaining bytes never came.
+ *
+ * @param parser Parser state.
+ */
+extern void dlt_parser_reset(struct dlt_parser *parser);
+#endif
+
+#endif // DLT_PARSER_H_
@@ -0,0 +1,239 @@
+#include <math.h>
+#include <zephyr/kernel.h>
+
+#include "adsb_predict.h"
+
+#ifdef CONFIG_ADSB_PREDICT
+#define PI 3.14159265358979323846f
+
+/* Metres per degree of latitude, on a sphere of the mean Earth radius */
+#define ADSB_PREDICT_NORTH_PER_DEG 111195.08f
+
+#define ADSB_PREDICT_FT_TO_M   0.3048f
+#define ADSB_PREDICT_KT_TO_MPS 0.514444f
+
+/* Spectral density of the unmodelled acceleration, (m/s^2)^2 per second.
+ * Covers a rate one turn or a change of speed horizontally, and the start
+ * of a climb or descent vertically */
+#define ADSB_PREDICT_Q_HORIZONTAL 4.0f
+#define ADSB_PREDICT_Q_VERTICAL   1.0f
+
+/* Variance of the reported position, m^2: ADS-B's position accuracy, and
+ * the 25 foot altitude steps */
+#define ADSB_PREDICT_R_POSITION 900.0f
+#define ADSB_PREDICT_R_ALTITUDE 50.0f
+
+/* Variance of the velocity from the whole knots and degrees reported,
+ * (m/s)^2, and of the unknown vertical rate of a new aircraft */
+#define ADSB_PREDICT_R_VELOCITY 9.0f
+#define ADSB_PREDICT_P_CLIMB    100.0f
+
+/* A report more than 5 standard deviations from the prediction restarts
+ * the filter, rather than being averaged in: the aircraft manoeuvred harder
+ * than the model allows, or the filter was never right */
+#define ADSB_PREDICT_GATE 25.0f
+
+// Convert degrees to radians
+static inline float degrees_to_radians(float degrees)
+{
+    return degrees * PI / 180.0f;
+}
+
+// Convert radians to degrees
+static inline float radians_to_degrees(float radians)
+{
+    return radians * 180.0f / PI;
+}
+
+/* Wrap a difference in longitude to [-180, 180) */
+static float adsb_predict_wrap(float dlon)
+{
+    return dlon - 360.0f * floorf((dlon + 180.0f) / 360.0f);
+}
+
+/* Metres per degree of longitude, kept finite at the poles */
+static float adsb_predict_east_per_deg(float lat)
+{
+    return ADSB_PREDICT_NORTH_PER_DEG *
+           MAX(cosf(degrees_to_radians(lat)), 1e-3f);
+}
+
+/* Move an axis on by dt seconds */
+static void adsb_predict_axis_step(struct adsb_predict_axis *axis, float dt,
+                                   float q)
+{
+    axis->pos += axis->vel * dt;
+    axis->p00 += dt * (2.0f * axis->p01 + dt * axis->p11) +
+                 q * dt * dt * dt / 3.0f;
+    axis->p01 += dt * axis->p11 + q * dt * dt / 2.0f;
+    axis->p11 += q * dt;
+}
+
+/* Whether a measured position is too far from the prediction to trust it */
+static bool adsb_predict_axis_outlier(const struct adsb_predict_axis *axis,
+                                      float pos, float r_pos)
+{
+    float dpos = pos - axis->pos;
+    return dpos * dpos > ADSB_PREDICT_GATE * (axis->p00 + r_pos);
+}
+
+/* Correct an axis with a measured position and velocity */
+static void adsb_predict_axis_correct(struct adsb_predict_axis *axis,
+                                      float pos, float vel, float r_pos,
+                                      float r_vel)
+{
+    float s00 = axis->p00 + r_pos;
+    float s11 = axis->p11 + r_vel;
+    float det = s00 * s11 - axis->p01 * axis->p01;
+
+    /* Gain P (P + R)^-1 */
+    float k00 = (axis->p00 * s11 - axis->p01 * axis->p01) / det;
+    float k01 = axis->p01 * r_pos / det;
+    float k10 = axis->p01 * r_vel / det;
+    float k11 = (axis->p11 * s00 - axis->p01 * axis->p01) / det;
+
+    float dpos = pos - axis->pos;
+    float dvel = vel - axis->vel;
+    axis->pos += k00 * dpos + k01 * dvel;
+    axis->vel += k10 * dpos + k11 * dvel;
+
+    float p00 = axis->p00 - k00 * axis->p00 - k01 * axis->p01;
+    float p01 = axis->p01 - k00 * axis->p01 - k01 * axis->p11;
+    float p11 = axis->p11 - k10 * axis->p01 - k11 * axis->p11;
+    axis->p00 = p00;
+    axis->p01 = p01;
+    axis->p11 = p11;
+}
+
+/* Correct an axis with a measured position alone */
+static void adsb_predict_axis_correct_pos(struct adsb_predict_axis *axis,
+                                          float pos, float r_pos)
+{
+    float s = axis->p00 + r_pos;
+    float k0 = axis->p00 / s;
+    float k1 = axis->p01 / s;
+
+    float dpos = pos - axis->pos;
+    axis->pos += k0 * dpos;
+    axis->vel += k1 * dpos;
+
+    axis->p11 -= k1 * axis->p01;
+    axis->p01 -= k0 * axis->p01;
+    axis->p00 -= k0 * axis->p00;
+}
+
+extern void adsb_predict_init(struct adsb_predict *predict,
+                              const struct adsb_predict_fix *fix,
+                              uint32_t now_ms)
+{
+    float speed = fix->speed * ADSB_PREDICT_KT_TO_MPS;
+    float track = degrees_to_radians(fix->track);
+
+    predict->lat = fix->lat;
+    predict->lon = fix->lon;
+    predict->east_per_deg = adsb_predict_east_per_deg(fix->lat);
+
+    predict->north = (struct adsb_predict_axis){
+        .vel = speed * cosf(track),
+        .p00 = ADSB_PREDICT_R_POSITION,
+        .p11 = ADSB_PREDICT_R_VELOCITY,
+    };
+    predict->east = (struct adsb_predict_axis){
+        .vel = speed * sinf(track),
+        .p00 = ADSB_PREDICT_R_POSITION,
+        .p11 = ADSB_PREDICT_R_VELOCITY,
+    };
+    predict->up = (struct adsb_predict_axis){
+        .pos = fix->altitude * ADSB_PREDICT_FT_TO_M,
+        .p00 = ADSB_PREDICT_R_ALTITUDE,
+        .p11 = ADSB_PREDICT_P_CLIMB,
+    };
+
+    predict->updated_ms = now_ms;
+    predict->valid = true;
+}
+
+extern void adsb_predict_update(struct adsb_predict *predict,
+                                const struct adsb_predict_fix *fix,
+                                uint32_t now_ms)
+{
+    if (!predict->valid) {
+        adsb_predict_init(predict, fix, now_ms);
+        return;
+    }
+
+    /* Reports more than the horizon apart start afresh, as the
+     * prediction stopped there */
+    float dt = (now_ms - predict->updated_ms) / 1000.0f;
+    if (dt > CONFIG_ADSB_PREDICT_HORIZON_S) {
+        adsb_predict_init(predict, fix, now_ms);
+        return;
+    }
+
+    adsb_predict_axis_step(&predict->north, dt, ADSB_PREDICT_Q_HORIZONTAL);
+    adsb_predict_axis_step(&predict->east, dt, ADSB_PREDICT_Q_HORIZONTAL);
+    adsb_predict_axis_step(&predict->up, dt, ADSB_PREDICT_Q_VERTICAL);
+
+    /* The report relative to the previous one */
+    float north = (fix->lat - predict->lat) * ADSB_PREDICT_NORTH_PER_DEG;
+    float east = adsb_predict_wrap(fix->lon - predict->lon) *
+                 predict->east_per_deg;
+    float altitude = fix->altitude * ADSB_PREDICT_FT_TO_M;
+    float speed = fix->speed * ADSB_PREDICT_KT_TO_MPS;
+    float track = degrees_to_radians(fix->track);
+
+    if (adsb_predict_axis_outlier(&predict->north, north,
+                                  ADSB_PREDICT_R_POSITION) ||
+        adsb_predict_axis_outlier(&predict->east, east,
+                                  ADSB_PREDICT_R_POSITION) ||
+        adsb_predict_axis_outlier(&predict->up, altitude,
+                                  ADSB_PREDICT_R_ALTITUDE)) {
+        adsb_predict_init(predict, fix, now_ms);
+        return;
+    }
+
+    adsb_predict_axis_correct(&predict->north, north, speed * cosf(track),
+                              ADSB_PREDICT_R_POSITION,
+                              ADSB_PREDICT_R_VELOCITY);
+    adsb_predict_axis_correct(&predict->east, east, speed * sinf(track),
+                              ADSB_PREDICT_R_POSITION,
+                              ADSB_PREDICT_R_VELOCITY);
+    adsb_predict_axis_correct_pos(&predict->up, altitude,
+                                  ADSB_PREDICT_R_ALTITUDE);
+
+    /* Measure from this report from now on */
+    predict->north.pos -= north;
+    predict->east.pos -= east;
+    predict->lat = fix->lat;
+    predict->lon = fix->lon;
+    predict->east_per_deg = adsb_predict_east_per_deg(fix->lat);
+    predict->updated_ms = now_ms;
+}
+
+extern void adsb_predict_at(const struct adsb_predict *predict,
+                            uint32_t now_ms, struct adsb_predict_fix *fix)
+{
+    /* Hold the aircraft beyond the horizon, and before its latest report */
+    int32_t age_ms = now_ms - predict->updated_ms;
+    float dt = CLAMP(age_ms, 0, CONFIG_ADSB_PREDICT_HORIZON_S * 1000) /
+               1000.0f;
+
+    float north = predict->north.pos + predict->north.vel * dt;
+    float east = predict->east.pos + predict->east.vel * dt;
+    float up = predict->up.pos + predict->up.vel * dt;
+
+    fix->lat = predict->lat + north / ADSB_PREDICT_NORTH_PER_DEG;
+    fix->lon = predict->lon + east / predict->east_per_deg;
+    fix->lon = adsb_predict_wrap(fix->lon);
+    fix->altitude = up / ADSB_PREDICT_FT_TO_M;
+
+    float speed = sqrtf(predict->north.vel * predict->north.vel +
+                        predict->east.vel * predict->east.vel);
+    fix->speed = speed / ADSB_PREDICT_KT_TO_MPS;
+    fix->track = radians_to_degrees(atan2f(predict->east.vel,
+                                           predict->north.vel));
+    if (fix->track < 0) {
+        fix->track += 360.0f;
+    }
+}
+#endif // CONFIG_ADSB_PREDICT
@@ -1,15 +1,382 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
 
 #include "dlt_api.h"
 
 LOG_MODULE_REGISTER(dlt_api, LOG_LEVEL_ERR);
 
+#ifdef CONFIG_DLT_BUF_POOL
+#ifdef CONFIG_DLT_TRANSPORT_SPSC
+/* Ring size, the pool bounds the number of queued buffers so it never fills */
+#define DLT_RING_SIZE CONFIG_DLT_BUF_COUNT
+BUILD_ASSERT(IS_POWER_OF_TWO(DLT_RING_SIZE),
+             "CONFIG_DLT_BUF_COUNT must be a power of two");
+
+/*
+ * Single-producer/single-consumer ring of buffer references. The producer
+ * only writes head and the consumer only writes tail, so neither side needs
+ * a lock. The signal wakes a consumer sleeping on an empty ring.
+ */
+struct dlt_queue {
+    atomic_t head;
+    atomic_t tail;
+    struct k_poll_signal signal;
+    struct dlt_buf *slots[DLT_RING_SIZE];
+};
+
+static inline void dlt_queue_init(struct dlt_queue *q)
+{
+    atomic_set(&q->head, 0);
+    atomic_set(&q->tail, 0);
+    k_poll_signal_init(&q->signal);
+}
+
+static inline void dlt_queue_put(struct dlt_queue *q, struct dlt_buf *buf)
+{
+    atomic_val_t head = atomic_get(&q->head);
+
+    /* Fill the slot before publishing it to the consumer */
+    q->slots[head & (DLT_RING_SIZE - 1)] = buf;
+    atomic_set(&q->head, head + 1);
+
+    k_poll_signal_raise(&q->signal, 0);
+}
+
+/* Look at the oldest buffer without taking it, consumer only */
+static inline struct dlt_buf *dlt_queue_peek(struct dlt_queue *q)
+{
+    atomic_val_t tail = atomic_get(&q->tail);
+
+    if (tail == atomic_get(&q->head)) {
+        return NULL;
+    }
+    return q->slots[tail & (DLT_RING_SIZE - 1)];
+}
+
+/* Wait until the ring holds a buffer, consumer only */
+static bool dlt_queue_wait(struct dlt_queue *q, k_timeout_t timeout)
+{
+    struct k_poll_event evt = K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SIGNAL,
+                                                       K_POLL_MODE_NOTIFY_ONLY,
+                                                       &q->signal);
+
+    while (true) {
+        if (dlt_queue_peek(q)) {
+            return true;
+        }
+
+        /* Clear the signal, then check again so a put that raced with the
+         * reset is not slept through */
+        k_poll_signal_reset(&q->signal);
+        if (dlt_queue_peek(q)) {
+            return true;
+        }
+
+        if (K_TIMEOUT_EQ(timeout, K_NO_WAIT) || k_poll(&evt, 1, timeout)) {
+            return false;
+        }
+        evt.state = K_POLL_STATE_NOT_READY;
+    }
+}
+
+static struct dlt_buf *dlt_queue_get(struct dlt_queue *q, k_timeout_t timeout)
+{
+    if (!dlt_queue_wait(q, timeout)) {
+        return NULL;
+    }
+
+    /* Take the slot before handing it back to the producer */
+    atomic_val_t tail = atomic_get(&q->tail);
+    struct dlt_buf *buf = q->slots[tail & (DLT_RING_SIZE - 1)];
+    atomic_set(&q->tail, tail + 1);
+    return buf;
+}
+
+/*
+ * Put a taken buffer back at the head of the ring, consumer only. The ring
+ * never holds more than the pool, so with the buffer and whatever the
+ * producer is putting out of the ring, the slot before the tail is free.
+ */
+static inline void dlt_queue_unget(struct dlt_queue *q, struct dlt_buf *buf)
+{
+    atomic_val_t tail = atomic_get(&q->tail) - 1;
+
+    q->slots[tail & (DLT_RING_SIZE - 1)] = buf;
+    atomic_set(&q->tail, tail);
+
+    k_poll_signal_raise(&q->signal, 0);
+}
+
+static inline void dlt_queue_event_init(struct dlt_queue *q,
+                                        struct k_poll_event *evt)
+{
+    k_poll_event_init(evt, K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY,
+                      &q->signal);
+}
+#else
+/* Kernel FIFO of buffer references */
+struct dlt_queue {
+    struct k_fifo fifo;
+};
+
+static inline void dlt_queue_init(struct dlt_queue *q)
+{
+    k_fifo_init(&q->fifo);
+}
+
+static inline void dlt_queue_put(struct dlt_queue *q, struct dlt_buf *buf)
+{
+    k_fifo_put(&q->fifo, buf);
+}
+
+static inline struct dlt_buf *dlt_queue_get(struct dlt_queue *q,
+                                            k_timeout_t timeout)
+{
+    return k_fifo_get(&q->fifo, timeout);
+}
+
+/* Look at the oldest buffer without taking it, consumer only */
+static inline struct dlt_buf *dlt_queue_peek(struct dlt_queue *q)
+{
+    return k_fifo_peek_head(&q->fifo);
+}
+
+/* Wait until the FIFO holds a buffer */
+static inline bool dlt_queue_wait(struct dlt_queue *q, k_timeout_t timeout)
+{
+    struct k_poll_event evt = K_POLL_EVENT_INITIALIZER(
+        K_POLL_TYPE_FIFO_DATA_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY, &q->fifo);
+
+    return k_poll(&evt, 1, timeout) == 0;
+}
+
+/* Put a taken buffer back at the head of the FIFO */
+static inline void dlt_queue_unget(struct dlt_queue *q, struct dlt_buf *buf)
+{
+    k_queue_prepend(&q->fifo._queue, buf);
+}
+
+static inline void dlt_queue_event_init(struct dlt_queue *q,
+                                        struct k_poll_event *evt)
+{
+    k_poll_event_init(evt, K_POLL_TYPE_FIFO_DATA_AVAILABLE,
+                      K_POLL_MODE_NOTIFY_ONLY, &q->fifo);
+}
+#endif
+
+/* Most recent queued buffer for a coalescing key */
+struct dlt_coalesce_slot {
+    uint32_t key;
+    atomic_val_t ticket;
+    struct dlt_buf *buf;
+};
+
+#ifdef CONFIG_DLT_STATS
+/* Live statistics, updated by both the device and the link */
+struct dlt_ep_stats {
+    atomic_t tx_msgs;
+    atomic_t tx_bytes;
+    atomic_t rx_msgs;
+    atomic_t rx_bytes;
+    atomic_t drops;
+    atomic_t truncations;
+    atomic_t tx_max_depth;
+    atomic_t rx_max_depth;
+    atomic_t rx_depth;
+    atomic_t tx_latency[DLT_STATS_HIST_BINS];
+    atomic_t rx_latency[DLT_STATS_HIST_BINS];
+    struct dlt_link_info link;  /* Guarded by dlt_link_info_lock */
+};
+
+static struct k_spinlock dlt_link_info_lock;
+#endif
+
+/* Buffer reference queues and link parameters for each endpoint */
+struct dlt_endpoint {
+    struct dlt_queue to_link;
+    struct dlt_queue to_device;
+    uint16_t mtu;
+    uint8_t frag_msg_id;
+    bool aggregate;
+    uint32_t window_us;         /* Aggregation window */
+    atomic_t backlog;
+    uint8_t depth;
+    enum dlt_overflow policy;
+    struct dlt_coalesce_slot coalesce[CONFIG_DLT_COALESCE_SLOTS];
+    bool routed;                /* Routes start at this link */
+    bool shared;                /* More than one thread sends to this link */
+    struct k_mutex lock;        /* Serialises senders of a shared link */
+#ifdef CONFIG_DLT_STATS
+    struct dlt_ep_stats stats;
+#endif
+};
+
+/* Link-to-link route, packets of msg_type received on src are sent on dst */
+struct dlt_route {
+    uint8_t src;
+    uint8_t msg_type;
+    uint8_t dst;
+};
+
+/*
+ * The link queue backlog counts live buffers in the low half and dropped
+ * buffers still waiting for the link to discard them in the high half, so
+ * both change in one atomic operation.
+ */
+#define DLT_BACKLOG_DROPPED_ONE (1 << 16)
+#define DLT_BACKLOG_LIVE(v)     ((v) & 0xFFFF)
+#define DLT_BACKLOG_DROPPED(v)  ((v) >> 16)
+
+/* Smallest MTU that still carries a byte of fragment payload */
+#define DLT_MIN_MTU (DLT_PROTOCOL_BYTES + DLT_FRAGMENT_HEADER_LEN + 1)
+
+#ifdef CONFIG_DLT_FRAGMENTATION
+/* Fragment header field offsets within the data segment */
+#define DLT_FRAG_MSG_ID 0
+#define DLT_FRAG_INDEX  1
+#define DLT_FRAG_TOTAL  2
+
+/* The fragment index is a single byte */
+#define DLT_FRAG_MAX_COUNT 256
+#endif
+
+static struct dlt_endpoint eps[DLT_MAX_ENDPOINTS];
+
+static uint8_t num_eps;
+
+/* Routes in the order they were added */
+static struct dlt_route routes[CONFIG_DLT_MAX_ROUTES];
+static uint8_t num_routes;
+
+/* Packet buffer pool shared by all endpoints */
+K_MEM_SLAB_DEFINE_STATIC(dlt_buf_pool, sizeof(struct dlt_buf),
+                         CONFIG_DLT_BUF_COUNT, 4);
+
+/* Coalescing tickets, shared by all endpoints like the buffers they mark */
+static atomic_t dlt_tickets;
+
+#ifdef CONFIG_DLT_STATS
+/* Raise a high-water mark */
+static inline void dlt_stats_max(atomic_t *max, atomic_val_t value)
+{
+    atomic_val_t old;
+
+    do {
+        old = atomic_get(max);
+        if (value <= old) {
+            return;
+        }
+    } while (!atomic_cas(max, old, value));
+}
+
+/* Count a packet taken from a queue and bin the time it spent queued */
+static void dlt_stats_taken(atomic_t *msgs, atomic_t *bytes, atomic_t *hist,
+                            const struct dlt_buf *buf)
+{
+    uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - buf->stamp);
+    int bin = us ? 32 - __builtin_clz(us) : 0;
+
+    atomic_inc(msgs);
+    atomic_add(bytes, buf->len);
+    atomic_inc(&hist[MIN(bin, DLT_STATS_HIST_BINS - 1)]);
+}
+
+static inline void dlt_stats_drop(struct dlt_endpoint *e)
+{
+    atomic_inc(&e->stats.drops);
+}
+
+static inline void dlt_stats_truncation(struct dlt_endpoint *e)
+{
+    atomic_inc(&e->stats.truncations);
+}
+
+static inline void dlt_stats_tx_queued(struct dlt_endpoint *e,
+                                       struct dlt_buf *buf, atomic_val_t depth)
+{
+    buf->stamp = k_cycle_get_32();
+    dlt_stats_max(&e->stats.tx_max_depth, depth);
+}
+
+static inline void dlt_stats_tx_taken(struct dlt_endpoint *e,
+                                      const struct dlt_buf *buf)
+{
+    dlt_stats_taken(&e->stats.tx_msgs, &e->stats.tx_bytes,
+                    e->stats.tx_latency, buf);
+}
+
+static inline void dlt_stats_rx_queued(struct dlt_endpoint *e,
+                                       struct dlt_buf *buf)
+{
+    buf->stamp = k_cycle_get_32();
+    dlt_stats_max(&e->stats.rx_max_depth, atomic_inc(&e->stats.rx_depth) + 1);
+}
+
+static inline void dlt_stats_rx_taken(struct dlt_endpoint *e,
+                                      const struct dlt_buf *buf)
+{
+    atomic_dec(&e->stats.rx_depth);
+    dlt_stats_taken(&e->stats.rx_msgs, &e->stats.rx_bytes,
+                    e->stats.rx_latency, buf);
+}
+#else
+static inline void dlt_stats_drop(struct dlt_endpoint *e) {}
+static inline void dlt_stats_truncation(struct dlt_endpoint *e) {}
+static inline void dlt_stats_tx_queued(struct dlt_endpoint *e,
+                                       struct dlt_buf *buf,
+                                       atomic_val_t depth) {}
+static inline void dlt_stats_tx_taken(struct dlt_endpoint *e,
+                                      const struct dlt_buf *buf) {}
+static inline void dlt_stats_rx_queued(struct dlt_endpoint *e,
+                                       struct dlt_buf *buf) {}
+static inline void dlt_stats_rx_taken(struct dlt_endpoint *e,
+                                      const struct dlt_buf *buf) {}
+#endif
+#else
 /* Mailbox array for endpoints */
 struct k_mbox eps[DLT_MAX_ENDPOINTS];
+#endif
+
 static k_tid_t link_tids[DLT_MAX_ENDPOINTS];
 
 static k_tid_t device_tid;
+static k_tid_t device_tids[DLT_MAX_ENDPOINTS];
+
+/* Device thread for an endpoint */
+static inline k_tid_t dlt_device_tid(uint8_t ep)
+{
+    return device_tids[ep] ? device_tids[ep] : device_tid;
+}
+
+#ifdef CONFIG_DLT_BUF_POOL
+/*
+ * Work out which links have more than one sender: all of them once several
+ * devices share the interface, otherwise those that routes lead to.
+ */
+static void dlt_update_shared(void)
+{
+    k_tid_t first = device_tid;
+    bool many_devices = false;
+
+    for (int i = 0; i < num_eps; i++) {
+        if (!first) {
+            first = device_tids[i];
+        } else if (device_tids[i] && device_tids[i] != first) {
+            many_devices = true;
+        }
+    }
+
+    for (int i = 0; i < num_eps; i++) {
+        eps[i].routed = false;
+        eps[i].shared = many_devices;
+    }
+    for (int i = 0; i < num_routes; i++) {
+        eps[routes[i].src].routed = true;
+        eps[routes[i].dst].shared = true;
+    }
+}
+#endif
 
 /* Initialise the interface */
 extern bool dlt_interface_init(uint8_t num_endpoints)
@@ -18,11 +385,30 @@ extern bool dlt_interface_init(uint8_t num_endpoints)
         LOG_ERR("Too many endpoints.");
         return false;
     }
- 
+
+#ifdef CONFIG_DLT_BUF_POOL
+    /* Initialise the buffer queues, clearing any earlier state */
+    for (int i = 0; i < num_endpoints; i++) {
+        memset(&eps[i], 0, sizeof(eps[i]));
+        dlt_queue_init(&eps[i].to_link);
+        dlt_queue_init(&eps[i].to_device);
+        eps[i].mtu = DLT_MAX_PACKET_LEN;
+        eps[i].depth = CONFIG_DLT_BUF_COUNT;
+        eps[i].policy = DLT_OVERFLOW_DROP_NEWEST;
+#ifdef CONFIG_DLT_AGGREGATION
+        eps[i].window_us = CONFIG_DLT_AGGREGATION_WINDOW_US;
+#endif
+        k_mutex_init(&eps[i].lock);
+    }
+    num_eps = num_endpoints;
+    num_routes = 0;
+    dlt_update_shared();
+#else
     /* Initialise the mailboxes */
     for (int i = 0; i < num_endpoints; i++) {
         k_mbox_init(&eps[i]);
     }
+#endif
 
     return true;
 }
@@ -30,6 +416,23 @@ extern bool dlt_interface_init(uint8_t num_endpoints)
 extern void dlt_device_register(k_tid_t dev_tid)
 {
     device_tid =  dev_tid;
+#ifdef CONFIG_DLT_BUF_POOL
+    dlt_update_shared();
+#endif
+}
+
+extern int dlt_device_register_ep(uint8_t ep, k_tid_t dev_tid)
+{
+    if (ep >= DLT_MAX_ENDPOINTS) {
+        LOG_ERR("Invalid DLT endpoint.");
+        return -EINVAL;
+    }
+
+    device_tids[ep] = dev_tid;
+#ifdef CONFIG_DLT_BUF_POOL
+    dlt_update_shared();
+#endif
+    return 0;
 }
 
 extern void dlt_link_register(uint8_t ep, k_tid_t link_tid)
@@ -37,9 +440,957 @@ extern void dlt_link_register(uint8_t ep, k_tid_t link_tid)
     link_tids[ep] = link_tid;
 }
 
+#ifdef CONFIG_DLT_BUF_POOL
+
+extern void dlt_link_set_mtu(uint8_t ep, uint16_t mtu)
+{
+    eps[ep].mtu = CLAMP(mtu, DLT_MIN_MTU, DLT_MAX_PACKET_LEN);
+}
+
+extern int dlt_link_set_flow(uint8_t ep, uint8_t depth,
+                             enum dlt_overflow policy)
+{
+    if (depth == 0 || depth > CONFIG_DLT_BUF_COUNT) {
+        LOG_ERR("Invalid DLT queue depth.");
+        return -EINVAL;
+    }
+
+    eps[ep].depth = depth;
+    eps[ep].policy = policy;
+    return 0;
+}
+
+extern int dlt_link_credits(uint8_t ep)
+{
+    int live = DLT_BACKLOG_LIVE(atomic_get(&eps[ep].backlog));
+
+    return MAX(eps[ep].depth - live, 0);
+}
+
+extern int dlt_route_add(uint8_t src, uint8_t msg_type, uint8_t dst)
+{
+    if (src >= num_eps || dst >= num_eps || src == dst ||
+        msg_type == DLT_AGGREGATE_CODE || msg_type == DLT_CONTROL_CODE ||
+        (msg_type & DLT_FRAGMENT_FLAG)) {
+        LOG_ERR("Invalid DLT route.");
+        return -EINVAL;
+    }
+
+    if (num_routes == CONFIG_DLT_MAX_ROUTES) {
+        LOG_ERR("DLT route table full.");
+        return -ENOMEM;
+    }
+
+    routes[num_routes++] = (struct dlt_route){
+        .src = src,
+        .msg_type = msg_type,
+        .dst = dst,
+    };
+    dlt_update_shared();
+    return 0;
+}
+
+extern int dlt_route_remove(uint8_t src, uint8_t msg_type)
+{
+    int kept = 0;
+
+    for (int i = 0; i < num_routes; i++) {
+        if (routes[i].src != src || routes[i].msg_type != msg_type) {
+            routes[kept++] = routes[i];
+        }
+    }
+
+    if (kept == num_routes) {
+        return -ENOENT;
+    }
+
+    num_routes = kept;
+    dlt_update_shared();
+    return 0;
+}
+
+#ifdef CONFIG_DLT_AGGREGATION
+extern void dlt_link_set_aggregation(uint8_t ep, bool enable)
+{
+    eps[ep].aggregate = enable;
+}
+
+extern void dlt_link_set_aggregation_window(uint8_t ep, uint32_t window_us)
+{
+    eps[ep].window_us = window_us;
+}
+#endif
+
+extern struct dlt_buf *dlt_buf_alloc(k_timeout_t timeout)
+{
+    struct dlt_buf *buf;
+
+    if (k_mem_slab_alloc(&dlt_buf_pool, (void **)&buf, timeout)) {
+        LOG_WRN("DLT buffer pool exhausted.");
+        return NULL;
+    }
+
+    buf->len = 0;
+    buf->done = NULL;
+    buf->user_data = NULL;
+    buf->key = 0;
+    atomic_set(&buf->ticket, 0);
+    return buf;
+}
+
+extern void dlt_buf_complete(struct dlt_buf *buf, int status)
+{
+    dlt_buf_done_t done = buf->done;
+    void *user_data = buf->user_data;
+
+    /* Release first, so the callback can allocate the next buffer */
+    k_mem_slab_free(&dlt_buf_pool, buf);
+
+    if (done) {
+        done(status, user_data);
+    }
+}
+
+extern void dlt_buf_free(struct dlt_buf *buf)
+{
+    dlt_buf_complete(buf, 0);
+}
+
+extern void dlt_buf_done_give(int status, void *user_data)
+{
+    ARG_UNUSED(status);
+    k_sem_give((struct k_sem *)user_data);
+}
+
+/* Write the DLT header in front of the data segment of a buffer */
+static inline int dlt_buf_encode(struct dlt_buf *buf, uint8_t msg_type,
+                                 uint16_t data_len)
+{
+    if (data_len > DLT_MAX_DATA_LEN) {
+        LOG_ERR("Data is too large.");
+        return -EMSGSIZE;
+    }
+
+    buf->packet[0] = DLT_PREAMBLE;
+    buf->packet[1] = msg_type;
+    buf->packet[2] = data_len;
+    buf->len = data_len + DLT_PROTOCOL_BYTES;
+
+    return 0;
+}
+
+/* Check that a buffer holds exactly one well formed packet */
+static inline bool dlt_buf_valid(const struct dlt_buf *buf)
+{
+    return buf->len >= DLT_PROTOCOL_BYTES &&
+           buf->len <= DLT_MAX_PACKET_LEN &&
+           buf->packet[0] == DLT_PREAMBLE &&
+           buf->len == buf->packet[2] + DLT_PROTOCOL_BYTES;
+}
+
+#ifdef CONFIG_DLT_FRAGMENTATION
+/* Split a message into fragments that fit the link MTU and queue them */
+static int dlt_fragment_send(uint8_t ep, uint8_t msg_type, const uint8_t *data,
+                             uint16_t data_len, k_timeout_t timeout)
+{
+    uint16_t frag_max = eps[ep].mtu - DLT_PROTOCOL_BYTES -
+                        DLT_FRAGMENT_HEADER_LEN;
+    uint32_t count = DIV_ROUND_UP(data_len, frag_max);
+
+    if (data_len > CONFIG_DLT_MAX_MESSAGE_LEN || count > DLT_FRAG_MAX_COUNT) {
+        LOG_ERR("Data is too large.");
+        return -EMSGSIZE;
+    }
+
+    /* Don't start a message the pool can't finish without blocking */
+    if (K_TIMEOUT_EQ(timeout, K_NO_WAIT) &&
+        k_mem_slab_num_free_get(&dlt_buf_pool) < count) {
+        LOG_WRN("DLT buffer pool exhausted.");
+        return -ENOBUFS;
+    }
+
+    /* A message is only useful whole, so take credits for all fragments
+     * up front rather than applying the overflow policy to each one */
+    atomic_val_t backlog;
+    do {
+        backlog = atomic_get(&eps[ep].backlog);
+        if (DLT_BACKLOG_LIVE(backlog) + count > eps[ep].depth) {
+            LOG_WRN("DLT link queue full, dropping message.");
+            dlt_stats_drop(&eps[ep]);
+            return -ENOBUFS;
+        }
+    } while (!atomic_cas(&eps[ep].backlog, backlog, backlog + count));
+
+    uint8_t msg_id = eps[ep].frag_msg_id++;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t offset = i * frag_max;
+        uint16_t len = MIN(frag_max, data_len - offset);
+
+        struct dlt_buf *buf = dlt_buf_alloc(timeout);
+        if (!buf) {
+            atomic_sub(&eps[ep].backlog, count - i);
+            dlt_stats_drop(&eps[ep]);
+            return -ENOBUFS;
+        }
+
+        uint8_t *frag = dlt_buf_data(buf);
+        frag[DLT_FRAG_MSG_ID] = msg_id;
+        frag[DLT_FRAG_INDEX] = i;
+        sys_put_le16(data_len, &frag[DLT_FRAG_TOTAL]);
+        memcpy(&frag[DLT_FRAGMENT_HEADER_LEN], &data[offset], len);
+
+        dlt_buf_encode(buf, msg_type | DLT_FRAGMENT_FLAG,
+                       len + DLT_FRAGMENT_HEADER_LEN);
+        dlt_stats_tx_queued(&eps[ep], buf,
+                            DLT_BACKLOG_LIVE(backlog) + count - i);
+        dlt_queue_put(&eps[ep].to_link, buf);
+    }
+
+    return 0;
+}
+#endif
+
+/*
+ * Mark the queued buffer with the same key as dropped, so the new buffer
+ * takes its credit. Tickets make sure a slot whose buffer was already taken
+ * by the link, and possibly reused, is left alone. A reused buffer may be
+ * queued on another endpoint, so tickets are unique across all of them.
+ */
+static void dlt_coalesce(struct dlt_endpoint *e, struct dlt_buf *buf)
+{
+    struct dlt_coalesce_slot *slot =
+        &e->coalesce[buf->key % CONFIG_DLT_COALESCE_SLOTS];
+
+    if (slot->buf && slot->key == buf->key &&
+        DLT_BACKLOG_DROPPED(atomic_get(&e->backlog)) < e->depth &&
+        atomic_cas(&slot->buf->ticket, slot->ticket, 0)) {
+        atomic_add(&e->backlog, DLT_BACKLOG_DROPPED_ONE - 1);
+        dlt_stats_drop(e);
+    }
+
+    /* Ticket 0 means not coalescable */
+    atomic_val_t ticket = atomic_inc(&dlt_tickets) + 1;
+    if (ticket == 0) {
+        ticket = atomic_inc(&dlt_tickets) + 1;
+    }
+    atomic_set(&buf->ticket, ticket);
+
+    slot->key = buf->key;
+    slot->ticket = ticket;
+    slot->buf = buf;
+}
+
+/* Queue a buffer for the link, applying the endpoint's overflow policy */
+static int dlt_link_put(uint8_t ep, struct dlt_buf *buf)
+{
+    struct dlt_endpoint *e = &eps[ep];
+    atomic_val_t backlog, next;
+
+    if (e->policy == DLT_OVERFLOW_COALESCE && buf->key) {
+        dlt_coalesce(e, buf);
+    }
+
+    do {
+        backlog = atomic_get(&e->backlog);
+        next = backlog + 1;
+
+        if (DLT_BACKLOG_LIVE(backlog) >= e->depth) {
+            /* Give the oldest live buffer's credit to this one, as long as
+             * the link isn't already behind on discarding dropped buffers */
+            if (e->policy != DLT_OVERFLOW_DROP_OLDEST ||
+                DLT_BACKLOG_DROPPED(backlog) >= e->depth) {
+                LOG_WRN("DLT link queue full, dropping packet.");
+                atomic_set(&buf->ticket, 0);
+                dlt_stats_drop(e);
+                dlt_buf_complete(buf, -ENOBUFS);
+                return -ENOBUFS;
+            }
+            next = backlog + DLT_BACKLOG_DROPPED_ONE;
+        }
+    } while (!atomic_cas(&e->backlog, backlog, next));
+
+    if (next != backlog + 1) {
+        dlt_stats_drop(e);
+    }
+
+    dlt_stats_tx_queued(e, buf, DLT_BACKLOG_LIVE(next));
+    dlt_queue_put(&e->to_link, buf);
+    return 0;
+}
+
+/*
+ * Account for a buffer the link took from the queue. Returns false if the
+ * device dropped it, in which case it is released rather than sent.
+ */
+static bool dlt_link_take(struct dlt_endpoint *e, struct dlt_buf *buf)
+{
+    if (e->policy == DLT_OVERFLOW_COALESCE) {
+        /* Keyed buffers are live until a newer one with the key replaced
+         * them, which clears their ticket */
+        atomic_val_t ticket = atomic_get(&buf->ticket);
+        if (buf->key == 0 || (ticket && atomic_cas(&buf->ticket, ticket, 0))) {
+            atomic_dec(&e->backlog);
+            dlt_stats_tx_taken(e, buf);
+            return true;
+        }
+        atomic_sub(&e->backlog, DLT_BACKLOG_DROPPED_ONE);
+        dlt_buf_complete(buf, -ENOBUFS);
+        return false;
+    }
+
+    /* Otherwise dropped buffers are always the oldest ones in the queue */
+    atomic_val_t backlog;
+    bool dropped;
+    do {
+        backlog = atomic_get(&e->backlog);
+        dropped = DLT_BACKLOG_DROPPED(backlog) > 0;
+    } while (!atomic_cas(&e->backlog, backlog,
+                         backlog - (dropped ? DLT_BACKLOG_DROPPED_ONE : 1)));
+
+    if (dropped) {
+        dlt_buf_complete(buf, -ENOBUFS);
+    } else {
+        dlt_stats_tx_taken(e, buf);
+    }
+    return !dropped;
+}
+
+/* Take the next buffer the device still wants sent */
+static struct dlt_buf *dlt_link_get(uint8_t ep, k_timeout_t timeout)
+{
+    struct dlt_buf *buf;
+
+    while ((buf = dlt_queue_get(&eps[ep].to_link, timeout)) != NULL) {
+        if (dlt_link_take(&eps[ep], buf)) {
+            break;
+        }
+    }
+    return buf;
+}
+
+/* Take the link's send lock if it has more than one sender */
+static inline bool dlt_link_lock(struct dlt_endpoint *e)
+{
+    bool locked = e->shared;
+
+    if (locked) {
+        k_mutex_lock(&e->lock, K_FOREVER);
+    }
+    return locked;
+}
+
+static inline void dlt_link_unlock(struct dlt_endpoint *e, bool locked)
+{
+    if (locked) {
+        k_mutex_unlock(&e->lock);
+    }
+}
+
+/* Hand an encoded buffer to the link, splitting it if it exceeds the MTU */
+static int dlt_link_queue_locked(uint8_t ep, struct dlt_buf *buf)
+{
+    if (buf->len <= eps[ep].mtu) {
+        return dlt_link_put(ep, buf);
+    }
+
+    int err = -EMSGSIZE;
+#ifdef CONFIG_DLT_FRAGMENTATION
+    if (!(dlt_buf_msg_type(buf) & DLT_FRAGMENT_FLAG)) {
+        err = dlt_fragment_send(ep, dlt_buf_msg_type(buf), dlt_buf_data(buf),
+                                dlt_buf_data_len(buf), K_NO_WAIT);
+    }
+#endif
+    if (err == -EMSGSIZE) {
+        LOG_ERR("Packet exceeds link MTU.");
+        dlt_stats_drop(&eps[ep]);
+    }
+
+    /* The fragments hold a copy of the packet */
+    dlt_buf_complete(buf, err);
+    return err;
+}
+
+/* Queue for the link, locked so the fragments of a message stay together */
+static int dlt_link_queue(uint8_t ep, struct dlt_buf *buf)
+{
+    bool locked = dlt_link_lock(&eps[ep]);
+    int err = dlt_link_queue_locked(ep, buf);
+
+    dlt_link_unlock(&eps[ep], locked);
+    return err;
+}
+
+/* Encode a buffer and hand it to the link */
+static inline int dlt_buf_send(uint8_t ep, struct dlt_buf *buf,
+                               uint8_t msg_type, uint16_t data_len)
+{
+    int err = dlt_buf_encode(buf, msg_type, data_len);
+    if (err) {
+        dlt_stats_drop(&eps[ep]);
+        dlt_buf_complete(buf, err);
+        return err;
+    }
+
+    return dlt_link_queue(ep, buf);
+}
+
+extern int dlt_request_buf(uint8_t ep, struct dlt_buf *buf, uint16_t data_len)
+{
+    return dlt_buf_send(ep, buf, DLT_REQUEST_CODE, data_len);
+}
+
+extern int dlt_respond_buf(uint8_t ep, struct dlt_buf *buf, uint16_t data_len)
+{
+    return dlt_buf_send(ep, buf, DLT_RESPONSE_CODE, data_len);
+}
+
+extern int dlt_forward(uint8_t ep, struct dlt_buf *buf)
+{
+    if (!dlt_buf_valid(buf)) {
+        LOG_ERR("Refusing to forward malformed packet.");
+        dlt_stats_drop(&eps[ep]);
+        dlt_buf_complete(buf, -EINVAL);
+        return -EINVAL;
+    }
+
+    return dlt_link_queue(ep, buf);
+}
+
+/*
+ * The copying API is kept for compatibility. Data is copied into a pool
+ * buffer once on the way in and out of it once on the way out; the caller's
+ * buffers can be reused as soon as the call returns.
+ */
+static int dlt_copy_send(uint8_t ep, uint8_t msg_type, const uint8_t *data,
+                         uint16_t data_len, bool async)
+{
+    k_timeout_t timeout = async ? K_NO_WAIT : K_FOREVER;
+
+    if (data_len + DLT_PROTOCOL_BYTES > eps[ep].mtu) {
+#ifdef CONFIG_DLT_FRAGMENTATION
+        bool locked = dlt_link_lock(&eps[ep]);
+        int err = dlt_fragment_send(ep, msg_type, data, data_len, timeout);
+
+        dlt_link_unlock(&eps[ep], locked);
+        return err;
+#else
+        LOG_ERR("Data is too large.");
+        dlt_stats_drop(&eps[ep]);
+        return -EMSGSIZE;
+#endif
+    }
+
+    struct dlt_buf *buf = dlt_buf_alloc(timeout);
+    if (!buf) {
+        dlt_stats_drop(&eps[ep]);
+        return -ENOBUFS;
+    }
+
+    memcpy(dlt_buf_data(buf), data, data_len);
+    return dlt_buf_send(ep, buf, msg_type, data_len);
+}
+
+#ifdef CONFIG_DLT_STATS
+/* The reply goes out as one fragmented message, so a larger one never sends */
+BUILD_ASSERT(1 + DLT_STATS_DUMP_LEN(DLT_MAX_ENDPOINTS) <=
+             CONFIG_DLT_MAX_MESSAGE_LEN,
+             "DLT statistics dump does not fit CONFIG_DLT_MAX_MESSAGE_LEN");
+
+/* Reply to a statistics request, only ever built by the device thread */
+static uint8_t dlt_stats_reply[1 + DLT_STATS_DUMP_LEN(DLT_MAX_ENDPOINTS)];
+
+static int dlt_control_stats(uint8_t ep)
+{
+    dlt_stats_reply[0] = DLT_CTRL_STATS | DLT_CTRL_REPLY;
+    int len = dlt_stats_encode(&dlt_stats_reply[1],
+                               sizeof(dlt_stats_reply) - 1);
+    if (len < 0) {
+        return len;
+    }
+
+    return dlt_copy_send(ep, DLT_CONTROL_CODE, dlt_stats_reply, len + 1,
+                         true);
+}
+#endif
+
+/* Answer a control packet on the endpoint it arrived on */
+static int dlt_control(uint8_t ep, struct dlt_buf *buf)
+{
+    uint8_t opcode = dlt_buf_data_len(buf) ? dlt_buf_data(buf)[0] : 0;
+    dlt_buf_free(buf);
+
+    switch (opcode) {
+#ifdef CONFIG_DLT_STATS
+    case DLT_CTRL_STATS:
+        return dlt_control_stats(ep);
+#endif
+    default:
+        LOG_WRN("Unknown DLT control opcode 0x%02x.", opcode);
+        return -ENOTSUP;
+    }
+}
+
+/* Find the link a received packet is routed to, or -1 for the device */
+static int dlt_route_find(uint8_t src, uint8_t msg_type)
+{
+    msg_type &= ~DLT_FRAGMENT_FLAG;
+    if (msg_type == DLT_CONTROL_CODE) {
+        return -1;
+    }
+
+    for (int i = 0; i < num_routes; i++) {
+        if (routes[i].src == src && (routes[i].msg_type == DLT_ROUTE_ANY ||
+                                     routes[i].msg_type == msg_type)) {
+            return routes[i].dst;
+        }
+    }
+    return -1;
+}
+
+/* Queue a received packet for the device, or the link it is routed to */
+static inline void dlt_device_put(uint8_t ep, struct dlt_buf *buf)
+{
+    if (eps[ep].routed) {
+        int dst = dlt_route_find(ep, dlt_buf_msg_type(buf));
+        if (dst >= 0) {
+            dlt_link_queue(dst, buf);
+            return;
+        }
+    }
+
+    dlt_stats_rx_queued(&eps[ep], buf);
+    dlt_queue_put(&eps[ep].to_device, buf);
+}
+
+#ifdef CONFIG_DLT_AGGREGATION
+/*
+ * Queue each packet of a container for the device. The last packet is moved
+ * to the front of the container buffer and queued in its place, so splitting
+ * a container of n packets takes n - 1 buffers from the pool.
+ */
+static int dlt_split(uint8_t ep, struct dlt_buf *container)
+{
+    uint8_t *pos = dlt_buf_data(container);
+    uint8_t *end = pos + dlt_buf_data_len(container);
+    int err = -EINVAL;
+
+    while (pos < end) {
+        uint16_t left = end - pos;
+        uint16_t len = left < DLT_PROTOCOL_BYTES ?
+                       0 : pos[2] + DLT_PROTOCOL_BYTES;
+
+        if (len == 0 || len > left ||
+            pos[0] != DLT_PREAMBLE || pos[1] == DLT_AGGREGATE_CODE) {
+            LOG_ERR("Dropping malformed container packet.");
+            dlt_stats_drop(&eps[ep]);
+            break;
+        }
+
+        if (len == left) {
+            memmove(container->packet, pos, len);
+            container->len = len;
+            dlt_device_put(ep, container);
+            return 0;
+        }
+
+        struct dlt_buf *buf = dlt_buf_alloc(K_NO_WAIT);
+        if (!buf) {
+            dlt_stats_drop(&eps[ep]);
+            err = -ENOBUFS;
+            break;
+        }
+
+        memcpy(buf->packet, pos, len);
+        buf->len = len;
+        dlt_device_put(ep, buf);
+        pos += len;
+    }
+
+    dlt_buf_free(container);
+    return err;
+}
+
+/*
+ * Turn the first packet into a container in place and append the packets
+ * queued behind it while they fit the link MTU, waiting up to the link's
+ * aggregation window for more to arrive. A lone packet is sent as is.
+ */
+static struct dlt_buf *dlt_aggregate(uint8_t ep, struct dlt_buf *buf)
+{
+    struct dlt_queue *q = &eps[ep].to_link;
+    uint16_t max_len = eps[ep].mtu;
+    int64_t deadline = k_uptime_ticks() +
+                       k_us_to_ticks_ceil64(eps[ep].window_us);
+    bool container = false;
+
+    /* Not even an empty packet would fit alongside this one */
+    if (buf->len + 2 * DLT_PROTOCOL_BYTES > max_len) {
+        return buf;
+    }
+
+    while (true) {
+        struct dlt_buf *next = dlt_queue_peek(q);
+        if (!next) {
+            int64_t remaining = deadline - k_uptime_ticks();
+            if (remaining <= 0 || !dlt_queue_wait(q, K_TICKS(remaining))) {
+                break;
+            }
+            continue;
+        }
+
+        uint16_t header = container ? 0 : DLT_PROTOCOL_BYTES;
+        if (buf->len + header + next->len > max_len) {
+            break;
+        }
+
+        /* Skip packets the device has dropped since they were queued */
+        next = dlt_queue_get(q, K_NO_WAIT);
+        if (!dlt_link_take(&eps[ep], next)) {
+            continue;
+        }
+
+        if (!container) {
+            memmove(dlt_buf_data(buf), buf->packet, buf->len);
+            buf->len += DLT_PROTOCOL_BYTES;
+            container = true;
+        }
+
+        memcpy(&buf->packet[buf->len], next->packet, next->len);
+        buf->len += next->len;
+        dlt_buf_free(next);
+    }
+
+    if (container) {
+        dlt_buf_encode(buf, DLT_AGGREGATE_CODE, buf->len - DLT_PROTOCOL_BYTES);
+    }
+    return buf;
+}
+#endif
+
+extern int dlt_submit_buf(uint8_t ep, struct dlt_buf *buf)
+{
+    if (!dlt_buf_valid(buf)) {
+        LOG_ERR("Dropping malformed packet.");
+        dlt_stats_drop(&eps[ep]);
+        dlt_buf_complete(buf, -EINVAL);
+        return -EINVAL;
+    }
+
+#ifdef CONFIG_DLT_AGGREGATION
+    if (dlt_buf_msg_type(buf) == DLT_AGGREGATE_CODE) {
+        return dlt_split(ep, buf);
+    }
+#endif
+
+    dlt_device_put(ep, buf);
+    return 0;
+}
+
+/*
+ * Take the next packet for the device. Control packets are answered here,
+ * from the device thread, so replies keep the link queue single-producer.
+ */
+static struct dlt_buf *dlt_device_get(uint8_t ep, k_timeout_t timeout)
+{
+    struct dlt_buf *buf;
+
+    while ((buf = dlt_queue_get(&eps[ep].to_device, timeout)) != NULL) {
+        if (dlt_buf_msg_type(buf) != DLT_CONTROL_CODE) {
+            break;
+        }
+        dlt_stats_rx_taken(&eps[ep], buf);
+        dlt_control(ep, buf);
+    }
+    return buf;
+}
+
+extern struct dlt_buf *dlt_read_buf(uint8_t ep, k_timeout_t timeout)
+{
+    struct dlt_buf *buf = dlt_device_get(ep, timeout);
+
+    if (buf) {
+        dlt_stats_rx_taken(&eps[ep], buf);
+    }
+    return buf;
+}
+
+extern struct dlt_buf *dlt_poll_buf(uint8_t ep, k_timeout_t timeout)
+{
+    struct dlt_buf *buf = dlt_link_get(ep, timeout);
+
+#ifdef CONFIG_DLT_AGGREGATION
+    if (buf && eps[ep].aggregate) {
+        buf = dlt_aggregate(ep, buf);
+    }
+#endif
+    return buf;
+}
+
+extern void dlt_read_event_init(uint8_t ep, struct k_poll_event *evt)
+{
+    dlt_queue_event_init(&eps[ep].to_device, evt);
+}
+
+extern void dlt_poll_event_init(uint8_t ep, struct k_poll_event *evt)
+{
+    dlt_queue_event_init(&eps[ep].to_link, evt);
+}
+
+#ifdef CONFIG_DLT_STATS
+extern int dlt_stats_get(uint8_t ep, struct dlt_stats *stats)
+{
+    if (ep >= num_eps) {
+        return -EINVAL;
+    }
+
+    struct dlt_ep_stats *s = &eps[ep].stats;
+
+    stats->tx_msgs = atomic_get(&s->tx_msgs);
+    stats->tx_bytes = atomic_get(&s->tx_bytes);
+    stats->rx_msgs = atomic_get(&s->rx_msgs);
+    stats->rx_bytes = atomic_get(&s->rx_bytes);
+    stats->drops = atomic_get(&s->drops);
+    stats->truncations = atomic_get(&s->truncations);
+    stats->tx_max_depth = atomic_get(&s->tx_max_depth);
+    stats->rx_max_depth = atomic_get(&s->rx_max_depth);
+    for (int i = 0; i < DLT_STATS_HIST_BINS; i++) {
+        stats->tx_latency[i] = atomic_get(&s->tx_latency[i]);
+        stats->rx_latency[i] = atomic_get(&s->rx_latency[i]);
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&dlt_link_info_lock);
+    stats->link = s->link;
+    k_spin_unlock(&dlt_link_info_lock, key);
+    return 0;
+}
+
+extern void dlt_link_set_info(uint8_t ep, const struct dlt_link_info *info)
+{
+    if (ep >= num_eps) {
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&dlt_link_info_lock);
+    eps[ep].stats.link = *info;
+    k_spin_unlock(&dlt_link_info_lock, key);
+}
+
+extern void dlt_stats_reset(uint8_t ep)
+{
+    if (ep >= num_eps) {
+        return;
+    }
+
+    struct dlt_ep_stats *s = &eps[ep].stats;
+
+    /* The current RX depth and link parameters are live state, not
+     * statistics */
+    atomic_clear(&s->tx_msgs);
+    atomic_clear(&s->tx_bytes);
+    atomic_clear(&s->rx_msgs);
+    atomic_clear(&s->rx_bytes);
+    atomic_clear(&s->drops);
+    atomic_clear(&s->truncations);
+    atomic_clear(&s->tx_max_depth);
+    atomic_clear(&s->rx_max_depth);
+    for (int i = 0; i < DLT_STATS_HIST_BINS; i++) {
+        atomic_clear(&s->tx_latency[i]);
+        atomic_clear(&s->rx_latency[i]);
+    }
+}
+
+extern uint8_t dlt_stats_endpoints(void)
+{
+    return num_eps;
+}
+#endif
+
+extern void dlt_request(uint8_t ep, uint8_t *packet, uint8_t *data,
+                        uint16_t data_len, bool async)
+{
+    ARG_UNUSED(packet);
+    dlt_copy_send(ep, DLT_REQUEST_CODE, data, data_len, async);
+}
+
+extern void dlt_respond(uint8_t ep, uint8_t *packet, uint8_t *data,
+                        uint16_t data_len, bool async)
+{
+    ARG_UNUSED(packet);
+    dlt_copy_send(ep, DLT_RESPONSE_CODE, data, data_len, async);
+}
+
+extern void dlt_submit(uint8_t ep, uint8_t *packet, uint16_t packet_len,
+                       bool async)
+{
+    if (packet_len > DLT_MAX_PACKET_LEN) {
+        LOG_ERR("Packet is too large.");
+        dlt_stats_drop(&eps[ep]);
+        return;
+    }
+
+    struct dlt_buf *buf = dlt_buf_alloc(async ? K_NO_WAIT : K_FOREVER);
+    if (!buf) {
+        dlt_stats_drop(&eps[ep]);
+        return;
+    }
+
+    memcpy(buf->packet, packet, packet_len);
+    buf->len = packet_len;
+    dlt_submit_buf(ep, buf);
+}
+
+#ifdef CONFIG_DLT_FRAGMENTATION
+/*
+ * Hand back the packets set aside during reassembly, oldest at the head of
+ * the queue. They were stacked newest first, so each goes in front of the
+ * one before.
+ */
+static void dlt_reassembly_unget(uint8_t ep, struct dlt_buf *held)
+{
+    while (held) {
+        struct dlt_buf *next = held->fifo_reserved;
+
+        dlt_queue_unget(&eps[ep].to_device, held);
+        held = next;
+    }
+}
+
+/*
+ * Reassemble a fragmented message directly into the caller's buffer,
+ * starting from its first fragment. A missing, repeated or foreign fragment
+ * abandons the whole message. Whole packets that arrive between the
+ * fragments are set aside and handed back to the reader afterwards.
+ */
+static uint16_t dlt_reassemble(uint8_t ep, struct dlt_buf *buf,
+                               uint8_t *msg_type, uint8_t *data,
+                               uint16_t data_len)
+{
+    int64_t deadline = k_uptime_get() + CONFIG_DLT_REASSEMBLY_TIMEOUT_MS;
+    uint8_t type = dlt_buf_msg_type(buf);
+    uint8_t msg_id = dlt_buf_data(buf)[DLT_FRAG_MSG_ID];
+    uint16_t total = sys_get_le16(&dlt_buf_data(buf)[DLT_FRAG_TOTAL]);
+    uint16_t received = 0;
+    uint8_t index = 0;
+    struct dlt_buf *held = NULL;
+
+    while (true) {
+        uint8_t *frag = dlt_buf_data(buf);
+        uint8_t frag_len = dlt_buf_data_len(buf);
+
+        if (dlt_buf_msg_type(buf) != type ||
+            frag_len < DLT_FRAGMENT_HEADER_LEN ||
+            frag[DLT_FRAG_MSG_ID] != msg_id ||
+            frag[DLT_FRAG_INDEX] != index ||
+            sys_get_le16(&frag[DLT_FRAG_TOTAL]) != total ||
+            frag_len - DLT_FRAGMENT_HEADER_LEN > total - received) {
+            LOG_WRN("DLT fragment out of sequence, dropping message.");
+            dlt_stats_drop(&eps[ep]);
+            dlt_buf_free(buf);
+            dlt_reassembly_unget(ep, held);
+            return 0;
+        }
+
+        /* Keep consuming fragments of an oversized message to drop it */
+        frag_len -= DLT_FRAGMENT_HEADER_LEN;
+        if (total <= data_len) {
+            memcpy(&data[received], &frag[DLT_FRAGMENT_HEADER_LEN], frag_len);
+        }
+        received += frag_len;
+        index++;
+        dlt_buf_free(buf);
+
+        if (received == total) {
+            break;
+        }
+
+        /* The rest of the message may still be in flight on the link */
+        while (true) {
+            int64_t remaining = deadline - k_uptime_get();
+            buf = dlt_device_get(ep, K_MSEC(MAX(remaining, 0)));
+            if (!buf || dlt_buf_msg_type(buf) & DLT_FRAGMENT_FLAG) {
+                break;
+            }
+            buf->fifo_reserved = held;
+            held = buf;
+        }
+        if (!buf) {
+            LOG_WRN("DLT reassembly timed out, dropping message.");
+            dlt_stats_drop(&eps[ep]);
+            dlt_reassembly_unget(ep, held);
+            return 0;
+        }
+        dlt_stats_rx_taken(&eps[ep], buf);
+    }
+    dlt_reassembly_unget(ep, held);
+
+    if (total > data_len) {
+        LOG_ERR("Message receive error. Data segment is too big.");
+        dlt_stats_truncation(&eps[ep]);
+        return 0;
+    }
+
+    *msg_type = type & ~DLT_FRAGMENT_FLAG;
+    return total;
+}
+#endif
+
+extern uint16_t dlt_read(uint8_t ep, uint8_t *msg_type, uint8_t *data,
+                         uint16_t data_len, k_timeout_t timeout)
+{
+    struct dlt_buf *buf = dlt_read_buf(ep, timeout);
+    if (!buf) {
+        return 0;
+    }
+
+#ifdef CONFIG_DLT_FRAGMENTATION
+    if (dlt_buf_msg_type(buf) & DLT_FRAGMENT_FLAG) {
+        return dlt_reassemble(ep, buf, msg_type, data, data_len);
+    }
+#endif
+
+    uint8_t len = dlt_buf_data_len(buf);
+    if (len > data_len) {
+        LOG_ERR("Message receive error. Data segment is too big.");
+        dlt_stats_truncation(&eps[ep]);
+        dlt_buf_free(buf);
+        return 0;
+    }
+
+    *msg_type = dlt_buf_msg_type(buf);
+    memcpy(data, dlt_buf_data(buf), len);
+    dlt_buf_free(buf);
+
+    return len;
+}
+
+extern uint16_t dlt_poll(uint8_t ep, uint8_t *packet, uint16_t packet_len,
+                         k_timeout_t timeout)
+{
+    struct dlt_buf *buf = dlt_poll_buf(ep, timeout);
+    if (!buf) {
+        return 0;
+    }
+
+    uint16_t len = buf->len;
+    if (len > packet_len) {
+        LOG_ERR("Message receive error. Packet is too big.");
+        dlt_stats_truncation(&eps[ep]);
+        dlt_buf_free(buf);
+        return 0;
+    }
+
+    memcpy(packet, buf->packet, len);
+    dlt_buf_free(buf);
+
+    return len;
+}
+
+#else
+
 /* Create a packet and return its length */
-static inline uint8_t dlt_generate_packet(uint8_t *packet, uint8_t msg_type,
-                                          uint8_t *data, uint8_t data_len)
+static inline uint16_t dlt_generate_packet(uint8_t *packet, uint8_t msg_type,
+                                           uint8_t *data, uint16_t data_len)
 {
     if (data_len + DLT_PROTOCOL_BYTES > DLT_MAX_PACKET_LEN) {
         LOG_ERR("Data is too large.");
@@ -50,7 +1401,7 @@ static inline uint8_t dlt_generate_packet(uint8_t *packet, uint8_t msg_type,
     packet[1] = msg_type;
     packet[2] = data_len;
 
-    /* Copy data segment into packet */ 
+    /* Copy data segment into packet */
     for (int i = 0; i < data_len; i++) {
         packet[i + DLT_PROTOCOL_BYTES] = data[i];
     }
@@ -60,7 +1411,7 @@ static inline uint8_t dlt_generate_packet(uint8_t *packet, uint8_t msg_type,
 
 /* Generic method for sending packets via mailbox */
 static inline void dlt_send(uint8_t ep, uint8_t *packet,
-                            uint8_t packet_len, uint8_t msg_type,
+                            uint16_t packet_len, uint8_t msg_type,
                             k_tid_t send_tid, bool async)
 {
     /* Create mailbox message */
@@ -87,20 +1438,20 @@ static inline void dlt_send(uint8_t ep, uint8_t *packet,
 
 }
 
-extern void dlt_request(uint8_t ep, uint8_t *packet, uint8_t *data, uint8_t data_len, bool async)
+extern void dlt_request(uint8_t ep, uint8_t *packet, uint8_t *data, uint16_t data_len, bool async)
 {
     /* Create the DLT packet */
-    uint8_t packet_len = dlt_generate_packet(packet, DLT_REQUEST_CODE,
+    uint16_t packet_len = dlt_generate_packet(packet, DLT_REQUEST_CODE,
                                              data, data_len);
 
     /* Submit the packet to the Link for transfer */
     dlt_send(ep, packet, packet_len, DLT_REQUEST_CODE, link_tids[ep], async);
 }
 
-extern void dlt_respond(uint8_t ep, uint8_t *packet, uint8_t *data, uint8_t data_len, bool async)
+extern void dlt_respond(uint8_t ep, uint8_t *packet, uint8_t *data, uint16_t data_len, bool async)
 {
     /* Create the DLT packet */
-    uint8_t packet_len = dlt_generate_packet(packet, DLT_RESPONSE_CODE,
+    uint16_t packet_len = dlt_generate_packet(packet, DLT_RESPONSE_CODE,
                                              data, data_len);
 
     /* Submit the packet to the Link for transfer */
@@ -108,18 +1459,18 @@ extern void dlt_respond(uint8_t ep, uint8_t *packet, uint8_t *data, uint8_t data
 }
 
 /* Submits the packet to the DLT interface for a Device to read */
-extern void dlt_submit(uint8_t ep, uint8_t *packet, uint8_t packet_len,
+extern void dlt_submit(uint8_t ep, uint8_t *packet, uint16_t packet_len,
                        bool async)
 {
     uint8_t msg_type = packet[1];
-    dlt_send(ep, packet, packet_len, msg_type, device_tid, async);
+    dlt_send(ep, packet, packet_len, msg_type, dlt_device_tid(ep), async);
 }
 
-extern uint8_t dlt_read(uint8_t ep, uint8_t *msg_type, uint8_t *data,
-                        uint8_t data_len, k_timeout_t timeout)
+extern uint16_t dlt_read(uint8_t ep, uint8_t *msg_type, uint8_t *data,
+                         uint16_t data_len, k_timeout_t timeout)
 {
     struct k_mbox_msg recv_msg;
-    recv_msg.size = 100;
+    recv_msg.size = DLT_MAX_PACKET_LEN;
     recv_msg.rx_source_thread = link_tids[ep];
 
     /* Wait to get message, but don't consume it */
@@ -131,7 +1482,7 @@ extern uint8_t dlt_read(uint8_t ep, uint8_t *msg_type, uint8_t *data,
     uint8_t rx_packet[DLT_MAX_PACKET_LEN] = {0};
     k_mbox_data_get(&recv_msg, &rx_packet);
 
-    if (recv_msg.size > DLT_MAX_PACKET_LEN || 
+    if (recv_msg.size > DLT_MAX_PACKET_LEN ||
             (recv_msg.size - DLT_PROTOCOL_BYTES) > data_len) {
         LOG_ERR("Message receive error. Data segment is too big.");
         return 0;
@@ -148,12 +1499,12 @@ extern uint8_t dlt_read(uint8_t ep, uint8_t *msg_type, uint8_t *data,
 }
 
 /* Polling function for Links to check if packets are available */
-extern uint8_t dlt_poll(uint8_t ep, uint8_t *packet, uint8_t packet_len,
-                        k_timeout_t timeout)
+extern uint16_t dlt_poll(uint8_t ep, uint8_t *packet, uint16_t packet_len,
+                         k_timeout_t timeout)
 {
     struct k_mbox_msg recv_msg;
-    recv_msg.size = 100;
-    recv_msg.rx_source_thread = device_tid;
+    recv_msg.size = DLT_MAX_PACKET_LEN;
+    recv_msg.rx_source_thread = dlt_device_tid(ep);
 
     /* Wait to get message, but don't consume it */
     if (k_mbox_get(&eps[ep], &recv_msg, NULL, timeout)) {
@@ -170,3 +1521,5 @@ extern uint8_t dlt_poll(uint8_t ep, uint8_t *packet, uint8_t packet_len,
 
     return recv_msg.size;
 }
+
+#endif
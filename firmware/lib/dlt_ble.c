@@ -0,0 +1,191 @@
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/hci.h>
+
+#include "dlt_api.h"
+#include "dlt_ble.h"
+
+LOG_MODULE_REGISTER(dlt_ble, LOG_LEVEL_INF);
+
+#ifdef CONFIG_DLT_BLE
+/* Supervision timeouts, in units of 10 ms */
+#define DLT_BLE_PERFORMANCE_TIMEOUT 400
+#define DLT_BLE_RANGE_TIMEOUT       600
+
+/* Connection interval units, in microseconds */
+#define DLT_BLE_INTERVAL_UNIT_US 1250
+
+static const struct bt_le_conn_param dlt_ble_params[] = {
+    [DLT_BLE_PROFILE_PERFORMANCE] = {
+        .interval_min = CONFIG_DLT_BLE_PERFORMANCE_INTERVAL,
+        .interval_max = CONFIG_DLT_BLE_PERFORMANCE_INTERVAL,
+        .latency = 0,
+        .timeout = DLT_BLE_PERFORMANCE_TIMEOUT,
+    },
+    [DLT_BLE_PROFILE_RANGE] = {
+        .interval_min = CONFIG_DLT_BLE_RANGE_INTERVAL,
+        .interval_max = CONFIG_DLT_BLE_RANGE_INTERVAL,
+        .latency = 0,
+        .timeout = DLT_BLE_RANGE_TIMEOUT,
+    },
+};
+
+#ifdef CONFIG_BT_USER_PHY_UPDATE
+static const struct bt_conn_le_phy_param dlt_ble_phys[] = {
+    [DLT_BLE_PROFILE_PERFORMANCE] = {
+        .options = BT_CONN_LE_PHY_OPT_NONE,
+        .pref_tx_phy = BT_GAP_LE_PHY_2M,
+        .pref_rx_phy = BT_GAP_LE_PHY_2M,
+    },
+    [DLT_BLE_PROFILE_RANGE] = {
+        .options = BT_CONN_LE_PHY_OPT_NONE,
+        .pref_tx_phy = BT_GAP_LE_PHY_1M,
+        .pref_rx_phy = BT_GAP_LE_PHY_1M,
+    },
+};
+#endif
+
+#ifdef CONFIG_BT_USER_DATA_LEN_UPDATE
+static const struct bt_conn_le_data_len_param dlt_ble_data_lens[] = {
+    [DLT_BLE_PROFILE_PERFORMANCE] = {
+        .tx_max_len = BT_GAP_DATA_LEN_MAX,
+        .tx_max_time = BT_GAP_DATA_TIME_MAX,
+    },
+    /* The default for every controller: 27 bytes at 1M */
+    [DLT_BLE_PROFILE_RANGE] = {
+        .tx_max_len = 27,
+        .tx_max_time = 328,
+    },
+};
+#endif
+
+/* Request every part of a profile, returns the first error */
+static int dlt_ble_apply(struct dlt_ble_link *link)
+{
+    enum dlt_ble_profile profile = link->profile;
+    int ret = 0;
+    int err;
+
+    LOG_INF("Requesting %s profile", profile == DLT_BLE_PROFILE_PERFORMANCE ?
+                                     "performance" : "range");
+
+    /* Controllers without the 2M PHY or DLE keep their current settings */
+#ifdef CONFIG_BT_USER_PHY_UPDATE
+    err = bt_conn_le_phy_update(link->conn, &dlt_ble_phys[profile]);
+    if (err) {
+        LOG_WRN("PHY update failed (err %d)", err);
+        ret = ret ? ret : err;
+    }
+#endif
+
+#ifdef CONFIG_BT_USER_DATA_LEN_UPDATE
+    err = bt_conn_le_data_len_update(link->conn, &dlt_ble_data_lens[profile]);
+    if (err) {
+        LOG_WRN("Data length update failed (err %d)", err);
+        ret = ret ? ret : err;
+    }
+#endif
+
+    /* A central that connected with the profile already has its parameters */
+    err = bt_conn_le_param_update(link->conn, &dlt_ble_params[profile]);
+    if (err && err != -EALREADY) {
+        LOG_WRN("Connection parameter update failed (err %d)", err);
+        ret = ret ? ret : err;
+    }
+
+    return ret;
+}
+
+/* A range connection has been stable, try the performance profile again */
+static void dlt_ble_upgrade(struct k_work *work)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct dlt_ble_link *link = CONTAINER_OF(dwork, struct dlt_ble_link,
+                                             upgrade);
+
+    if (!link->conn) {
+        return;
+    }
+
+    link->profile = DLT_BLE_PROFILE_PERFORMANCE;
+    (void)dlt_ble_apply(link);
+}
+
+extern void dlt_ble_link_init(struct dlt_ble_link *link, uint8_t ep)
+{
+    link->ep = ep;
+    link->profile = DLT_BLE_PROFILE_PERFORMANCE;
+    link->conn = NULL;
+    k_work_init_delayable(&link->upgrade, dlt_ble_upgrade);
+}
+
+extern const struct bt_le_conn_param *dlt_ble_conn_param(
+    const struct dlt_ble_link *link)
+{
+    return &dlt_ble_params[link->profile];
+}
+
+extern int dlt_ble_connected(struct dlt_ble_link *link, struct bt_conn *conn)
+{
+    link->conn = conn;
+    dlt_ble_updated(link, conn);
+
+    if (link->profile == DLT_BLE_PROFILE_RANGE) {
+        k_work_reschedule(&link->upgrade,
+                          K_SECONDS(CONFIG_DLT_BLE_UPGRADE_DELAY_S));
+    }
+
+    return dlt_ble_apply(link);
+}
+
+extern void dlt_ble_disconnected(struct dlt_ble_link *link, uint8_t reason)
+{
+    k_work_cancel_delayable(&link->upgrade);
+    link->conn = NULL;
+
+    /* The peer went out of range rather than away */
+    if (reason == BT_HCI_ERR_CONN_TIMEOUT) {
+        link->profile = DLT_BLE_PROFILE_RANGE;
+    }
+
+#ifdef CONFIG_DLT_STATS
+    struct dlt_link_info info = {0};
+    dlt_link_set_info(link->ep, &info);
+#endif
+}
+
+extern void dlt_ble_updated(struct dlt_ble_link *link, struct bt_conn *conn)
+{
+#ifdef CONFIG_DLT_STATS
+    struct bt_conn_info conn_info;
+    struct dlt_link_info info = {0};
+
+    if (conn != link->conn || bt_conn_get_info(conn, &conn_info)) {
+        return;
+    }
+
+    /* Without the PHY and data length fields the link is on the defaults */
+    info.bit_rate = 1000000;
+    info.data_len = 27;
+#ifdef CONFIG_BT_USER_PHY_UPDATE
+    if (conn_info.le.phy && conn_info.le.phy->tx_phy == BT_GAP_LE_PHY_2M) {
+        info.bit_rate = 2000000;
+    } else if (conn_info.le.phy &&
+               conn_info.le.phy->tx_phy == BT_GAP_LE_PHY_CODED) {
+        info.bit_rate = 125000;
+    }
+#endif
+#ifdef CONFIG_BT_USER_DATA_LEN_UPDATE
+    if (conn_info.le.data_len) {
+        info.data_len = conn_info.le.data_len->tx_max_len;
+    }
+#endif
+
+    info.interval_us = conn_info.le.interval * DLT_BLE_INTERVAL_UNIT_US;
+    info.latency = conn_info.le.latency;
+
+    dlt_link_set_info(link->ep, &info);
+#endif
+}
+#endif
@@ -0,0 +1,131 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "dlt_api.h"
+#include "dlt_parser.h"
+
+LOG_MODULE_REGISTER(dlt_parser, LOG_LEVEL_ERR);
+
+#ifdef CONFIG_DLT_BUF_POOL
+/* Whether a frame header could start a frame this build can receive */
+static bool dlt_parser_header_valid(const uint8_t *header)
+{
+    uint8_t msg_type = header[1] & ~DLT_FRAGMENT_FLAG;
+
+    if (header[2] + DLT_PROTOCOL_BYTES > DLT_MAX_PACKET_LEN) {
+        return false;
+    }
+
+    switch (msg_type) {
+    case DLT_REQUEST_CODE:
+    case DLT_RESPONSE_CODE:
+    case DLT_CONTROL_CODE:
+        return true;
+    case DLT_AGGREGATE_CODE:
+        return !(header[1] & DLT_FRAGMENT_FLAG);
+    default:
+        return false;
+    }
+}
+
+/*
+ * Drop a header that cannot be valid, keeping any later preamble in it as
+ * the start of the next frame
+ */
+static void dlt_parser_resync(struct dlt_parser *parser)
+{
+    struct dlt_buf *buf = parser->buf;
+    const uint8_t *next = memchr(&buf->packet[1], DLT_PREAMBLE,
+                                 DLT_PROTOCOL_BYTES - 1);
+    uint16_t keep = next ? &buf->packet[DLT_PROTOCOL_BYTES] - next : 0;
+
+    LOG_WRN("Invalid DLT header, resyncing.");
+    parser->skipped += buf->len - keep;
+    if (next) {
+        memmove(buf->packet, next, keep);
+    }
+    buf->len = keep;
+}
+
+extern void dlt_parser_init(struct dlt_parser *parser, uint8_t ep)
+{
+    parser->ep = ep;
+    parser->handler = NULL;
+    parser->buf = NULL;
+    parser->frames = 0;
+    parser->skipped = 0;
+}
+
+extern void dlt_parser_set_handler(struct dlt_parser *parser,
+                                   dlt_parser_handler_t handler)
+{
+    parser->handler = handler;
+}
+
+extern size_t dlt_parser_feed(struct dlt_parser *parser, const uint8_t *data,
+                              size_t len)
+{
+    size_t used = 0;
+
+    while (used < len) {
+        /* Between frames, skip to the next preamble */
+        if (!dlt_parser_busy(parser)) {
+            const uint8_t *start = memchr(&data[used], DLT_PREAMBLE,
+                                          len - used);
+            if (!start) {
+                parser->skipped += len - used;
+                return len;
+            }
+            parser->skipped += start - &data[used];
+            used = start - data;
+
+            if (!parser->buf) {
+                parser->buf = dlt_buf_alloc(K_NO_WAIT);
+                if (!parser->buf) {
+                    return used;
+                }
+            }
+            parser->buf->len = 0;
+        }
+
+        /* Copy up to the end of the header, then up to the end of the frame */
+        struct dlt_buf *buf = parser->buf;
+        uint16_t frame_len = buf->len < DLT_PROTOCOL_BYTES ?
+                             DLT_PROTOCOL_BYTES :
+                             buf->packet[2] + DLT_PROTOCOL_BYTES;
+        size_t n = MIN((size_t)(frame_len - buf->len), len - used);
+
+        memcpy(&buf->packet[buf->len], &data[used], n);
+        buf->len += n;
+        used += n;
+
+        if (buf->len == DLT_PROTOCOL_BYTES && frame_len == DLT_PROTOCOL_BYTES) {
+            if (!dlt_parser_header_valid(buf->packet)) {
+                dlt_parser_resync(parser);
+                continue;
+            }
+            frame_len += buf->packet[2];
+        }
+
+        if (buf->len == frame_len) {
+            parser->buf = NULL;
+            parser->frames++;
+            if (!parser->handler || !parser->handler(parser, buf)) {
+                dlt_submit_buf(parser->ep, buf);
+            }
+        }
+    }
+
+    return used;
+}
+
+extern void dlt_parser_reset(struct dlt_parser *parser)
+{
+    if (parser->buf) {
+        parser->skipped += parser->buf->len;
+        dlt_buf_free(parser->buf);
+        parser->buf = NULL;
+    }
+}
+#endif
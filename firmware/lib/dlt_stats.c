@@ -0,0 +1,123 @@
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+#include "dlt_api.h"
+
+#ifdef CONFIG_DLT_STATS
+/* Encode one endpoint's statistics, returns the position after them */
+static uint8_t *dlt_stats_encode_ep(uint8_t *pos, const struct dlt_stats *s)
+{
+    sys_put_le32(s->tx_msgs, pos);
+    sys_put_le32(s->tx_bytes, pos + 4);
+    sys_put_le32(s->rx_msgs, pos + 8);
+    sys_put_le32(s->rx_bytes, pos + 12);
+    sys_put_le32(s->drops, pos + 16);
+    sys_put_le32(s->truncations, pos + 20);
+    sys_put_le16(s->tx_max_depth, pos + 24);
+    sys_put_le16(s->rx_max_depth, pos + 26);
+    pos += 28;
+
+    for (int i = 0; i < DLT_STATS_HIST_BINS; i++, pos += 4) {
+        sys_put_le32(s->tx_latency[i], pos);
+    }
+    for (int i = 0; i < DLT_STATS_HIST_BINS; i++, pos += 4) {
+        sys_put_le32(s->rx_latency[i], pos);
+    }
+
+    sys_put_le32(s->link.bit_rate, pos);
+    sys_put_le32(s->link.interval_us, pos + 4);
+    sys_put_le16(s->link.latency, pos + 8);
+    sys_put_le16(s->link.data_len, pos + 10);
+    return pos + 12;
+}
+
+extern int dlt_stats_encode(uint8_t *out, size_t len)
+{
+    uint8_t num_endpoints = dlt_stats_endpoints();
+    struct dlt_stats stats;
+
+    if (len < (size_t)DLT_STATS_DUMP_LEN(num_endpoints)) {
+        return -ENOMEM;
+    }
+
+    out[0] = DLT_STATS_VERSION;
+    out[1] = num_endpoints;
+    out[2] = DLT_STATS_HIST_BINS;
+
+    uint8_t *pos = &out[DLT_STATS_HEADER_LEN];
+    for (uint8_t ep = 0; ep < num_endpoints; ep++) {
+        dlt_stats_get(ep, &stats);
+        pos = dlt_stats_encode_ep(pos, &stats);
+    }
+
+    return pos - out;
+}
+
+#ifdef CONFIG_SHELL
+/* Print a latency histogram, skipping empty bins */
+static void dlt_stats_print_hist(const struct shell *sh, const char *name,
+                                 const uint32_t *hist)
+{
+    shell_print(sh, "  %s latency (us):", name);
+    for (int i = 0; i < DLT_STATS_HIST_BINS; i++) {
+        if (!hist[i]) {
+            continue;
+        }
+        if (i == DLT_STATS_HIST_BINS - 1) {
+            shell_print(sh, "    >= %u: %u", 1U << (i - 1), hist[i]);
+        } else {
+            shell_print(sh, "    < %u: %u", 1U << i, hist[i]);
+        }
+    }
+}
+
+static int cmd_dlt_stats(const struct shell *sh, size_t argc, char **argv)
+{
+    struct dlt_stats stats;
+
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset"))) {
+        shell_print(sh, "Usage:\n"
+                        "    dlt stats [reset]");
+        return 1;
+    }
+
+    for (uint8_t ep = 0; ep < dlt_stats_endpoints(); ep++) {
+        if (argc == 2) {
+            dlt_stats_reset(ep);
+            continue;
+        }
+
+        dlt_stats_get(ep, &stats);
+        shell_print(sh, "Endpoint %u:", ep);
+        shell_print(sh, "  tx: %u msgs, %u bytes, max depth %u",
+                    stats.tx_msgs, stats.tx_bytes, stats.tx_max_depth);
+        shell_print(sh, "  rx: %u msgs, %u bytes, max depth %u",
+                    stats.rx_msgs, stats.rx_bytes, stats.rx_max_depth);
+        shell_print(sh, "  drops: %u, truncations: %u",
+                    stats.drops, stats.truncations);
+        if (stats.link.bit_rate) {
+            shell_print(sh, "  link: %u bit/s, interval %u us, latency %u, "
+                            "data length %u", stats.link.bit_rate,
+                        stats.link.interval_us, stats.link.latency,
+                        stats.link.data_len);
+        }
+        dlt_stats_print_hist(sh, "tx", stats.tx_latency);
+        dlt_stats_print_hist(sh, "rx", stats.rx_latency);
+    }
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(dlt_cmds,
+    SHELL_CMD_ARG(stats, NULL, "Show or reset DLT endpoint statistics.",
+                  cmd_dlt_stats, 1, 1),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(dlt, &dlt_cmds, "Device Link Transfer commands.", NULL);
+#endif
+#endif
@@ -0,0 +1,815 @@
+/**
+ * @file main.c
+ *
+ * @brief Base station aircraft tracking, geometry, filtering, scheduling,
+ * prediction and Pi update tests.
+ *
+ * Runs the base station's aircraft modules on the host. Time is passed in
+ * explicitly, so nothing here sleeps.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include <pb_encode.h>
+
+#include "adsb_predict.h"
+#include "base_aircraft.h"
+#include "base_geo.h"
+#include "base_pi.h"
+#include "base_sched.h"
+#include "base_sky.h"
+#include "dlt_api.h"
+
+#define TEST_ICAO 0x7C6B2D
+
+#define TEST_EXPIRY_MS (CONFIG_BASE_AIRCRAFT_EXPIRY_S * 1000U)
+
+/* Largest difference from the rhumb line bearing within ADS-B range */
+#define TEST_AZIMUTH_TOLERANCE 0.1f
+
+static const struct base_aircraft_state test_state = {
+    .lat = -27.4698f,
+    .lon = 153.0251f,
+    .altitude = 12000,
+    .track = 270,
+    .speed = 250,
+};
+
+ZTEST(base_aircraft, test_update_find)
+{
+    zassert_is_null(base_aircraft_find(TEST_ICAO));
+    zassert_is_null(base_aircraft_update(0, &test_state, 0));
+
+    struct base_aircraft *ac = base_aircraft_update(TEST_ICAO, &test_state,
+                                                    100);
+    zassert_not_null(ac);
+    zassert_equal(ac->icao, TEST_ICAO);
+    zassert_equal(ac->updated_ms, 100);
+    zassert_equal(base_aircraft_find(TEST_ICAO), ac);
+    zassert_equal(base_aircraft_count(), 1);
+
+    /* Updates land on the same entry, upper bits are ignored */
+    struct base_aircraft_state state = test_state;
+    state.altitude += 100;
+    zassert_equal(base_aircraft_update(0xFF000000 | TEST_ICAO, &state, 200),
+                  ac);
+    zassert_equal(ac->latest.altitude, state.altitude);
+    zassert_equal(base_aircraft_count(), 1);
+
+    base_aircraft_remove(ac);
+    zassert_is_null(base_aircraft_find(TEST_ICAO));
+    zassert_equal(base_aircraft_count(), 0);
+}
+
+ZTEST(base_aircraft, test_revision)
+{
+    struct base_aircraft *ac = base_aircraft_update(TEST_ICAO, &test_state, 0);
+    uint32_t revision = ac->revision;
+
+    zassert_not_equal(revision, 0);
+
+    /* A repeat of the same state keeps the revision */
+    base_aircraft_update(TEST_ICAO, &test_state, 10);
+    zassert_equal(ac->revision, revision);
+    zassert_equal(ac->updated_ms, 10);
+
+    /* A changed state bumps it */
+    struct base_aircraft_state state = test_state;
+    state.track = 271;
+    base_aircraft_update(TEST_ICAO, &state, 20);
+    zassert_not_equal(ac->revision, revision);
+
+    revision = ac->revision;
+    strcpy(state.flight, "QFA12");
+    base_aircraft_update(TEST_ICAO, &state, 30);
+    zassert_not_equal(ac->revision, revision);
+}
+
+ZTEST(base_aircraft, test_expire)
+{
+    base_aircraft_update(TEST_ICAO, &test_state, 0);
+    base_aircraft_update(TEST_ICAO + 1, &test_state, 5000);
+
+    /* Nothing is old enough yet */
+    zassert_equal(base_aircraft_expire(TEST_EXPIRY_MS - 1,
+                                       CONFIG_BASE_AIRCRAFT_TABLE_SIZE), 0);
+
+    /* The sweep resumes where it stopped, so the whole table is covered */
+    int expired = 0;
+    for (int i = 0; i < CONFIG_BASE_AIRCRAFT_TABLE_SIZE; i++) {
+        expired += base_aircraft_expire(TEST_EXPIRY_MS, 1);
+    }
+    zassert_equal(expired, 1);
+    zassert_is_null(base_aircraft_find(TEST_ICAO));
+    zassert_not_null(base_aircraft_find(TEST_ICAO + 1));
+    zassert_equal(base_aircraft_count(), 1);
+}
+
+ZTEST(base_aircraft, test_evict_stalest)
+{
+    base_aircraft_update(TEST_ICAO, &test_state, 0);
+
+    /* Fill well past capacity while keeping one aircraft fresh */
+    for (uint32_t i = 1; i <= 4 * CONFIG_BASE_AIRCRAFT_TABLE_SIZE; i++) {
+        zassert_not_null(base_aircraft_update(TEST_ICAO, &test_state, i));
+
+        struct base_aircraft *ac = base_aircraft_update(TEST_ICAO + i * 7919,
+                                                        &test_state, i);
+        zassert_not_null(ac);
+        zassert_equal(base_aircraft_find(TEST_ICAO + i * 7919), ac);
+        zassert_true(base_aircraft_count() <= CONFIG_BASE_AIRCRAFT_TABLE_SIZE);
+    }
+
+    zassert_not_null(base_aircraft_find(TEST_ICAO));
+    zassert_is_null(base_aircraft_find(TEST_ICAO + 7919));
+}
+
+static void base_aircraft_test_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    base_aircraft_clear();
+}
+
+ZTEST_SUITE(base_aircraft, NULL, NULL, base_aircraft_test_before, NULL, NULL);
+
+/* Observers around the world, including either side of the antimeridian */
+static const float test_observers[][2] = {
+    {-27.4698f, 153.0251f},
+    {-60.0f, -70.0f},
+    {0.0f, 0.0f},
+    {45.0f, 179.9f},
+    {60.0f, -179.9f},
+};
+
+/* Position range metres along the great circle leaving at bearing degrees */
+static void test_offset(float lat, float lon, float range, float bearing,
+                        float *to_lat, float *to_lon)
+{
+    double phi = lat * M_PI / 180.0;
+    double b = bearing * M_PI / 180.0;
+    double d = range / BASE_GEO_EARTH_RADIUS_M;
+
+    double phi2 = asin(sin(phi) * cos(d) + cos(phi) * sin(d) * cos(b));
+    double dlambda = atan2(sin(b) * sin(d) * cos(phi),
+                           cos(d) - sin(phi) * sin(phi2));
+
+    *to_lat = phi2 * 180.0 / M_PI;
+    *to_lon = lon + dlambda * 180.0 / M_PI;
+    if (*to_lon > 180.0f) {
+        *to_lon -= 360.0f;
+    } else if (*to_lon < -180.0f) {
+        *to_lon += 360.0f;
+    }
+}
+
+ZTEST(base_geo, test_frame_cached)
+{
+    struct base_geo_frame frame = {0};
+
+    zassert_true(base_geo_frame_update(&frame, -27.4698f, 153.0251f, 0.f));
+    zassert_false(base_geo_frame_update(&frame, -27.4698f, 153.0251f, 0.f));
+    zassert_true(base_geo_frame_update(&frame, -27.4699f, 153.0251f, 0.f));
+}
+
+ZTEST(base_geo, test_azimuth_matches_rhumb)
+{
+    static const float ranges[] = {5e3f, 50e3f, 150e3f, 300e3f};
+
+    ARRAY_FOR_EACH(test_observers, o) {
+        struct base_geo_frame frame = {0};
+        float lat = test_observers[o][0];
+        float lon = test_observers[o][1];
+
+        base_geo_frame_update(&frame, lat, lon, 0.f);
+
+        ARRAY_FOR_EACH(ranges, r) {
+            for (int bearing = 0; bearing < 360; bearing += 15) {
+                struct base_geo_enu enu;
+                struct base_geo_look look;
+                float to_lat, to_lon;
+
+                test_offset(lat, lon, ranges[r], bearing, &to_lat, &to_lon);
+                base_geo_enu(&frame, to_lat, to_lon, 0.f, &enu);
+                base_geo_look(&enu, &look);
+
+                float rhumb = base_geo_rhumb_bearing(lat, lon, to_lat, to_lon);
+                float error = fabsf(look.azimuth - rhumb);
+                if (error > 180.0f) {
+                    error = 360.0f - error;
+                }
+                zassert_true(error <= TEST_AZIMUTH_TOLERANCE,
+                             "observer %d, %d m at %d: %f vs rhumb %f", o,
+                             (int)ranges[r], bearing, (double)look.azimuth,
+                             (double)rhumb);
+                zassert_within(look.range, ranges[r], ranges[r] * 0.005f);
+            }
+        }
+    }
+}
+
+ZTEST(base_geo, test_elevation)
+{
+    struct base_geo_frame frame = {0};
+    struct base_geo_enu enu;
+    struct base_geo_look look;
+    float lat, lon;
+
+    base_geo_frame_update(&frame, -27.4698f, 153.0251f, 100.f);
+
+    /* Straight up */
+    base_geo_enu(&frame, frame.lat, frame.lon, 1100.f, &enu);
+    base_geo_look(&enu, &look);
+    zassert_within(look.elevation, 90.f, 0.01f);
+    zassert_within(look.range, 1000.f, 1.f);
+
+    /* 10 km out and 10 km up */
+    test_offset(frame.lat, frame.lon, 10e3f, 90.f, &lat, &lon);
+    base_geo_enu(&frame, lat, lon, 10100.f, &enu);
+    base_geo_look(&enu, &look);
+    zassert_within(look.azimuth, 90.f, 0.1f);
+    zassert_within(look.elevation, 45.f, 0.1f);
+
+    /* At the observer's height 100 km out, below the horizon by d / 2R */
+    test_offset(frame.lat, frame.lon, 100e3f, 0.f, &lat, &lon);
+    base_geo_enu(&frame, lat, lon, 100.f, &enu);
+    base_geo_look(&enu, &look);
+    zassert_within(look.elevation, -0.45f, 0.02f);
+}
+
+ZTEST_SUITE(base_geo, NULL, NULL, NULL, NULL, NULL);
+
+/* ENU position at an azimuth and elevation, range metres out */
+static struct base_geo_enu test_enu(float azimuth, float elevation,
+                                    float range)
+{
+    double az = azimuth * M_PI / 180.0;
+    double el = elevation * M_PI / 180.0;
+
+    return (struct base_geo_enu){
+        .east = range * sin(az) * cos(el),
+        .north = range * cos(az) * cos(el),
+        .up = range * sin(el),
+    };
+}
+
+ZTEST(base_sky, test_patch_cone)
+{
+    struct base_sky_patch patch;
+    struct base_geo_enu enu;
+
+    /* Level and facing east, 30 degrees either side */
+    base_sky_patch_set(&patch, 90.f, 0.f, 30.f, 0.f);
+
+    enu = test_enu(90.f, 5.f, 50e3f);
+    zassert_true(base_sky_patch_contains(&patch, &enu));
+    enu = test_enu(115.f, 10.f, 50e3f);
+    zassert_true(base_sky_patch_contains(&patch, &enu));
+    enu = test_enu(125.f, 0.5f, 50e3f);
+    zassert_false(base_sky_patch_contains(&patch, &enu));
+
+    /* On the bearing, but overhead or behind */
+    enu = test_enu(90.f, 60.f, 10e3f);
+    zassert_false(base_sky_patch_contains(&patch, &enu));
+    enu = test_enu(270.f, 5.f, 50e3f);
+    zassert_false(base_sky_patch_contains(&patch, &enu));
+
+    /* Pitched up, overhead from any bearing is in view */
+    base_sky_patch_set(&patch, 90.f, 80.f, 30.f, 0.f);
+    enu = test_enu(270.f, 85.f, 10e3f);
+    zassert_true(base_sky_patch_contains(&patch, &enu));
+    enu = test_enu(90.f, 5.f, 50e3f);
+    zassert_false(base_sky_patch_contains(&patch, &enu));
+}
+
+ZTEST(base_sky, test_patch_wide)
+{
+    struct base_sky_patch patch;
+    struct base_geo_enu enu;
+
+    /* Wider than a hemisphere, only straight behind is out of view */
+    base_sky_patch_set(&patch, 0.f, 0.f, 150.f, 0.f);
+
+    enu = test_enu(120.f, 1.f, 50e3f);
+    zassert_true(base_sky_patch_contains(&patch, &enu));
+    enu = test_enu(180.f, 10.f, 50e3f);
+    zassert_false(base_sky_patch_contains(&patch, &enu));
+}
+
+ZTEST(base_sky, test_patch_range_horizon)
+{
+    struct base_sky_patch patch;
+    struct base_geo_enu enu;
+
+    base_sky_patch_set(&patch, 0.f, 0.f, 45.f, 100e3f);
+
+    enu = test_enu(0.f, 2.f, 99e3f);
+    zassert_true(base_sky_patch_contains(&patch, &enu));
+    enu = test_enu(0.f, 2.f, 101e3f);
+    zassert_false(base_sky_patch_contains(&patch, &enu));
+
+    /* Hidden by the curvature of the Earth */
+    enu = test_enu(0.f, -0.5f, 50e3f);
+    zassert_equal(base_sky_patch_contains(&patch, &enu),
+                  !IS_ENABLED(CONFIG_BASE_SKY_HORIZON));
+}
+
+ZTEST(base_sky, test_batch)
+{
+    static const float patches[][4] = {
+        {90.f, 0.f, 30.f, 0.f},
+        {200.f, 45.f, 10.f, 0.f},
+        {10.f, -5.f, 150.f, 0.f},
+        {300.f, 20.f, 60.f, 80e3f},
+    };
+    static struct base_sky_batch batch;
+    struct base_geo_enu enu[BASE_SKY_BATCH_SIZE];
+    float cos[BASE_SKY_BATCH_SIZE];
+    uint32_t mask[BASE_SKY_MASK_WORDS];
+    uint32_t seed = 1;
+
+    /* Every other slot holds an aircraft, anywhere within 150 km */
+    base_sky_batch_clear(&batch);
+    for (int i = 0; i < BASE_SKY_BATCH_SIZE; i += 2) {
+        seed = seed * 1103515245U + 12345U;
+        float azimuth = (seed >> 8) % 3600 / 10.f;
+        seed = seed * 1103515245U + 12345U;
+        float elevation = (int)((seed >> 8) % 1000) / 10.f - 10.f;
+        seed = seed * 1103515245U + 12345U;
+        enu[i] = test_enu(azimuth, elevation, 1e3f + (seed >> 8) % 149000);
+        base_sky_batch_set(&batch, i, &enu[i]);
+    }
+
+    ARRAY_FOR_EACH(patches, p) {
+        struct base_sky_patch patch;
+
+        base_sky_patch_set(&patch, patches[p][0], patches[p][1],
+                           patches[p][2], patches[p][3]);
+        base_sky_batch_cos(&patch, &batch, cos);
+        base_sky_batch_mask(&patch, &batch, cos, mask);
+
+        for (int i = 0; i < BASE_SKY_BATCH_SIZE; i++) {
+            if (i % 2) {
+                zassert_false(base_sky_mask_test(mask, i));
+                continue;
+            }
+
+            float expected = base_sky_patch_cos(&patch, &enu[i]);
+            zassert_within(cos[i], expected, 1e-5f);
+
+            /* Too close to the edge to agree on */
+            if (fabsf(expected - patch.cos_aperture) < 1e-5f) {
+                continue;
+            }
+            zassert_equal(base_sky_mask_test(mask, i),
+                          base_sky_patch_contains(&patch, &enu[i]),
+                          "patch %d slot %d", (int)p, i);
+        }
+    }
+
+    /* Range 0 is no limit, so the whole sky holds every aircraft */
+    struct base_sky_patch patch;
+
+    base_sky_patch_set(&patch, 0.f, 90.f, 180.f, 0.f);
+    base_sky_batch_cos(&patch, &batch, cos);
+    base_sky_batch_mask(&patch, &batch, cos, mask);
+    for (int i = 0; i < BASE_SKY_BATCH_SIZE; i += 2) {
+        bool visible = !IS_ENABLED(CONFIG_BASE_SKY_HORIZON) || enu[i].up >= 0;
+
+        zassert_equal(base_sky_mask_test(mask, i), visible, "slot %d", i);
+        zassert_equal(base_sky_patch_contains(&patch, &enu[i]), visible,
+                      "slot %d", i);
+    }
+}
+
+ZTEST_SUITE(base_sky, NULL, NULL, NULL, NULL, NULL);
+
+#define TEST_SCHED_LAT -27.4698f
+#define TEST_SCHED_LON 153.0251f
+#define TEST_SCHED_MSG 40
+
+/* Every aircraft sent, in order, with the display it went to */
+static uint32_t test_sent[64];
+static int test_sent_display[64];
+static int test_sent_count;
+
+static int test_sched_send(int display, const struct base_aircraft *aircraft,
+                           size_t budget, void *user_data)
+{
+    ARG_UNUSED(user_data);
+
+    if (budget < TEST_SCHED_MSG) {
+        return -ENOSPC;
+    }
+    zassert_true(test_sent_count < ARRAY_SIZE(test_sent));
+    test_sent_display[test_sent_count] = display;
+    test_sent[test_sent_count++] = aircraft->icao;
+    return TEST_SCHED_MSG;
+}
+
+/* Track a hovering aircraft at an azimuth and elevation, 50 km out */
+static void test_sched_add(uint32_t icao, float azimuth, float elevation,
+                           uint32_t now_ms)
+{
+    struct base_aircraft_state state = test_state;
+    float range = 50e3f;
+
+    /* Stays where it is put between updates */
+    state.speed = 0;
+
+    test_offset(TEST_SCHED_LAT, TEST_SCHED_LON, range, azimuth, &state.lat,
+                &state.lon);
+    state.altitude = (range * tanf(elevation * M_PI / 180.0f) +
+                      range * range / (2 * BASE_GEO_EARTH_RADIUS_M)) / 0.3048f;
+    zassert_not_null(base_aircraft_update(icao, &state, now_ms));
+}
+
+static struct base_geo_frame test_sched_frame;
+
+static int test_sched_run(struct base_sched_display *displays, int count,
+                          uint32_t now_ms)
+{
+    test_sent_count = 0;
+    return base_sched_run(displays, count, &test_sched_frame, now_ms,
+                          test_sched_send, NULL);
+}
+
+ZTEST(base_sched, test_rank)
+{
+    struct base_sched_display display;
+
+    base_sched_init(&display, 0, 0);
+    base_sched_point(&display, 90.f, 5.f, 30.f, 0.f);
+
+    /* Out of view, then in view from the edge inwards */
+    test_sched_add(1, 270.f, 5.f, 0);
+    test_sched_add(2, 115.f, 5.f, 0);
+    test_sched_add(3, 90.f, 5.f, 0);
+    test_sched_add(4, 100.f, 5.f, 0);
+
+    zassert_equal(test_sched_run(&display, 1, 0), 3);
+    zassert_equal(test_sent[0], 3);
+    zassert_equal(test_sent[1], 4);
+    zassert_equal(test_sent[2], 2);
+
+    /* Nothing has changed, so nothing is resent until the refresh */
+    zassert_equal(test_sched_run(&display, 1, 50), 0);
+    test_sched_add(2, 115.f, 6.f, 60);
+    zassert_equal(test_sched_run(&display, 1, 100), 1);
+    zassert_equal(test_sent[0], 2);
+    zassert_equal(test_sched_run(&display, 1,
+                                 CONFIG_BASE_AIRCRAFT_REFRESH_MS), 2);
+}
+
+ZTEST(base_sched, test_readded)
+{
+    struct base_sched_display display;
+
+    base_sched_init(&display, 0, 0);
+    base_sched_point(&display, 90.f, 5.f, 30.f, 0.f);
+
+    test_sched_add(1, 90.f, 5.f, 0);
+    zassert_equal(test_sched_run(&display, 1, 0), 1);
+
+    /* Expired and heard from again in the same slot, it is news */
+    base_aircraft_remove(base_aircraft_find(1));
+    test_sched_add(1, 95.f, 5.f, 60);
+    zassert_equal(test_sched_run(&display, 1, 100), 1);
+    zassert_equal(test_sent[0], 1);
+}
+
+ZTEST(base_sched, test_top_k)
+{
+    struct base_sched_display display;
+
+    base_sched_init(&display, 0, 0);
+    base_sched_point(&display, 0.f, 5.f, 60.f, 0.f);
+
+    /* More aircraft than are sent a period, spread off the boresight */
+    for (int i = 0; i < CONFIG_BASE_SCHED_TOP_K + 4; i++) {
+        test_sched_add(100 + i, (i % 2 ? 4.f : -4.f) * i, 5.f, 0);
+    }
+
+    zassert_equal(test_sched_run(&display, 1, 0), CONFIG_BASE_SCHED_TOP_K);
+    for (int i = 0; i < CONFIG_BASE_SCHED_TOP_K; i++) {
+        zassert_equal(test_sent[i], 100 + i);
+    }
+
+    /* The rest go next period */
+    zassert_equal(test_sched_run(&display, 1, 50), 4);
+}
+
+ZTEST(base_sched, test_budget)
+{
+    struct base_sched_display display;
+    int sent = 0;
+
+    /* Enough for 10 messages a second, bursts of 2 at the most */
+    base_sched_init(&display, 10 * TEST_SCHED_MSG, 0);
+    base_sched_point(&display, 0.f, 5.f, 60.f, 0.f);
+
+    for (uint32_t now = 0; now < 1000; now += CONFIG_BASE_SCHED_PERIOD_MS) {
+        /* Every aircraft changes every period */
+        for (int i = 0; i < 6; i++) {
+            test_sched_add(200 + i, 5.f * i, 5.f + now / 1000.f, now);
+        }
+        sent += test_sched_run(&display, 1, now);
+        zassert_true(test_sent_count <= 2);
+    }
+    zassert_between_inclusive(sent, 9, 11);
+}
+
+ZTEST(base_sched, test_stale_first)
+{
+    struct base_sched_display display;
+
+    base_sched_init(&display, 0, 0);
+    base_sched_point(&display, 0.f, 5.f, 30.f, 0.f);
+
+    test_sched_add(1, 0.f, 5.f, 0);
+    test_sched_add(2, 20.f, 5.f, 0);
+    zassert_equal(test_sched_run(&display, 1, 0), 2);
+
+    /* Both change, but the near one was sent since, so the far one leads */
+    test_sched_add(1, 0.f, 6.f, 900);
+    zassert_equal(test_sched_run(&display, 1, 900), 1);
+    test_sched_add(1, 0.f, 7.f, 950);
+    test_sched_add(2, 20.f, 6.f, 950);
+    zassert_equal(test_sched_run(&display, 1, 950), 2);
+    zassert_equal(test_sent[0], 2);
+}
+
+ZTEST(base_sched, test_hysteresis)
+{
+    struct base_sched_display display;
+
+    base_sched_init(&display, 0, 0);
+    base_sched_point(&display, 0.f, 5.f, 30.f, 0.f);
+
+    /* Just beyond the aperture, not in view */
+    float edge = 30.f + CONFIG_BASE_SCHED_HYSTERESIS_DEG / 2.f;
+    test_sched_add(1, edge, 5.f, 0);
+    zassert_equal(test_sched_run(&display, 1, 0), 0);
+
+    /* Once inside, it stays in view out to the same angle */
+    test_sched_add(1, 29.f, 5.f, 10);
+    zassert_equal(test_sched_run(&display, 1, 10), 1);
+    test_sched_add(1, edge, 5.f, 20);
+    zassert_equal(test_sched_run(&display, 1, 20), 1);
+
+    /* Beyond the hysteresis it leaves */
+    test_sched_add(1, 31.f + CONFIG_BASE_SCHED_HYSTERESIS_DEG, 5.f, 30);
+    zassert_equal(test_sched_run(&display, 1, 30), 0);
+    test_sched_add(1, edge, 5.f, 40);
+    zassert_equal(test_sched_run(&display, 1, 40), 0);
+}
+
+ZTEST(base_sched, test_displays)
+{
+    struct base_sched_display displays[2];
+
+    base_sched_init(&displays[0], 0, 0);
+    base_sched_init(&displays[1], 0, 0);
+    base_sched_point(&displays[0], 0.f, 5.f, 30.f, 0.f);
+    base_sched_point(&displays[1], 180.f, 5.f, 30.f, 0.f);
+
+    test_sched_add(1, 0.f, 5.f, 0);
+    test_sched_add(2, 180.f, 5.f, 0);
+
+    zassert_equal(test_sched_run(displays, 2, 0), 2);
+    zassert_equal(test_sent[0], 1);
+    zassert_equal(test_sent_display[0], 0);
+    zassert_equal(test_sent[1], 2);
+    zassert_equal(test_sent_display[1], 1);
+
+    /* A new aircraft in a reused slot is sent, whatever was there before */
+    base_aircraft_clear();
+    test_sched_add(3, 0.f, 5.f, 10);
+    zassert_equal(test_sched_run(displays, 2, 10), 1);
+    zassert_equal(test_sent[0], 3);
+}
+
+static void base_sched_test_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    base_aircraft_clear();
+    base_geo_frame_update(&test_sched_frame, TEST_SCHED_LAT, TEST_SCHED_LON,
+                          0.f);
+}
+
+ZTEST_SUITE(base_sched, NULL, NULL, base_sched_test_before, NULL, NULL);
+
+/* Reports every 5 s at 250 knots, as an aircraft in cruise */
+#define TEST_PREDICT_PERIOD_MS 5000
+#define TEST_PREDICT_MPS       (250 * 0.514444f)
+
+/* Horizontal distance between two positions, metres */
+static float test_distance(float lat, float lon, float to_lat, float to_lon)
+{
+    struct base_geo_frame frame = {0};
+    struct base_geo_enu enu;
+
+    base_geo_frame_update(&frame, lat, lon, 0.f);
+    base_geo_enu(&frame, to_lat, to_lon, 0.f, &enu);
+    return sqrtf(enu.east * enu.east + enu.north * enu.north);
+}
+
+/* Report an aircraft flying out along a bearing from the start of its
+ * track, climbing at a rate in feet per minute */
+static void test_predict_report(struct adsb_predict *predict, float bearing,
+                                float climb, uint32_t now_ms)
+{
+    struct adsb_predict_fix fix = {
+        .altitude = 10000.f + climb * now_ms / 60000.f,
+        .speed = 250.f,
+        .track = bearing,
+    };
+
+    test_offset(test_state.lat, test_state.lon,
+                TEST_PREDICT_MPS * now_ms / 1000.f, bearing, &fix.lat,
+                &fix.lon);
+    adsb_predict_update(predict, &fix, now_ms);
+}
+
+ZTEST(adsb_predict, test_straight)
+{
+    static const float bearings[] = {0.f, 90.f, 225.f, 300.f};
+
+    ARRAY_FOR_EACH(bearings, b) {
+        struct adsb_predict predict = {0};
+        struct adsb_predict_fix fix;
+        uint32_t now = 0;
+
+        for (int i = 0; i < 6; i++, now += TEST_PREDICT_PERIOD_MS) {
+            test_predict_report(&predict, bearings[b], 0.f, now);
+        }
+        now -= TEST_PREDICT_PERIOD_MS;
+
+        /* Most of the way to the next report, where the aircraft is */
+        float lat, lon;
+        test_offset(test_state.lat, test_state.lon,
+                    TEST_PREDICT_MPS * (now + 4000) / 1000.f, bearings[b],
+                    &lat, &lon);
+        adsb_predict_at(&predict, now + 4000, &fix);
+        zassert_true(test_distance(lat, lon, fix.lat, fix.lon) < 30.f,
+                     "bearing %.0f", (double)bearings[b]);
+        zassert_within(fix.altitude, 10000.f, 10.f);
+        zassert_within(fix.speed, 250.f, 1.f);
+        zassert_within(fmodf(fix.track - bearings[b] + 540.f, 360.f), 180.f,
+                       0.5f);
+
+        /* Without a prediction the aircraft would be shown 500 m back */
+        zassert_true(test_distance(lat, lon, predict.lat, predict.lon) >
+                     500.f);
+    }
+}
+
+ZTEST(adsb_predict, test_climb)
+{
+    struct adsb_predict predict = {0};
+    struct adsb_predict_fix fix;
+    uint32_t now = 0;
+
+    /* The climb rate is learnt from the altitudes alone */
+    for (int i = 0; i < 8; i++, now += TEST_PREDICT_PERIOD_MS) {
+        test_predict_report(&predict, 90.f, 2000.f, now);
+    }
+    now -= TEST_PREDICT_PERIOD_MS;
+
+    adsb_predict_at(&predict, now + 4000, &fix);
+    zassert_within(fix.altitude, 10000.f + 2000.f * (now + 4000) / 60000.f,
+                   30.f);
+}
+
+ZTEST(adsb_predict, test_horizon)
+{
+    struct adsb_predict predict = {0};
+    struct adsb_predict_fix held, later;
+    uint32_t horizon_ms = CONFIG_ADSB_PREDICT_HORIZON_S * 1000U;
+
+    test_predict_report(&predict, 90.f, 0.f, 0);
+    adsb_predict_at(&predict, horizon_ms, &held);
+    adsb_predict_at(&predict, horizon_ms + 60000, &later);
+    zassert_equal(held.lat, later.lat);
+    zassert_equal(held.lon, later.lon);
+
+    /* A report after the horizon starts again from it */
+    test_predict_report(&predict, 90.f, 0.f, horizon_ms + 60000);
+    adsb_predict_at(&predict, horizon_ms + 60000, &later);
+    zassert_within(test_distance(later.lat, later.lon, predict.lat,
+                                 predict.lon), 0.f, 1.f);
+}
+
+ZTEST(adsb_predict, test_outlier)
+{
+    struct adsb_predict predict = {0};
+    struct adsb_predict_fix fix = {
+        .lat = test_state.lat,
+        .lon = test_state.lon,
+        .altitude = 10000.f,
+    };
+
+    for (uint32_t now = 0; now < 30000; now += TEST_PREDICT_PERIOD_MS) {
+        adsb_predict_update(&predict, &fix, now);
+    }
+
+    /* A jump far beyond the noise is taken as it is, not averaged */
+    fix.lat += 0.05f;
+    adsb_predict_update(&predict, &fix, 30000);
+    struct adsb_predict_fix at;
+    adsb_predict_at(&predict, 30000, &at);
+    zassert_within(at.lat, fix.lat, 1e-5f);
+    zassert_within(at.lon, fix.lon, 1e-5f);
+}
+
+ZTEST(adsb_predict, test_aircraft)
+{
+    struct base_aircraft_state state;
+
+    /* The aircraft flies west between updates */
+    base_aircraft_clear();
+    struct base_aircraft *aircraft = base_aircraft_update(TEST_ICAO,
+                                                          &test_state, 0);
+    base_aircraft_predict(aircraft, 10000, &state);
+    zassert_within(test_distance(test_state.lat, test_state.lon, state.lat,
+                                 state.lon),
+                   TEST_PREDICT_MPS * 10.f, 10.f);
+    zassert_true(state.lon < test_state.lon);
+    zassert_equal(state.altitude, test_state.altitude);
+    zassert_equal(state.track, test_state.track);
+
+    /* A repeated report does not correct the prediction */
+    base_aircraft_update(TEST_ICAO, &test_state, 10000);
+    base_aircraft_predict(aircraft, 10000, &state);
+    zassert_true(state.lon < test_state.lon);
+}
+
+ZTEST_SUITE(adsb_predict, NULL, NULL, NULL, NULL, NULL);
+
+/* The Pi's endpoint and the UART link's MTU, CONFIG_DLT_UART_MTU's default */
+#define TEST_PI_EP  0
+#define TEST_PI_MTU 50
+
+ZTEST(base_pi, test_read_fragmented)
+{
+    /* The longest strings and varints an update can carry */
+    ADSBData sent = {
+        .hex = "7c6b2d7c6",
+        .flight = "QFA123456",
+        .lat = -27.4698f,
+        .lon = 153.0251f,
+        .altitude = UINT32_MAX,
+        .track = UINT32_MAX,
+        .speed = UINT32_MAX,
+    };
+    uint8_t encoded[ADSBData_size];
+    pb_ostream_t stream = pb_ostream_from_buffer(encoded, sizeof(encoded));
+
+    zassert_true(pb_encode(&stream, ADSBData_fields, &sent));
+    zassert_true(stream.bytes_written > TEST_PI_MTU - DLT_PROTOCOL_BYTES);
+
+    /* Sent the way the Pi does, in fragments of the link MTU */
+    dlt_link_set_mtu(TEST_PI_EP, TEST_PI_MTU);
+    dlt_request(TEST_PI_EP, NULL, encoded, stream.bytes_written, true);
+
+    struct dlt_buf *buf;
+    int fragments = 0;
+    while ((buf = dlt_poll_buf(TEST_PI_EP, K_NO_WAIT)) != NULL) {
+        zassert_true(buf->len <= TEST_PI_MTU);
+        zassert_ok(dlt_submit_buf(TEST_PI_EP, buf));
+        fragments++;
+    }
+    zassert_true(fragments > 1);
+
+    ADSBData read;
+    zassert_ok(base_pi_read(TEST_PI_EP, &read));
+    zassert_mem_equal(read.hex, sent.hex, sizeof(sent.hex));
+    zassert_mem_equal(read.flight, sent.flight, sizeof(sent.flight));
+    zassert_equal(read.lat, sent.lat);
+    zassert_equal(read.lon, sent.lon);
+    zassert_equal(read.altitude, sent.altitude);
+    zassert_equal(read.track, sent.track);
+    zassert_equal(read.speed, sent.speed);
+
+    zassert_equal(base_pi_read(TEST_PI_EP, &read), -EAGAIN);
+}
+
+static void *base_pi_test_setup(void)
+{
+    dlt_device_register(k_current_get());
+    dlt_link_register(TEST_PI_EP, k_current_get());
+    return NULL;
+}
+
+static void base_pi_test_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    zassert_true(dlt_interface_init(1));
+}
+
+ZTEST_SUITE(base_pi, NULL, base_pi_test_setup, base_pi_test_before, NULL,
+            NULL);
@@ -0,0 +1,596 @@
+/**
+ * @file main.c
+ *
+ * @brief DLT library tests.
+ *
+ * Exercises the buffer pool transports from a single thread acting as both
+ * the Device and the Link. Nothing here waits on an empty queue, so one
+ * thread can produce and consume every endpoint direction.
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+
+#include "dlt_api.h"
+#include "dlt_parser.h"
+
+#define TEST_EP      0
+#define TEST_NUM_EPS 2
+
+/* Results recorded by the completion callback */
+static int test_done_calls;
+static int test_done_status;
+
+static void test_done(int status, void *user_data)
+{
+    ARG_UNUSED(user_data);
+
+    test_done_calls++;
+    test_done_status = status;
+}
+
+/* Send a request carrying a single byte of payload and an optional key */
+static int test_send_byte(uint8_t value, uint32_t key)
+{
+    struct dlt_buf *buf = dlt_buf_alloc(K_NO_WAIT);
+    zassert_not_null(buf);
+
+    dlt_buf_data(buf)[0] = value;
+    dlt_buf_set_key(buf, key);
+    return dlt_request_buf(TEST_EP, buf, 1);
+}
+
+/* Take the next packet from the Link side and return its first data byte */
+static uint8_t test_poll_byte(void)
+{
+    struct dlt_buf *buf = dlt_poll_buf(TEST_EP, K_NO_WAIT);
+    zassert_not_null(buf);
+
+    uint8_t value = dlt_buf_data(buf)[0];
+    dlt_buf_free(buf);
+    return value;
+}
+
+/* Hand every packet queued for the Link back to the Device side */
+static int test_loopback(void)
+{
+    struct dlt_buf *buf;
+    int count = 0;
+
+    while ((buf = dlt_poll_buf(TEST_EP, K_NO_WAIT)) != NULL) {
+        zassert_true(buf->len <= DLT_MAX_PACKET_LEN);
+        zassert_ok(dlt_submit_buf(TEST_EP, buf));
+        count++;
+    }
+    return count;
+}
+
+ZTEST(dlt, test_request_poll)
+{
+    uint8_t data[] = "hello";
+    uint8_t packet[DLT_MAX_PACKET_LEN];
+
+    dlt_request(TEST_EP, NULL, data, 5, true);
+
+    zassert_equal(dlt_poll(TEST_EP, packet, sizeof(packet), K_NO_WAIT), 8);
+    zassert_equal(packet[0], DLT_PREAMBLE);
+    zassert_equal(packet[1], DLT_REQUEST_CODE);
+    zassert_equal(packet[2], 5);
+    zassert_mem_equal(&packet[DLT_PROTOCOL_BYTES], data, 5);
+}
+
+ZTEST(dlt, test_submit_read)
+{
+    uint8_t packet[] = {DLT_PREAMBLE, DLT_RESPONSE_CODE, 3, 'a', 'b', 'c'};
+    uint8_t data[DLT_MAX_DATA_LEN];
+    uint8_t msg_type = 0;
+
+    dlt_submit(TEST_EP, packet, sizeof(packet), true);
+
+    zassert_equal(dlt_read(TEST_EP, &msg_type, data, sizeof(data), K_NO_WAIT),
+                  3);
+    zassert_equal(msg_type, DLT_RESPONSE_CODE);
+    zassert_mem_equal(data, "abc", 3);
+    zassert_equal(dlt_read(TEST_EP, &msg_type, data, sizeof(data), K_NO_WAIT),
+                  0);
+}
+
+ZTEST(dlt, test_read_too_small)
+{
+    uint8_t packet[] = {DLT_PREAMBLE, DLT_REQUEST_CODE, 4, 1, 2, 3, 4};
+    uint8_t data[2];
+    uint8_t msg_type;
+
+    dlt_submit(TEST_EP, packet, sizeof(packet), true);
+
+    /* The message is dropped rather than truncated */
+    zassert_equal(dlt_read(TEST_EP, &msg_type, data, sizeof(data), K_NO_WAIT),
+                  0);
+    zassert_is_null(dlt_read_buf(TEST_EP, K_NO_WAIT));
+}
+
+ZTEST(dlt, test_submit_malformed)
+{
+    struct dlt_buf *buf = dlt_buf_alloc(K_NO_WAIT);
+    zassert_not_null(buf);
+
+    /* Length byte claims more data than the packet holds */
+    buf->packet[0] = DLT_PREAMBLE;
+    buf->packet[1] = DLT_REQUEST_CODE;
+    buf->packet[2] = 10;
+    buf->len = 5;
+
+    zassert_equal(dlt_submit_buf(TEST_EP, buf), -EINVAL);
+    zassert_is_null(dlt_read_buf(TEST_EP, K_NO_WAIT));
+}
+
+ZTEST(dlt, test_pool_exhaustion)
+{
+    struct dlt_buf *bufs[CONFIG_DLT_BUF_COUNT];
+
+    for (int i = 0; i < CONFIG_DLT_BUF_COUNT; i++) {
+        bufs[i] = dlt_buf_alloc(K_NO_WAIT);
+        zassert_not_null(bufs[i]);
+    }
+    zassert_is_null(dlt_buf_alloc(K_NO_WAIT));
+
+    for (int i = 0; i < CONFIG_DLT_BUF_COUNT; i++) {
+        dlt_buf_free(bufs[i]);
+    }
+}
+
+ZTEST(dlt, test_completion)
+{
+    zassert_ok(dlt_link_set_flow(TEST_EP, 1, DLT_OVERFLOW_DROP_NEWEST));
+
+    struct dlt_buf *sent = dlt_buf_alloc(K_NO_WAIT);
+    dlt_buf_set_done(sent, test_done, NULL);
+    zassert_ok(dlt_request_buf(TEST_EP, sent, 0));
+    zassert_equal(test_done_calls, 0);
+
+    /* A send dropped for lack of credits completes straight away */
+    struct dlt_buf *dropped = dlt_buf_alloc(K_NO_WAIT);
+    dlt_buf_set_done(dropped, test_done, NULL);
+    zassert_equal(dlt_request_buf(TEST_EP, dropped, 0), -ENOBUFS);
+    zassert_equal(test_done_calls, 1);
+    zassert_equal(test_done_status, -ENOBUFS);
+
+    /* The sent packet completes once the Link releases it */
+    dlt_buf_free(dlt_poll_buf(TEST_EP, K_NO_WAIT));
+    zassert_equal(test_done_calls, 2);
+    zassert_equal(test_done_status, 0);
+}
+
+ZTEST(dlt, test_drop_newest)
+{
+    zassert_ok(dlt_link_set_flow(TEST_EP, 2, DLT_OVERFLOW_DROP_NEWEST));
+
+    zassert_ok(test_send_byte(1, 0));
+    zassert_ok(test_send_byte(2, 0));
+    zassert_equal(dlt_link_credits(TEST_EP), 0);
+    zassert_equal(test_send_byte(3, 0), -ENOBUFS);
+
+    zassert_equal(test_poll_byte(), 1);
+    zassert_equal(test_poll_byte(), 2);
+    zassert_is_null(dlt_poll_buf(TEST_EP, K_NO_WAIT));
+    zassert_equal(dlt_link_credits(TEST_EP), 2);
+}
+
+ZTEST(dlt, test_drop_oldest)
+{
+    zassert_ok(dlt_link_set_flow(TEST_EP, 2, DLT_OVERFLOW_DROP_OLDEST));
+
+    zassert_ok(test_send_byte(1, 0));
+    zassert_ok(test_send_byte(2, 0));
+    zassert_ok(test_send_byte(3, 0));
+    zassert_equal(dlt_link_credits(TEST_EP), 0);
+
+    zassert_equal(test_poll_byte(), 2);
+    zassert_equal(test_poll_byte(), 3);
+    zassert_is_null(dlt_poll_buf(TEST_EP, K_NO_WAIT));
+    zassert_equal(dlt_link_credits(TEST_EP), 2);
+}
+
+ZTEST(dlt, test_coalesce)
+{
+    zassert_ok(dlt_link_set_flow(TEST_EP, 4, DLT_OVERFLOW_COALESCE));
+
+    zassert_ok(test_send_byte(1, 100));
+    zassert_ok(test_send_byte(2, 200));
+    zassert_ok(test_send_byte(3, 100));
+    zassert_equal(dlt_link_credits(TEST_EP), 2);
+
+    /* Only the newest packet for each key reaches the Link */
+    zassert_equal(test_poll_byte(), 2);
+    zassert_equal(test_poll_byte(), 3);
+    zassert_is_null(dlt_poll_buf(TEST_EP, K_NO_WAIT));
+}
+
+ZTEST(dlt, test_coalesce_shared_pool)
+{
+    zassert_ok(dlt_link_set_flow(TEST_EP, 4, DLT_OVERFLOW_COALESCE));
+    zassert_ok(dlt_link_set_flow(1, 4, DLT_OVERFLOW_COALESCE));
+
+    /* The Link takes the packet, leaving its buffer in the coalescing slot */
+    zassert_ok(test_send_byte(1, 100));
+    zassert_equal(test_poll_byte(), 1);
+
+    /* The other endpoint reuses the buffer for the same key */
+    struct dlt_buf *buf = dlt_buf_alloc(K_NO_WAIT);
+    zassert_not_null(buf);
+    dlt_buf_data(buf)[0] = 2;
+    dlt_buf_set_key(buf, 100);
+    zassert_ok(dlt_request_buf(1, buf, 1));
+
+    /* A newer packet for the key must only replace packets on its own link */
+    zassert_ok(test_send_byte(3, 100));
+    zassert_equal(dlt_link_credits(1), 3);
+    zassert_equal(dlt_link_credits(TEST_EP), 3);
+
+    buf = dlt_poll_buf(1, K_NO_WAIT);
+    zassert_not_null(buf);
+    zassert_equal(dlt_buf_data(buf)[0], 2);
+    dlt_buf_free(buf);
+    zassert_equal(test_poll_byte(), 3);
+
+    zassert_equal(dlt_link_credits(1), 4);
+    zassert_equal(dlt_link_credits(TEST_EP), 4);
+}
+
+ZTEST(dlt, test_fragmentation)
+{
+#ifndef CONFIG_DLT_FRAGMENTATION
+    ztest_test_skip();
+#else
+    static uint8_t data[200];
+    static uint8_t read[sizeof(data)];
+    uint8_t msg_type;
+
+    for (int i = 0; i < ARRAY_SIZE(data); i++) {
+        data[i] = i;
+    }
+    dlt_link_set_mtu(TEST_EP, 32);
+    dlt_request(TEST_EP, NULL, data, sizeof(data), true);
+
+    /* 25 bytes per fragment after the headers */
+    zassert_equal(test_loopback(), DIV_ROUND_UP(sizeof(data), 25));
+
+    zassert_equal(dlt_read(TEST_EP, &msg_type, read, sizeof(read), K_NO_WAIT),
+                  sizeof(data));
+    zassert_equal(msg_type, DLT_REQUEST_CODE);
+    zassert_mem_equal(read, data, sizeof(data));
+#endif
+}
+
+ZTEST(dlt, test_fragment_lost)
+{
+#ifndef CONFIG_DLT_FRAGMENTATION
+    ztest_test_skip();
+#else
+    static uint8_t data[100];
+    static uint8_t read[sizeof(data)];
+    uint8_t msg_type;
+
+    dlt_link_set_mtu(TEST_EP, 32);
+    dlt_request(TEST_EP, NULL, data, sizeof(data), true);
+
+    /* Lose the second fragment on the way */
+    for (int i = 0; ; i++) {
+        struct dlt_buf *buf = dlt_poll_buf(TEST_EP, K_NO_WAIT);
+        if (!buf) {
+            break;
+        }
+        if (i == 1) {
+            dlt_buf_free(buf);
+        } else {
+            zassert_ok(dlt_submit_buf(TEST_EP, buf));
+        }
+    }
+
+    zassert_equal(dlt_read(TEST_EP, &msg_type, read, sizeof(read), K_NO_WAIT),
+                  0);
+
+    /* The fragments after the gap are dropped too */
+    while (dlt_read(TEST_EP, &msg_type, read, sizeof(read), K_NO_WAIT)) {
+        zassert_unreachable("Read part of a message");
+    }
+    zassert_is_null(dlt_read_buf(TEST_EP, K_NO_WAIT));
+#endif
+}
+
+ZTEST(dlt, test_fragment_interleaved)
+{
+#ifndef CONFIG_DLT_FRAGMENTATION
+    ztest_test_skip();
+#else
+    static uint8_t data[60];
+    static uint8_t read[sizeof(data)];
+    uint8_t other[] = {DLT_PREAMBLE, DLT_RESPONSE_CODE, 1, 0};
+    uint8_t msg_type;
+
+    for (int i = 0; i < ARRAY_SIZE(data); i++) {
+        data[i] = i;
+    }
+    dlt_link_set_mtu(TEST_EP, 32);
+    dlt_request(TEST_EP, NULL, data, sizeof(data), true);
+
+    /* Whole packets arrive between the fragments */
+    for (int i = 0; ; i++) {
+        struct dlt_buf *buf = dlt_poll_buf(TEST_EP, K_NO_WAIT);
+        if (!buf) {
+            break;
+        }
+        zassert_ok(dlt_submit_buf(TEST_EP, buf));
+        other[DLT_PROTOCOL_BYTES] = 'a' + i;
+        dlt_submit(TEST_EP, other, sizeof(other), true);
+    }
+
+    zassert_equal(dlt_read(TEST_EP, &msg_type, read, sizeof(read), K_NO_WAIT),
+                  sizeof(data));
+    zassert_mem_equal(read, data, sizeof(data));
+
+    /* and are still read, in order, once the message is done */
+    for (int i = 0; i < DIV_ROUND_UP(sizeof(data), 25); i++) {
+        zassert_equal(dlt_read(TEST_EP, &msg_type, read, sizeof(read),
+                               K_NO_WAIT), 1);
+        zassert_equal(msg_type, DLT_RESPONSE_CODE);
+        zassert_equal(read[0], 'a' + i);
+    }
+    zassert_is_null(dlt_read_buf(TEST_EP, K_NO_WAIT));
+#endif
+}
+
+ZTEST(dlt, test_aggregation)
+{
+#ifndef CONFIG_DLT_AGGREGATION
+    ztest_test_skip();
+#else
+    dlt_link_set_aggregation(TEST_EP, true);
+    for (int i = 1; i <= 3; i++) {
+        zassert_ok(test_send_byte(i, 0));
+    }
+
+    /* The burst is sent as one container */
+    struct dlt_buf *buf = dlt_poll_buf(TEST_EP, K_NO_WAIT);
+    zassert_not_null(buf);
+    zassert_equal(dlt_buf_msg_type(buf), DLT_AGGREGATE_CODE);
+    zassert_equal(buf->len, 4 * DLT_PROTOCOL_BYTES + 3);
+    zassert_is_null(dlt_poll_buf(TEST_EP, K_NO_WAIT));
+
+    /* and split into the original packets on the receiving side */
+    zassert_ok(dlt_submit_buf(TEST_EP, buf));
+    for (int i = 1; i <= 3; i++) {
+        buf = dlt_read_buf(TEST_EP, K_NO_WAIT);
+        zassert_not_null(buf);
+        zassert_equal(dlt_buf_msg_type(buf), DLT_REQUEST_CODE);
+        zassert_equal(dlt_buf_data(buf)[0], i);
+        dlt_buf_free(buf);
+    }
+#endif
+}
+
+ZTEST(dlt, test_stats)
+{
+#ifndef CONFIG_DLT_STATS
+    ztest_test_skip();
+#else
+    uint8_t packet[] = {DLT_PREAMBLE, DLT_REQUEST_CODE, 2, 1, 2};
+    uint8_t data[1];
+    uint8_t msg_type;
+    struct dlt_stats stats;
+
+    zassert_ok(dlt_link_set_flow(TEST_EP, 1, DLT_OVERFLOW_DROP_NEWEST));
+    zassert_ok(test_send_byte(1, 0));
+    zassert_equal(test_send_byte(2, 0), -ENOBUFS);
+    test_poll_byte();
+
+    dlt_submit(TEST_EP, packet, sizeof(packet), true);
+    dlt_read(TEST_EP, &msg_type, data, sizeof(data), K_NO_WAIT);
+
+    zassert_ok(dlt_stats_get(TEST_EP, &stats));
+    zassert_equal(stats.tx_msgs, 1);
+    zassert_equal(stats.tx_bytes, 1 + DLT_PROTOCOL_BYTES);
+    zassert_equal(stats.tx_max_depth, 1);
+    zassert_equal(stats.rx_msgs, 1);
+    zassert_equal(stats.rx_bytes, sizeof(packet));
+    zassert_equal(stats.rx_max_depth, 1);
+    zassert_equal(stats.drops, 1);
+    zassert_equal(stats.truncations, 1);
+
+    uint32_t latencies = 0;
+    for (int i = 0; i < DLT_STATS_HIST_BINS; i++) {
+        latencies += stats.tx_latency[i];
+    }
+    zassert_equal(latencies, 1);
+
+    /* Link parameters are reported as is and survive a reset */
+    struct dlt_link_info info = {
+        .bit_rate = 2000000, .interval_us = 7500, .latency = 0,
+        .data_len = 251,
+    };
+    dlt_link_set_info(TEST_EP, &info);
+
+    dlt_stats_reset(TEST_EP);
+    zassert_ok(dlt_stats_get(TEST_EP, &stats));
+    zassert_equal(stats.tx_msgs, 0);
+    zassert_equal(stats.drops, 0);
+    zassert_mem_equal(&stats.link, &info, sizeof(info));
+    zassert_equal(dlt_stats_get(TEST_NUM_EPS, &stats), -EINVAL);
+#endif
+}
+
+ZTEST(dlt, test_control_stats)
+{
+#ifndef CONFIG_DLT_STATS
+    ztest_test_skip();
+#else
+    uint8_t request[] = {DLT_PREAMBLE, DLT_CONTROL_CODE, 1, DLT_CTRL_STATS};
+    static uint8_t reply[1 + DLT_STATS_DUMP_LEN(TEST_NUM_EPS)];
+    uint8_t msg_type;
+
+    /* The request is answered instead of reaching the Device */
+    dlt_submit(TEST_EP, request, sizeof(request), true);
+    zassert_is_null(dlt_read_buf(TEST_EP, K_NO_WAIT));
+
+    zassert_true(test_loopback() > 1);
+    zassert_equal(dlt_read(TEST_EP, &msg_type, reply, sizeof(reply),
+                           K_NO_WAIT), sizeof(reply));
+    zassert_equal(msg_type, DLT_CONTROL_CODE);
+    zassert_equal(reply[0], DLT_CTRL_STATS | DLT_CTRL_REPLY);
+    zassert_equal(reply[1], DLT_STATS_VERSION);
+    zassert_equal(reply[2], TEST_NUM_EPS);
+    zassert_equal(reply[3], DLT_STATS_HIST_BINS);
+#endif
+}
+
+ZTEST(dlt, test_route)
+{
+    uint8_t request[] = {DLT_PREAMBLE, DLT_REQUEST_CODE, 1, 0x11};
+    uint8_t response[] = {DLT_PREAMBLE, DLT_RESPONSE_CODE, 1, 0x22};
+
+    zassert_ok(dlt_route_add(TEST_EP, DLT_RESPONSE_CODE, 1));
+
+    /* Responses go straight out of the other link, requests to the Device */
+    dlt_submit(TEST_EP, request, sizeof(request), true);
+    dlt_submit(TEST_EP, response, sizeof(response), true);
+
+    struct dlt_buf *buf = dlt_poll_buf(1, K_NO_WAIT);
+    zassert_not_null(buf);
+    zassert_equal(buf->len, sizeof(response));
+    zassert_mem_equal(buf->packet, response, sizeof(response));
+    dlt_buf_free(buf);
+    zassert_is_null(dlt_poll_buf(1, K_NO_WAIT));
+
+    buf = dlt_read_buf(TEST_EP, K_NO_WAIT);
+    zassert_not_null(buf);
+    zassert_equal(dlt_buf_msg_type(buf), DLT_REQUEST_CODE);
+    dlt_buf_free(buf);
+
+    /* Once removed, responses reach the Device again */
+    zassert_ok(dlt_route_remove(TEST_EP, DLT_RESPONSE_CODE));
+    dlt_submit(TEST_EP, response, sizeof(response), true);
+    zassert_is_null(dlt_poll_buf(1, K_NO_WAIT));
+    dlt_buf_free(dlt_read_buf(TEST_EP, K_NO_WAIT));
+}
+
+ZTEST(dlt, test_route_table)
+{
+    zassert_equal(dlt_route_add(TEST_EP, DLT_ROUTE_ANY, TEST_EP), -EINVAL);
+    zassert_equal(dlt_route_add(TEST_EP, DLT_ROUTE_ANY, TEST_NUM_EPS),
+                  -EINVAL);
+    zassert_equal(dlt_route_add(TEST_EP, DLT_CONTROL_CODE, 1), -EINVAL);
+
+    for (int i = 0; i < CONFIG_DLT_MAX_ROUTES; i++) {
+        zassert_ok(dlt_route_add(TEST_EP, DLT_ROUTE_ANY, 1));
+    }
+    zassert_equal(dlt_route_add(1, DLT_ROUTE_ANY, TEST_EP), -ENOMEM);
+
+    zassert_ok(dlt_route_remove(TEST_EP, DLT_ROUTE_ANY));
+    zassert_equal(dlt_route_remove(TEST_EP, DLT_ROUTE_ANY), -ENOENT);
+    zassert_ok(dlt_route_add(1, DLT_ROUTE_ANY, TEST_EP));
+}
+
+ZTEST(dlt, test_register_ep)
+{
+    zassert_equal(dlt_device_register_ep(DLT_MAX_ENDPOINTS, k_current_get()),
+                  -EINVAL);
+}
+
+ZTEST(dlt, test_parser_stream)
+{
+    uint8_t stream[] = {DLT_PREAMBLE, DLT_REQUEST_CODE, 2, 'a', 'b',
+                        DLT_PREAMBLE, DLT_RESPONSE_CODE, 1, 'c'};
+    struct dlt_parser parser;
+    uint8_t data[DLT_MAX_DATA_LEN];
+    uint8_t msg_type;
+
+    dlt_parser_init(&parser, TEST_EP);
+
+    /* Frames split across chunks are joined, back-to-back frames kept apart */
+    for (size_t i = 0; i < sizeof(stream); i += 2) {
+        size_t n = MIN(sizeof(stream) - i, 2);
+        zassert_equal(dlt_parser_feed(&parser, &stream[i], n), n);
+    }
+    zassert_equal(parser.frames, 2);
+    zassert_false(dlt_parser_busy(&parser));
+
+    zassert_equal(dlt_read(TEST_EP, &msg_type, data, sizeof(data), K_NO_WAIT),
+                  2);
+    zassert_equal(msg_type, DLT_REQUEST_CODE);
+    zassert_mem_equal(data, "ab", 2);
+    zassert_equal(dlt_read(TEST_EP, &msg_type, data, sizeof(data), K_NO_WAIT),
+                  1);
+    zassert_equal(msg_type, DLT_RESPONSE_CODE);
+}
+
+ZTEST(dlt, test_parser_resync)
+{
+    /* Noise, a preamble with a bad type, then a frame */
+    uint8_t stream[] = {0x00, 0x12, DLT_PREAMBLE, 0x7F, DLT_PREAMBLE,
+                        DLT_REQUEST_CODE, 1, 'x'};
+    struct dlt_parser parser;
+    uint8_t data[DLT_MAX_DATA_LEN];
+    uint8_t msg_type;
+
+    dlt_parser_init(&parser, TEST_EP);
+
+    zassert_equal(dlt_parser_feed(&parser, stream, sizeof(stream)),
+                  sizeof(stream));
+    zassert_equal(parser.frames, 1);
+    zassert_equal(parser.skipped, 4);
+    zassert_equal(dlt_read(TEST_EP, &msg_type, data, sizeof(data), K_NO_WAIT),
+                  1);
+    zassert_equal(data[0], 'x');
+
+    /* A frame cut short is dropped on reset */
+    zassert_equal(dlt_parser_feed(&parser, stream + 4, 2), 2);
+    zassert_true(dlt_parser_busy(&parser));
+    dlt_parser_reset(&parser);
+    zassert_false(dlt_parser_busy(&parser));
+}
+
+static void *dlt_test_setup(void)
+{
+    dlt_device_register(k_current_get());
+    dlt_link_register(TEST_EP, k_current_get());
+    return NULL;
+}
+
+static void dlt_test_before(void *fixture)
+{
+    ARG_UNUSED(fixture);
+
+    zassert_true(dlt_interface_init(TEST_NUM_EPS));
+    test_done_calls = 0;
+    test_done_status = 1;
+}
+
+static void dlt_test_after(void *fixture)
+{
+    ARG_UNUSED(fixture);
+    struct dlt_buf *bufs[CONFIG_DLT_BUF_COUNT];
+    struct dlt_buf *buf;
+
+    /* Release whatever a failed test left queued */
+    for (int ep = 0; ep < TEST_NUM_EPS; ep++) {
+        while ((buf = dlt_poll_buf(ep, K_NO_WAIT)) != NULL) {
+            dlt_buf_free(buf);
+        }
+        while ((buf = dlt_read_buf(ep, K_NO_WAIT)) != NULL) {
+            dlt_buf_free(buf);
+        }
+    }
+
+    /* Every buffer must be back in the pool once the test is done */
+    for (int i = 0; i < CONFIG_DLT_BUF_COUNT; i++) {
+        bufs[i] = dlt_buf_alloc(K_NO_WAIT);
+        zassert_not_null(bufs[i], "DLT buffer leaked");
+    }
+    for (int i = 0; i < CONFIG_DLT_BUF_COUNT; i++) {
+        dlt_buf_free(bufs[i]);
+    }
+}
+
+ZTEST_SUITE(dlt, NULL, dlt_test_setup, dlt_test_before, dlt_test_after,
+            NULL);
@@ -0,0 +1,98 @@
+"""
+Collect DLT benchmark results from twister output and compare them with a
+saved baseline.
+
+Usage:
+    python compare.py twister-out --save baseline.json
+    python compare.py twister-out --baseline baseline.json [--tolerance 0.2]
+
+Exits with status 1 if any result is worse than the baseline by more than
+the tolerance: throughput lower, or wake, main loop, geometry or sky patch
+time higher. Results from the Pi's link_bench.py can be compared the same way.
+"""
+
+import argparse
+import json
+import pathlib
+import sys
+
+PREFIX = "DLT_BENCH "
+
+# Fields identifying a result, and the metric compared for each test
+KEY_FIELDS = ("transport", "test", "data_len", "mode", "endpoints",
+              "link_priority")
+METRICS = {
+    "throughput": ("msgs_per_s", True),
+    "wake_latency": ("avg_ns", False),
+    "uart_link": ("bytes_per_s", True),
+    "main_loop": ("avg_ns", False),
+    "geometry": ("avg_ns", False),
+    "sky": ("avg_ns", False),
+}
+
+
+def collect(path: pathlib.Path) -> dict:
+    """ Read every DLT_BENCH line under path, keyed by configuration. """
+    files = [path] if path.is_file() else sorted(path.rglob("handler.log"))
+    results = {}
+    for log in files:
+        for line in log.read_text(errors="replace").splitlines():
+            start = line.find(PREFIX)
+            if start < 0:
+                continue
+            result = json.loads(line[start + len(PREFIX):])
+            key = "/".join(str(result[f]) for f in KEY_FIELDS)
+            results[key] = result
+    return results
+
+
+def compare(results: dict, baseline: dict, tolerance: float) -> list:
+    """ Return a description of every result that regressed. """
+    regressions = []
+    for key, old in sorted(baseline.items()):
+        new = results.get(key)
+        if new is None:
+            continue
+
+        metric, higher_is_better = METRICS[old["test"]]
+        change = (new[metric] - old[metric]) / max(old[metric], 1)
+        if not higher_is_better:
+            change = -change
+
+        if change < -tolerance:
+            regressions.append(f"{key}: {metric} {old[metric]} -> "
+                               f"{new[metric]} ({change:+.0%})")
+    return regressions
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("results", type=pathlib.Path,
+                        help="twister output directory or a log file")
+    parser.add_argument("--baseline", type=pathlib.Path)
+    parser.add_argument("--save", type=pathlib.Path)
+    parser.add_argument("--tolerance", type=float, default=0.2)
+    args = parser.parse_args()
+
+    results = collect(args.results)
+    if not results:
+        print("No DLT_BENCH results found.")
+        return 1
+
+    if args.save:
+        args.save.write_text(json.dumps(results, indent=2, sort_keys=True))
+        print(f"Saved {len(results)} results to {args.save}.")
+
+    if args.baseline:
+        baseline = json.loads(args.baseline.read_text())
+        regressions = compare(results, baseline, args.tolerance)
+        for regression in regressions:
+            print(regression)
+        print(f"{len(regressions)} of {len(baseline)} results regressed.")
+        return 1 if regressions else 0
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
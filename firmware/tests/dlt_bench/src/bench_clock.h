@@ -0,0 +1,67 @@
+/**
+ * @file bench_clock.h
+ *
+ * @brief Benchmark clock for the DLT benchmarks.
+ *
+ * On target the timing API is used, which reads the CPU cycle counter. On
+ * native_sim code executes in zero simulated time, so the host's monotonic
+ * clock is read instead, and there are no CPU cycles to count.
+ */
+
+#ifndef BENCH_CLOCK_H_
+#define BENCH_CLOCK_H_
+
+#include <zephyr/kernel.h>
+
+#ifdef CONFIG_ARCH_POSIX
+/* Implemented in host/bench_clock_bottom.c */
+extern uint64_t dlt_bench_host_ns(void);
+
+typedef uint64_t bench_time_t;
+
+static inline void bench_clock_init(void)
+{
+}
+
+static inline bench_time_t bench_clock_now(void)
+{
+    return dlt_bench_host_ns();
+}
+
+static inline uint64_t bench_clock_ns(bench_time_t start, bench_time_t end)
+{
+    return end - start;
+}
+
+static inline uint64_t bench_clock_cycles(bench_time_t start, bench_time_t end)
+{
+    return 0;
+}
+#else
+#include <zephyr/timing/timing.h>
+
+typedef timing_t bench_time_t;
+
+static inline void bench_clock_init(void)
+{
+    timing_init();
+    timing_start();
+}
+
+static inline bench_time_t bench_clock_now(void)
+{
+    return timing_counter_get();
+}
+
+static inline uint64_t bench_clock_ns(bench_time_t start, bench_time_t end)
+{
+    return timing_cycles_to_ns(timing_cycles_get(&start, &end));
+}
+
+static inline uint64_t bench_clock_cycles(bench_time_t start, bench_time_t end)
+{
+    return timing_cycles_get(&start, &end);
+}
+#endif
+
+#endif // BENCH_CLOCK_H_
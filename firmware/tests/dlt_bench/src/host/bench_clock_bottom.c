@@ -0,0 +1,15 @@
+/*
+ * Host side of the benchmark clock. Built into the native simulator runner,
+ * so it is compiled against the host C library rather than Zephyr's.
+ */
+
+#include <stdint.h>
+#include <time.h>
+
+uint64_t dlt_bench_host_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
@@ -0,0 +1,602 @@
+/**
+ * @file main.c
+ *
+ * @brief DLT transport benchmark.
+ *
+ * Measures message throughput and consumer wake latency between a Device
+ * thread and one or more Link threads for the transport selected by Kconfig,
+ * sweeping packet size, send mode, endpoint count and Link priority. It also
+ * compares the base station's main loop, blocking in k_poll() on its input
+ * sources, with the sleep-and-poll loop it replaced, its rhumb line
+ * aircraft bearing with the cached East-North-Up frame, and testing each
+ * aircraft against a display's patch of sky with testing the whole table
+ * at once. Each result is printed
+ * as a line of JSON prefixed with "DLT_BENCH", so runs of each twister
+ * scenario in testcase.yaml can be compared with compare.py.
+ */
+
+#include <math.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/ztest.h>
+
+#include "dlt_api.h"
+#include "base_geo.h"
+#include "base_sky.h"
+#include "bench_clock.h"
+
+/* Benchmark parameters, BENCH_MSGS is split evenly across the endpoints */
+#define BENCH_MAX_ENDPOINTS  DLT_MAX_ENDPOINTS
+#define BENCH_MSGS           3000
+#define BENCH_WAKE_ROUNDS    200
+#define BENCH_INFLIGHT       8
+
+#define BENCH_DEVICE_PRIORITY 6
+#define BENCH_LINK_STACKSIZE  2048
+
+/* Main loop comparison: inputs spread over the three sources, and the
+ * sleep of the polling loop being compared against */
+#define BENCH_LOOP_ROUNDS    300
+#define BENCH_LOOP_SOURCES   3
+#define BENCH_LOOP_SLEEP_MS  3
+
+/* Geometry comparison: aircraft around the observer, filtered per round */
+#define BENCH_GEO_AIRCRAFT   64
+#define BENCH_GEO_ROUNDS     200
+#define BENCH_GEO_LAT        -27.4698f
+#define BENCH_GEO_LON        153.0251f
+
+/* Sky patch comparison: a full table, the WSU turning each round */
+#define BENCH_SKY_ROUNDS     200
+#define BENCH_SKY_YAW_STEP   7.f
+
+#ifdef CONFIG_BASE_SKY_CMSIS_DSP
+#define BENCH_SKY_BATCH "batch_cmsis"
+#else
+#define BENCH_SKY_BATCH "batch"
+#endif
+
+#if defined(CONFIG_DLT_TRANSPORT_SPSC)
+#define BENCH_TRANSPORT "spsc"
+#elif defined(CONFIG_DLT_TRANSPORT_BUF)
+#define BENCH_TRANSPORT "buf"
+#else
+#define BENCH_TRANSPORT "mbox"
+#endif
+
+/* Link priority relative to the Device */
+enum bench_priority {
+    BENCH_LINK_HIGHER = -1,
+    BENCH_LINK_EQUAL = 0,
+    BENCH_LINK_LOWER = 1,
+};
+
+/* Sweep parameters */
+static const uint16_t bench_sizes[] = {8, 32, 128, DLT_MAX_DATA_LEN};
+static const uint8_t bench_endpoints[] = {1, 2, BENCH_MAX_ENDPOINTS};
+static const enum bench_priority bench_priorities[] = {
+    BENCH_LINK_HIGHER, BENCH_LINK_EQUAL, BENCH_LINK_LOWER,
+};
+
+K_THREAD_STACK_ARRAY_DEFINE(bench_link_stacks, BENCH_MAX_ENDPOINTS,
+                            BENCH_LINK_STACKSIZE);
+static struct k_thread bench_link_threads[BENCH_MAX_ENDPOINTS];
+
+/* Given by each Link once it has consumed its share of the messages */
+K_SEM_DEFINE(bench_done_sem, 0, BENCH_MAX_ENDPOINTS);
+
+/* Wake timestamp written by the Link for each latency round */
+static bench_time_t bench_wake_time;
+
+/* Free slots in the send window, given back on send completion */
+static struct k_sem bench_window_sem;
+
+/* Main loop comparison: the WSU and GPS queues, and when each input was sent */
+K_MSGQ_DEFINE(bench_wsu_msgq, sizeof(uint32_t), 4, 4);
+K_MSGQ_DEFINE(bench_gps_msgq, sizeof(uint32_t), 4, 4);
+static uint32_t bench_loop_sent[BENCH_LOOP_ROUNDS];
+
+static const char *bench_priority_name(enum bench_priority priority)
+{
+    switch (priority) {
+    case BENCH_LINK_HIGHER:
+        return "higher";
+    case BENCH_LINK_LOWER:
+        return "lower";
+    default:
+        return "equal";
+    }
+}
+
+/* Consume a single packet on the Link side and release it */
+static void bench_link_consume(uint8_t ep)
+{
+#ifdef CONFIG_DLT_BUF_POOL
+    struct dlt_buf *buf = dlt_poll_buf(ep, K_FOREVER);
+    zassert_not_null(buf);
+    dlt_buf_free(buf);
+#else
+    uint8_t packet[DLT_MAX_PACKET_LEN];
+    zassert_true(dlt_poll(ep, packet, sizeof(packet), K_FOREVER) > 0);
+#endif
+}
+
+/*
+ * Send a single packet from the Device side. The buffer pool transports keep
+ * up to the window size of sends in flight; mailbox sends always wait for
+ * the Link.
+ */
+static void bench_device_send(uint8_t ep, uint16_t data_len)
+{
+#ifdef CONFIG_DLT_BUF_POOL
+    k_sem_take(&bench_window_sem, K_FOREVER);
+
+    struct dlt_buf *buf = dlt_buf_alloc(K_FOREVER);
+    memset(dlt_buf_data(buf), 0xA5, data_len);
+    dlt_buf_set_done(buf, dlt_buf_done_give, &bench_window_sem);
+    zassert_ok(dlt_request_buf(ep, buf, data_len));
+#else
+    static uint8_t data[DLT_MAX_DATA_LEN] = {0xA5};
+    static uint8_t packet[DLT_MAX_PACKET_LEN];
+    dlt_request(ep, packet, data, data_len, false);
+#endif
+}
+
+/* Wait for every send in the window to complete */
+static void bench_device_flush(int window)
+{
+#ifdef CONFIG_DLT_BUF_POOL
+    for (int i = 0; i < window; i++) {
+        k_sem_take(&bench_window_sem, K_FOREVER);
+    }
+#endif
+}
+
+static void bench_link_throughput(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p3);
+    uint8_t ep = (uintptr_t)p1;
+
+    for (int i = 0; i < (int)(uintptr_t)p2; i++) {
+        bench_link_consume(ep);
+    }
+    k_sem_give(&bench_done_sem);
+}
+
+static void bench_link_wake(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p3);
+    uint8_t ep = (uintptr_t)p1;
+
+    for (int i = 0; i < (int)(uintptr_t)p2; i++) {
+        bench_link_consume(ep);
+        bench_wake_time = bench_clock_now();
+        k_sem_give(&bench_done_sem);
+    }
+}
+
+/*
+ * Set up the interface and the send window, register the calling thread as
+ * the Device and start one Link thread per endpoint
+ */
+static void bench_start(k_thread_entry_t entry, uint8_t endpoints, int count,
+                        enum bench_priority priority, int window)
+{
+    k_thread_priority_set(k_current_get(), BENCH_DEVICE_PRIORITY);
+    zassert_true(dlt_interface_init(endpoints));
+    dlt_device_register(k_current_get());
+    k_sem_init(&bench_window_sem, window, window);
+    k_sem_reset(&bench_done_sem);
+
+    for (uint8_t ep = 0; ep < endpoints; ep++) {
+        k_tid_t tid = k_thread_create(&bench_link_threads[ep],
+                                      bench_link_stacks[ep],
+                                      K_THREAD_STACK_SIZEOF(bench_link_stacks[ep]),
+                                      entry, (void *)(uintptr_t)ep,
+                                      (void *)(uintptr_t)count, NULL,
+                                      BENCH_DEVICE_PRIORITY + priority, 0,
+                                      K_FOREVER);
+        dlt_link_register(ep, tid);
+        k_thread_start(tid);
+    }
+}
+
+static void bench_join(uint8_t endpoints)
+{
+    for (uint8_t ep = 0; ep < endpoints; ep++) {
+        k_thread_join(&bench_link_threads[ep], K_FOREVER);
+    }
+}
+
+static void bench_throughput(uint16_t data_len, bool async, uint8_t endpoints,
+                             enum bench_priority priority)
+{
+    int window = async ? BENCH_INFLIGHT : 1;
+
+    bench_start(bench_link_throughput, endpoints, BENCH_MSGS / endpoints,
+                priority, window);
+
+    bench_time_t start = bench_clock_now();
+    for (int i = 0; i < BENCH_MSGS; i++) {
+        bench_device_send(i % endpoints, data_len);
+    }
+    bench_device_flush(window);
+    for (uint8_t ep = 0; ep < endpoints; ep++) {
+        k_sem_take(&bench_done_sem, K_FOREVER);
+    }
+    bench_time_t end = bench_clock_now();
+
+    bench_join(endpoints);
+
+    uint64_t ns = bench_clock_ns(start, end);
+    zassert_true(ns > 0);
+
+    printk("DLT_BENCH {\"transport\":\"%s\",\"test\":\"throughput\","
+           "\"data_len\":%u,\"mode\":\"%s\",\"endpoints\":%u,"
+           "\"link_priority\":\"%s\",\"msgs\":%u,\"ns\":%llu,"
+           "\"msgs_per_s\":%llu}\n",
+           BENCH_TRANSPORT, data_len, async ? "async" : "sync", endpoints,
+           bench_priority_name(priority), BENCH_MSGS, ns,
+           (uint64_t)BENCH_MSGS * NSEC_PER_SEC / ns);
+}
+
+static void bench_wake_latency(uint16_t data_len, enum bench_priority priority)
+{
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    uint64_t min_ns = UINT64_MAX;
+
+    bench_start(bench_link_wake, 1, BENCH_WAKE_ROUNDS, priority, 1);
+
+    for (int i = 0; i < BENCH_WAKE_ROUNDS; i++) {
+        /* Let the Link go back to sleep on an empty endpoint */
+        k_sleep(K_MSEC(1));
+
+        bench_time_t start = bench_clock_now();
+        bench_device_send(0, data_len);
+        k_sem_take(&bench_done_sem, K_FOREVER);
+
+        uint64_t ns = bench_clock_ns(start, bench_wake_time);
+        total_ns += ns;
+        max_ns = MAX(max_ns, ns);
+        min_ns = MIN(min_ns, ns);
+    }
+    bench_device_flush(1);
+
+    bench_join(1);
+
+    printk("DLT_BENCH {\"transport\":\"%s\",\"test\":\"wake_latency\","
+           "\"data_len\":%u,\"mode\":\"sync\",\"endpoints\":1,"
+           "\"link_priority\":\"%s\",\"rounds\":%u,\"avg_ns\":%llu,"
+           "\"min_ns\":%llu,\"max_ns\":%llu}\n",
+           BENCH_TRANSPORT, data_len, bench_priority_name(priority),
+           BENCH_WAKE_ROUNDS, total_ns / BENCH_WAKE_ROUNDS, min_ns, max_ns);
+}
+
+#ifdef CONFIG_DLT_BUF_POOL
+/*
+ * Stand in for the Pi link, the WSU and the GPS: send one input every 1 to
+ * 3 ms, round robin over the sources, so inputs land at every phase of the
+ * polling loop's sleep
+ */
+static void bench_loop_source(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1);
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    for (uint32_t i = 0; i < BENCH_LOOP_ROUNDS; i++) {
+        k_sleep(K_USEC(1000 + (i * 733) % 2000));
+        bench_loop_sent[i] = k_cycle_get_32();
+
+        switch (i % BENCH_LOOP_SOURCES) {
+        case 0: {
+            struct dlt_buf *buf = dlt_buf_alloc(K_FOREVER);
+            sys_put_le32(i, dlt_buf_data(buf));
+            buf->packet[0] = DLT_PREAMBLE;
+            buf->packet[1] = DLT_REQUEST_CODE;
+            buf->packet[2] = sizeof(i);
+            buf->len = DLT_PROTOCOL_BYTES + sizeof(i);
+            dlt_submit_buf(0, buf);
+            break;
+        }
+        case 1:
+            k_msgq_put(&bench_wsu_msgq, &i, K_FOREVER);
+            break;
+        default:
+            k_msgq_put(&bench_gps_msgq, &i, K_FOREVER);
+            break;
+        }
+    }
+}
+
+/* Handle whatever input is ready on a source, returns its round or -1 */
+static int bench_loop_take(int source)
+{
+    uint32_t round;
+
+    if (source == 0) {
+        struct dlt_buf *buf = dlt_read_buf(0, K_NO_WAIT);
+        if (!buf) {
+            return -1;
+        }
+        round = sys_get_le32(dlt_buf_data(buf));
+        dlt_buf_free(buf);
+        return round;
+    }
+
+    struct k_msgq *q = source == 1 ? &bench_wsu_msgq : &bench_gps_msgq;
+    return k_msgq_get(q, &round, K_NO_WAIT) ? -1 : (int)round;
+}
+
+/*
+ * Run the main loop until every input is handled, either sleeping between
+ * checks of every source or blocking in k_poll() and checking the sources
+ * that fired. Reports the latency from input to handling, how often the
+ * loop woke and how much of the time the CPU was idle.
+ */
+static void bench_main_loop(bool event_driven)
+{
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    uint32_t wakeups = 0;
+    int handled = 0;
+
+    k_msgq_purge(&bench_wsu_msgq);
+    k_msgq_purge(&bench_gps_msgq);
+    bench_start(bench_loop_source, 1, 0, BENCH_LINK_EQUAL, 1);
+
+    struct k_poll_event events[BENCH_LOOP_SOURCES];
+    dlt_read_event_init(0, &events[0]);
+    k_poll_event_init(&events[1], K_POLL_TYPE_MSGQ_DATA_AVAILABLE,
+                      K_POLL_MODE_NOTIFY_ONLY, &bench_wsu_msgq);
+    k_poll_event_init(&events[2], K_POLL_TYPE_MSGQ_DATA_AVAILABLE,
+                      K_POLL_MODE_NOTIFY_ONLY, &bench_gps_msgq);
+
+#ifdef CONFIG_SCHED_THREAD_USAGE_ALL
+    k_thread_runtime_stats_t before, after;
+    k_thread_runtime_stats_all_get(&before);
+#endif
+
+    while (handled < BENCH_LOOP_ROUNDS) {
+        if (event_driven) {
+            k_poll(events, BENCH_LOOP_SOURCES, K_FOREVER);
+        } else {
+            k_sleep(K_MSEC(BENCH_LOOP_SLEEP_MS));
+        }
+        wakeups++;
+
+        for (int source = 0; source < BENCH_LOOP_SOURCES; source++) {
+            if (event_driven &&
+                events[source].state == K_POLL_STATE_NOT_READY) {
+                continue;
+            }
+            events[source].state = K_POLL_STATE_NOT_READY;
+
+            int round = bench_loop_take(source);
+            if (round < 0) {
+                continue;
+            }
+
+            uint64_t ns = k_cyc_to_ns_floor64(k_cycle_get_32() -
+                                              bench_loop_sent[round]);
+            total_ns += ns;
+            max_ns = MAX(max_ns, ns);
+            handled++;
+        }
+    }
+
+    uint32_t idle_pct = 0;
+#ifdef CONFIG_SCHED_THREAD_USAGE_ALL
+    k_thread_runtime_stats_all_get(&after);
+    uint64_t elapsed = after.execution_cycles - before.execution_cycles;
+    idle_pct = elapsed ? (after.idle_cycles - before.idle_cycles) * 100 /
+                         elapsed : 0;
+#endif
+
+    bench_join(1);
+
+    printk("DLT_BENCH {\"transport\":\"%s\",\"test\":\"main_loop\","
+           "\"data_len\":4,\"mode\":\"%s\",\"endpoints\":1,"
+           "\"link_priority\":\"equal\",\"rounds\":%u,\"avg_ns\":%llu,"
+           "\"max_ns\":%llu,\"wakeups\":%u,\"idle_pct\":%u}\n",
+           BENCH_TRANSPORT, event_driven ? "k_poll" : "sleep_poll",
+           BENCH_LOOP_ROUNDS, total_ns / BENCH_LOOP_ROUNDS, max_ns, wakeups,
+           idle_pct);
+}
+#endif
+
+/* Aircraft positions for the geometry comparison */
+static float bench_geo_pos[BENCH_GEO_AIRCRAFT][3];
+
+/* Aircraft positions for the sky patch comparison */
+static struct base_geo_enu bench_sky_enu[BASE_SKY_BATCH_SIZE];
+static struct base_sky_batch bench_sky_batch;
+static float bench_sky_cos[BASE_SKY_BATCH_SIZE];
+
+/*
+ * Time the per-aircraft geometry of the base station filter, the rhumb line
+ * bearing from the GPS fix or a projection into the cached observer frame.
+ */
+static void bench_geometry(bool cached)
+{
+    struct base_geo_frame frame = {0};
+    volatile float sink = 0.f;
+
+    /* Spread the aircraft within 250 km, as the Pi would report them */
+    uint32_t seed = 1;
+    for (int i = 0; i < BENCH_GEO_AIRCRAFT; i++) {
+        seed = seed * 1103515245U + 12345U;
+        bench_geo_pos[i][0] = BENCH_GEO_LAT + (int)(seed % 4500) / 1000.f -
+                              2.25f;
+        seed = seed * 1103515245U + 12345U;
+        bench_geo_pos[i][1] = BENCH_GEO_LON + (int)(seed % 5000) / 1000.f -
+                              2.5f;
+        bench_geo_pos[i][2] = (seed >> 16) % 12000;
+    }
+
+    bench_time_t start = bench_clock_now();
+    for (int round = 0; round < BENCH_GEO_ROUNDS; round++) {
+        /* The fix is unchanged, as between GPS updates */
+        base_geo_frame_update(&frame, BENCH_GEO_LAT, BENCH_GEO_LON, 0.f);
+
+        for (int i = 0; i < BENCH_GEO_AIRCRAFT; i++) {
+            if (cached) {
+                struct base_geo_enu enu;
+                struct base_geo_look look;
+                base_geo_enu(&frame, bench_geo_pos[i][0],
+                             bench_geo_pos[i][1], bench_geo_pos[i][2], &enu);
+                base_geo_look(&enu, &look);
+                sink = look.azimuth;
+            } else {
+                sink = base_geo_rhumb_bearing(BENCH_GEO_LAT, BENCH_GEO_LON,
+                                              bench_geo_pos[i][0],
+                                              bench_geo_pos[i][1]);
+            }
+        }
+    }
+    uint64_t ns = bench_clock_ns(start, bench_clock_now());
+    ARG_UNUSED(sink);
+
+    printk("DLT_BENCH {\"transport\":\"%s\",\"test\":\"geometry\","
+           "\"data_len\":%d,\"mode\":\"%s\",\"endpoints\":1,"
+           "\"link_priority\":\"equal\",\"rounds\":%d,\"avg_ns\":%llu}\n",
+           BENCH_TRANSPORT, BENCH_GEO_AIRCRAFT, cached ? "enu" : "rhumb",
+           BENCH_GEO_ROUNDS,
+           ns / ((uint64_t)BENCH_GEO_ROUNDS * BENCH_GEO_AIRCRAFT));
+}
+
+/*
+ * Time re-evaluating every tracked aircraft when the WSU turns: against the
+ * patch and the patch with hysteresis, and the angle off the boresight for
+ * ranking. One aircraft at a time, or the whole table in a batch.
+ */
+static void bench_sky(bool batch)
+{
+    struct base_geo_frame frame = {0};
+    volatile uint32_t sink = 0;
+
+    /* A full table within 250 km, some below the horizon */
+    base_geo_frame_update(&frame, BENCH_GEO_LAT, BENCH_GEO_LON, 0.f);
+    base_sky_batch_clear(&bench_sky_batch);
+    uint32_t seed = 1;
+    for (int i = 0; i < BASE_SKY_BATCH_SIZE; i++) {
+        seed = seed * 1103515245U + 12345U;
+        float lat = BENCH_GEO_LAT + (int)(seed % 4500) / 1000.f - 2.25f;
+        seed = seed * 1103515245U + 12345U;
+        float lon = BENCH_GEO_LON + (int)(seed % 5000) / 1000.f - 2.5f;
+        base_geo_enu(&frame, lat, lon, (seed >> 16) % 4000,
+                     &bench_sky_enu[i]);
+        base_sky_batch_set(&bench_sky_batch, i, &bench_sky_enu[i]);
+    }
+
+    bench_time_t start = bench_clock_now();
+    for (int round = 0; round < BENCH_SKY_ROUNDS; round++) {
+        struct base_sky_patch enter, leave;
+        float yaw = fmodf(round * BENCH_SKY_YAW_STEP, 360.f);
+
+        base_sky_patch_set(&enter, yaw, 15.f, 30.f, 0.f);
+        base_sky_patch_set(&leave, yaw, 15.f, 35.f, 0.f);
+
+        if (batch) {
+            uint32_t in_enter[BASE_SKY_MASK_WORDS];
+            uint32_t in_leave[BASE_SKY_MASK_WORDS];
+
+            base_sky_batch_cos(&enter, &bench_sky_batch, bench_sky_cos);
+            base_sky_batch_mask(&enter, &bench_sky_batch, bench_sky_cos,
+                                in_enter);
+            base_sky_batch_mask(&leave, &bench_sky_batch, bench_sky_cos,
+                                in_leave);
+            sink = in_enter[0] ^ in_leave[0];
+        } else {
+            for (int i = 0; i < BASE_SKY_BATCH_SIZE; i++) {
+                bool in = base_sky_patch_contains(&enter, &bench_sky_enu[i]);
+                in ^= base_sky_patch_contains(&leave, &bench_sky_enu[i]);
+                bench_sky_cos[i] = base_sky_patch_cos(&enter,
+                                                      &bench_sky_enu[i]);
+                sink = in;
+            }
+        }
+    }
+    bench_time_t end = bench_clock_now();
+    uint64_t ns = bench_clock_ns(start, end);
+    uint64_t cycles = bench_clock_cycles(start, end);
+    ARG_UNUSED(sink);
+
+    printk("DLT_BENCH {\"transport\":\"%s\",\"test\":\"sky\","
+           "\"data_len\":%d,\"mode\":\"%s\",\"endpoints\":1,"
+           "\"link_priority\":\"equal\",\"rounds\":%d,\"avg_ns\":%llu,"
+           "\"avg_cycles\":%llu}\n",
+           BENCH_TRANSPORT, BASE_SKY_BATCH_SIZE,
+           batch ? BENCH_SKY_BATCH : "patch", BENCH_SKY_ROUNDS,
+           ns / BENCH_SKY_ROUNDS, cycles / BENCH_SKY_ROUNDS);
+}
+
+ZTEST(dlt_bench, test_throughput)
+{
+    ARRAY_FOR_EACH(bench_sizes, s) {
+        ARRAY_FOR_EACH(bench_endpoints, e) {
+            ARRAY_FOR_EACH(bench_priorities, p) {
+                bench_throughput(bench_sizes[s], false, bench_endpoints[e],
+                                 bench_priorities[p]);
+            }
+        }
+    }
+}
+
+ZTEST(dlt_bench, test_async_throughput)
+{
+#ifndef CONFIG_DLT_BUF_POOL
+    /* Mailbox async sends share the caller's packet, so can't be windowed */
+    ztest_test_skip();
+#else
+    ARRAY_FOR_EACH(bench_sizes, s) {
+        ARRAY_FOR_EACH(bench_endpoints, e) {
+            ARRAY_FOR_EACH(bench_priorities, p) {
+                bench_throughput(bench_sizes[s], true, bench_endpoints[e],
+                                 bench_priorities[p]);
+            }
+        }
+    }
+#endif
+}
+
+ZTEST(dlt_bench, test_wake_latency)
+{
+    ARRAY_FOR_EACH(bench_sizes, s) {
+        ARRAY_FOR_EACH(bench_priorities, p) {
+            bench_wake_latency(bench_sizes[s], bench_priorities[p]);
+        }
+    }
+}
+
+ZTEST(dlt_bench, test_main_loop)
+{
+#ifndef CONFIG_DLT_BUF_POOL
+    /* Mailboxes have no poll event for the Device side */
+    ztest_test_skip();
+#else
+    bench_main_loop(false);
+    bench_main_loop(true);
+#endif
+}
+
+ZTEST(dlt_bench, test_geometry)
+{
+    bench_geometry(false);
+    bench_geometry(true);
+}
+
+ZTEST(dlt_bench, test_sky)
+{
+    bench_sky(false);
+    bench_sky(true);
+}
+
+static void *dlt_bench_setup(void)
+{
+    bench_clock_init();
+    return NULL;
+}
+
+ZTEST_SUITE(dlt_bench, NULL, dlt_bench_setup, NULL, NULL, NULL);
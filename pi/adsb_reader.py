@@ -1,4 +1,6 @@
+import json
 import logging
+import math
 import requests
 import subprocess
 import threading
@@ -12,6 +14,35 @@ DUMP1090_PATH = "./dump1090/dump1090"
 
 UART_PORT = "/dev/serial/by-id/usb-SEGGER_J-Link_001050234086-if00"
 
+# Append every poll of dump1090 to this file for sky_replay.py, or None
+RECORD_PATH = None
+
+# The base and the M5 predict aircraft between updates, so an update is only
+# sent once the aircraft strays this far from where the updates sent so far
+# predict, changes course, speed or altitude, or has not been sent for the
+# longest silence. 0 sends every change.
+PREDICT_TOLERANCE_M = 50.0
+PREDICT_TRACK_DEG = 2
+PREDICT_SPEED_KT = 5
+PREDICT_ALTITUDE_FT = 100
+PREDICT_MAX_SILENCE_S = 10.0
+
+EARTH_RADIUS_M = 6371008.8
+KT_TO_MPS = 0.514444
+FT_TO_M = 0.3048
+
+# The displays' Kalman filter, as in firmware/lib/adsb_predict.c: the
+# prediction horizon (CONFIG_ADSB_PREDICT_HORIZON_S), the unmodelled
+# acceleration, the variances of the reports and the outlier gate
+PREDICT_HORIZON_S = 30.0
+PREDICT_Q_HORIZONTAL = 4.0
+PREDICT_Q_VERTICAL = 1.0
+PREDICT_R_POSITION = 900.0
+PREDICT_R_ALTITUDE = 50.0
+PREDICT_R_VELOCITY = 9.0
+PREDICT_P_CLIMB = 100.0
+PREDICT_GATE = 25.0
+
 
 class LoggerThread(threading.Thread):
     """
@@ -107,6 +138,241 @@ def is_same_adsb(a: dict, b: dict) -> bool:
     return False
 
 
+class PredictAxis:
+    """
+    A constant-velocity estimate along one axis, in metres and seconds.
+
+    Attributes:
+        pos (float): Metres from the latest report, altitude for up.
+        vel (float): Metres per second.
+        p00, p01, p11 (float): Covariance of pos and vel.
+    """
+
+    def __init__(self, pos: float, vel: float, p00: float, p11: float):
+        self.pos = pos
+        self.vel = vel
+        self.p00 = p00
+        self.p01 = 0.0
+        self.p11 = p11
+
+    def step(self, dt: float, q: float) -> None:
+        """ Move the estimate on by dt seconds. """
+        self.pos += self.vel * dt
+        self.p00 += dt * (2.0 * self.p01 + dt * self.p11) + q * dt ** 3 / 3.0
+        self.p01 += dt * self.p11 + q * dt * dt / 2.0
+        self.p11 += q * dt
+
+    def outlier(self, pos: float, r_pos: float) -> bool:
+        """ Whether a measured position is too far off to trust. """
+        return (pos - self.pos) ** 2 > PREDICT_GATE * (self.p00 + r_pos)
+
+    def correct(self, pos: float, vel: float, r_pos: float,
+                r_vel: float) -> None:
+        """ Correct the estimate with a measured position and velocity. """
+        s00 = self.p00 + r_pos
+        s11 = self.p11 + r_vel
+        det = s00 * s11 - self.p01 * self.p01
+
+        k00 = (self.p00 * s11 - self.p01 * self.p01) / det
+        k01 = self.p01 * r_pos / det
+        k10 = self.p01 * r_vel / det
+        k11 = (self.p11 * s00 - self.p01 * self.p01) / det
+
+        dpos = pos - self.pos
+        dvel = vel - self.vel
+        self.pos += k00 * dpos + k01 * dvel
+        self.vel += k10 * dpos + k11 * dvel
+
+        self.p00, self.p01, self.p11 = (
+            self.p00 - k00 * self.p00 - k01 * self.p01,
+            self.p01 - k00 * self.p01 - k01 * self.p11,
+            self.p11 - k10 * self.p01 - k11 * self.p11)
+
+    def correct_pos(self, pos: float, r_pos: float) -> None:
+        """ Correct the estimate with a measured position alone. """
+        s = self.p00 + r_pos
+        k0 = self.p00 / s
+        k1 = self.p01 / s
+
+        dpos = pos - self.pos
+        self.pos += k0 * dpos
+        self.vel += k1 * dpos
+
+        self.p11 -= k1 * self.p01
+        self.p01 -= k0 * self.p01
+        self.p00 -= k0 * self.p00
+
+
+def east_per_deg(lat: float) -> float:
+    """ Metres per degree of longitude, kept finite at the poles. """
+    return (math.radians(EARTH_RADIUS_M)
+            * max(math.cos(math.radians(lat)), 1e-3))
+
+
+class AircraftPrediction:
+    """
+    Where the displays predict an aircraft is, from the updates sent for it.
+
+    A port of firmware/lib/adsb_predict.c, fed the same updates the displays
+    are sent. The displays run it in single precision, on their own clocks,
+    and may miss updates the base drops, so it matches their estimate
+    closely rather than exactly.
+
+    Attributes:
+        sent (dict): The latest update sent.
+        time (float): Time of its position.
+    """
+
+    def __init__(self, d: dict, t: float):
+        self._start(d, t)
+
+    def _start(self, d: dict, t: float) -> None:
+        speed = d["speed"] * KT_TO_MPS
+        track = math.radians(d["track"])
+
+        self.sent = d
+        self.time = t
+        self.north = PredictAxis(0.0, speed * math.cos(track),
+                                 PREDICT_R_POSITION, PREDICT_R_VELOCITY)
+        self.east = PredictAxis(0.0, speed * math.sin(track),
+                                PREDICT_R_POSITION, PREDICT_R_VELOCITY)
+        self.up = PredictAxis(d["altitude"] * FT_TO_M, 0.0,
+                              PREDICT_R_ALTITUDE, PREDICT_P_CLIMB)
+
+    def update(self, d: dict, t: float) -> None:
+        """
+        Correct the prediction with an update sent for the aircraft.
+
+        Args:
+            d (dict): The ADS-B packet sent.
+            t (float): Time of its position.
+        """
+        dt = t - self.time
+        if dt > PREDICT_HORIZON_S:
+            self._start(d, t)
+            return
+
+        self.north.step(dt, PREDICT_Q_HORIZONTAL)
+        self.east.step(dt, PREDICT_Q_HORIZONTAL)
+        self.up.step(dt, PREDICT_Q_VERTICAL)
+
+        # The update relative to the previous one
+        north = math.radians(d["lat"] - self.sent["lat"]) * EARTH_RADIUS_M
+        east = ((d["lon"] - self.sent["lon"] + 180.0) % 360.0 - 180.0
+                ) * east_per_deg(self.sent["lat"])
+        altitude = d["altitude"] * FT_TO_M
+        speed = d["speed"] * KT_TO_MPS
+        track = math.radians(d["track"])
+
+        if (self.north.outlier(north, PREDICT_R_POSITION)
+                or self.east.outlier(east, PREDICT_R_POSITION)
+                or self.up.outlier(altitude, PREDICT_R_ALTITUDE)):
+            self._start(d, t)
+            return
+
+        self.north.correct(north, speed * math.cos(track),
+                           PREDICT_R_POSITION, PREDICT_R_VELOCITY)
+        self.east.correct(east, speed * math.sin(track),
+                          PREDICT_R_POSITION, PREDICT_R_VELOCITY)
+        self.up.correct_pos(altitude, PREDICT_R_ALTITUDE)
+
+        # Measure from this update from now on
+        self.north.pos -= north
+        self.east.pos -= east
+        self.sent = d
+        self.time = t
+
+    def at(self, t: float) -> tuple:
+        """
+        Predict where the aircraft is.
+
+        Args:
+            t (float): Time to predict for.
+
+        Returns:
+            tuple: The predicted latitude, longitude and altitude in feet.
+        """
+        dt = min(max(t - self.time, 0.0), PREDICT_HORIZON_S)
+        north = self.north.pos + self.north.vel * dt
+        east = self.east.pos + self.east.vel * dt
+        up = self.up.pos + self.up.vel * dt
+
+        lat = self.sent["lat"] + north / math.radians(EARTH_RADIUS_M)
+        lon = self.sent["lon"] + east / east_per_deg(self.sent["lat"])
+        return lat, (lon + 180.0) % 360.0 - 180.0, up / FT_TO_M
+
+
+def position_time(positions: dict, d: dict, now: float) -> float:
+    """
+    Find when an aircraft was first reported at its current position.
+
+    dump1090 repeats an aircraft's last position until it hears a new one,
+    so the position is as old as the first poll that reported it.
+
+    Args:
+        positions (dict): The last position and its time for each aircraft,
+            updated.
+        d (dict): The ADS-B packet.
+        now (float): Time of the poll.
+
+    Returns:
+        float: The time the position was first reported.
+    """
+    last = positions.get(d["hex"])
+    if last is None or last[:2] != (d["lat"], d["lon"]):
+        last = (d["lat"], d["lon"], now)
+        positions[d["hex"]] = last
+    return last[2]
+
+
+def is_predictable(d: dict, prediction: AircraftPrediction,
+                   seen: float) -> bool:
+    """
+    Check if the displays can predict an ADS-B packet from the ones sent.
+
+    Args:
+        d (dict): The new ADS-B packet.
+        prediction (AircraftPrediction): The prediction from the packets
+            sent for the same aircraft.
+        seen (float): Time of the new packet's position.
+
+    Returns:
+        bool: True if the packet need not be sent. False otherwise.
+    """
+    sent = prediction.sent
+    elapsed = seen - prediction.time
+    if not PREDICT_TOLERANCE_M or elapsed >= PREDICT_MAX_SILENCE_S:
+        return False
+
+    turn = abs((d["track"] - sent["track"] + 180) % 360 - 180)
+    if (turn > PREDICT_TRACK_DEG
+            or abs(d["speed"] - sent["speed"]) > PREDICT_SPEED_KT
+            or abs(d["altitude"] - sent["altitude"]) > PREDICT_ALTITUDE_FT):
+        return False
+
+    lat, lon, _ = prediction.at(seen)
+    north = math.radians(d["lat"] - lat) * EARTH_RADIUS_M
+    east = (math.radians((d["lon"] - lon + 180.0) % 360.0 - 180.0)
+            * EARTH_RADIUS_M * math.cos(math.radians(lat)))
+    return math.hypot(north, east) <= PREDICT_TOLERANCE_M
+
+
+def sent_update(cache: dict, d: dict, seen: float) -> None:
+    """
+    Record an ADS-B packet as sent, correcting the aircraft's prediction.
+
+    Args:
+        cache (dict): The prediction for each aircraft, updated.
+        d (dict): The ADS-B packet sent.
+        seen (float): Time of its position.
+    """
+    prediction = cache.get(d["hex"])
+    if prediction is None:
+        cache[d["hex"]] = AircraftPrediction(d, seen)
+    else:
+        prediction.update(d, seen)
+
+
 def pb_encode_adsb(adsb_dict: dict) -> str:
     """ Encode the ADS-B packet dictionary into protobuf messsage bytes. """
     adsb_pb = phaethon_pb2.ADSBData()
@@ -121,9 +387,11 @@ def pb_encode_adsb(adsb_dict: dict) -> str:
     return adsb_pb.SerializeToString()
 
 
-def mainloop(dump1090: subprocess.Popen, dlt_if: dlt.DLTInterface):
+def mainloop(dump1090: subprocess.Popen, dlt_if: dlt.DLTInterface,
+             record=None):
 
     adsb_cache = {}
+    positions = {}
 
     while True:
         # Poll the child
@@ -139,16 +407,26 @@ def mainloop(dump1090: subprocess.Popen, dlt_if: dlt.DLTInterface):
 
         # Forward the data to the NRF board
         data = response.json()
+        if record is not None:
+            record.write(json.dumps({"time": time.time(),
+                                     "aircraft": data}) + "\n")
+        now = time.time()
         for d in data:
             h = d["hex"]
-            if h not in adsb_cache or not is_same_adsb(d, adsb_cache[h]):
-                logging.info(f"New ADSB packet for {h}")
-                adsb_cache[h] = d
+            seen = position_time(positions, d, now)
+            if h in adsb_cache:
+                prediction = adsb_cache[h]
+                if (is_same_adsb(d, prediction.sent)
+                        or is_predictable(d, prediction, seen)):
+                    continue
+
+            logging.info(f"New ADSB packet for {h}")
+            sent_update(adsb_cache, d, seen)
 
-                # Encode and send the ADS-B packet
-                adsb_bytes = pb_encode_adsb(d)
-                dlt_if.request(adsb_bytes)
-                logging.info("ADS-B packet requested via DLT interface.")
+            # Encode and send the ADS-B packet
+            adsb_bytes = pb_encode_adsb(d)
+            dlt_if.request(adsb_bytes)
+            logging.info("ADS-B packet requested via DLT interface.")
 
         # Sleep for 50ms
         time.sleep(0.05)
@@ -172,7 +450,11 @@ def main():
         dlt_if = dlt.DLTInterface(backend="serial", port=UART_PORT)
 
         logging.info("Starting main loop.")
-        mainloop(dump1090, dlt_if)
+        if RECORD_PATH is not None:
+            with open(RECORD_PATH, "a") as record:
+                mainloop(dump1090, dlt_if, record)
+        else:
+            mainloop(dump1090, dlt_if)
 
     except KeyboardInterrupt:
         logging.info("Keyboard interrupt received.")
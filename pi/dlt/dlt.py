@@ -2,6 +2,7 @@ import serial
 import logging
 import time
 import queue
+import struct
 import threading
 
 logger = logging.getLogger(__name__)
@@ -10,6 +11,94 @@ logger = logging.getLogger(__name__)
 DLT_PREAMBLE = 0x77
 DLT_REQUEST_CODE = 0x01
 DLT_RESPONSE_CODE = 0x02
+DLT_PROTOCOL_BYTES = 3
+DLT_MAX_DATA_LEN = 255
+
+# Container packets carry several complete DLT packets back to back
+DLT_AGGREGATE_CODE = 0x03
+
+# Control packets are answered by the device's DLT library itself. The first
+# data byte is the opcode; replies carry the opcode with DLT_CTRL_REPLY set.
+DLT_CONTROL_CODE = 0x04
+DLT_CTRL_REPLY = 0x80
+DLT_CTRL_STATS = 0x01
+
+# Link control opcodes are answered by the device's link itself. A link
+# configuration request carries the baud rate and DLT_LINK_FLOW_* flags;
+# replies put a status byte, 0 if accepted, before them. The link switches
+# once its reply is sent, then falls back to DLT_DEFAULT_BAUDRATE unless a
+# confirm request arrives at the new settings within
+# DLT_LINK_CONFIRM_TIMEOUT seconds. Confirm requests are then repeated every
+# DLT_LINK_KEEPALIVE seconds, and either end falls back if it hears nothing
+# from the other for DLT_LINK_KEEPALIVE_TIMEOUT seconds.
+DLT_CTRL_LINK_CONFIG = 0x02
+DLT_CTRL_LINK_CONFIRM = 0x03
+DLT_LINK_FLOW_RTS_CTS = 0x01
+DLT_LINK_CONFIG = struct.Struct("<BIB")
+DLT_LINK_REPLY = struct.Struct("<BBIB")
+DLT_LINK_CONFIRM_TIMEOUT = 0.5
+DLT_LINK_KEEPALIVE = 0.5
+DLT_LINK_KEEPALIVE_TIMEOUT = 2.0
+DLT_DEFAULT_BAUDRATE = 115200
+DLT_LINK_BAUDRATES = (1000000, 921600, 460800, 230400, 115200)
+
+# Statistics dump: a header of version, endpoint count and histogram bins,
+# then per endpoint six u32 counters, two u16 queue depths, the TX and RX
+# latency histograms as u32 counts and the link parameters (little endian)
+DLT_STATS_VERSION = 2
+DLT_STATS_HEADER = struct.Struct("<BBB")
+DLT_STATS_COUNTERS = struct.Struct("<6I2H")
+DLT_STATS_FIELDS = ("tx_msgs", "tx_bytes", "rx_msgs", "rx_bytes", "drops",
+                    "truncations", "tx_max_depth", "rx_max_depth")
+DLT_STATS_LINK = struct.Struct("<2I2H")
+DLT_STATS_LINK_FIELDS = ("bit_rate", "interval_us", "latency", "data_len")
+
+# Fragmented messages set this flag in the message type of every fragment.
+# Each fragment's data starts with a header of message id, fragment index
+# and total message length (little endian).
+DLT_FRAGMENT_FLAG = 0x80
+DLT_FRAGMENT_HEADER_LEN = 4
+DLT_MAX_FRAGMENTS = 256
+
+# Largest packet, header included, sent in one piece over the UART link
+DLT_DEFAULT_MTU = 50
+
+
+def parse_stats(dump: bytes) -> list:
+    """
+    Parse a statistics dump into one dict per endpoint. Latency histograms
+    are lists where bin n counts latencies in [2^(n-1), 2^n) microseconds,
+    and "link" is a dict of the link parameters, 0 where a link has none.
+    """
+    if len(dump) < DLT_STATS_HEADER.size:
+        raise ValueError("DLT statistics dump is truncated.")
+
+    version, num_endpoints, bins = DLT_STATS_HEADER.unpack_from(dump)
+    if version != DLT_STATS_VERSION:
+        raise ValueError(f"Unsupported DLT statistics version {version}.")
+
+    hist = struct.Struct(f"<{bins}I")
+    record_len = (DLT_STATS_COUNTERS.size + 2 * hist.size +
+                  DLT_STATS_LINK.size)
+    if len(dump) != DLT_STATS_HEADER.size + num_endpoints * record_len:
+        raise ValueError("DLT statistics dump has the wrong length.")
+
+    endpoints = []
+    offset = DLT_STATS_HEADER.size
+    for _ in range(num_endpoints):
+        stats = dict(zip(DLT_STATS_FIELDS,
+                         DLT_STATS_COUNTERS.unpack_from(dump, offset)))
+        offset += DLT_STATS_COUNTERS.size
+        stats["tx_latency"] = list(hist.unpack_from(dump, offset))
+        offset += hist.size
+        stats["rx_latency"] = list(hist.unpack_from(dump, offset))
+        offset += hist.size
+        stats["link"] = dict(zip(DLT_STATS_LINK_FIELDS,
+                                 DLT_STATS_LINK.unpack_from(dump, offset)))
+        offset += DLT_STATS_LINK.size
+        endpoints.append(stats)
+
+    return endpoints
 
 
 # Base class for DLT Backend
@@ -20,6 +109,19 @@ class DLTBackend(threading.Thread):
 
     Parameters:
         interface_read_queue (Queue): The queue for storing received data.
+        mtu (int): The largest packet written in one piece.
+        aggregate_window (float | None): If set, packets submitted within
+            this many seconds of each other are packed into container
+            packets up to the MTU.
+        control_queue (Queue | None): If set, control packets are stored
+            here instead of the read queue.
+
+    Attributes:
+        baudrate (int): The baud rate the port is at.
+        rtscts (bool): Whether RTS/CTS flow control is on.
+        keepalive (bool): Whether to keep negotiated link settings alive,
+            falling back to the default settings if the device stops
+            answering.
 
     Methods:
         submit_write(item) -> None:
@@ -31,11 +133,24 @@ class DLTBackend(threading.Thread):
         stop() -> None:
             Stops the backend thread.
     """
-    def __init__(self, interface_read_queue: queue.Queue):
+    def __init__(self, interface_read_queue: queue.Queue,
+                 mtu=DLT_DEFAULT_MTU, aggregate_window=None,
+                 control_queue=None):
         super().__init__()
         self._if_read_queue = interface_read_queue
+        self._control_queue = control_queue
         self._write_queue = queue.Queue()
         self._stop_event = threading.Event()
+        self._partial = None
+        self._mtu = min(mtu, DLT_MAX_DATA_LEN + DLT_PROTOCOL_BYTES)
+        self._aggregate_window = aggregate_window
+        self._pending = []
+        self._pending_since = None
+        self.baudrate = DLT_DEFAULT_BAUDRATE
+        self.rtscts = False
+        self.keepalive = False
+        self._keepalive_at = 0.0
+        self._heard_at = 0.0
 
     def _write(self, s: bytes) -> None:
         raise NotImplementedError("write() method is not implemented")
@@ -52,6 +167,9 @@ class DLTBackend(threading.Thread):
     def _is_connected(self):
         raise NotImplementedError("is_connected() method is not implemented")
 
+    def configure(self, baudrate, rtscts=False) -> None:
+        raise NotImplementedError("configure() method is not implemented")
+
     def _read_packet(self) -> tuple:
         dlt_length = None
         count = 0
@@ -82,8 +200,125 @@ class DLTBackend(threading.Thread):
             count += 1
 
         self._log_dlt_packet(packet)
+        if msg_code & DLT_FRAGMENT_FLAG:
+            return self._reassemble(msg_code & ~DLT_FRAGMENT_FLAG, data)
         return msg_code, data
 
+    def _reassemble(self, msg_code, fragment) -> tuple:
+        """ Collect a fragment, returning the message once complete. """
+        if len(fragment) < DLT_FRAGMENT_HEADER_LEN:
+            self._partial = None
+            return None, None
+
+        msg_id = fragment[0]
+        index = fragment[1]
+        total = int.from_bytes(fragment[2:4], "little")
+
+        # The first fragment starts a new message, abandoning any other
+        if index == 0:
+            self._partial = {"code": msg_code, "id": msg_id, "index": 0,
+                             "total": total, "data": bytearray()}
+
+        partial = self._partial
+        if (partial is None or partial["code"] != msg_code or
+                partial["id"] != msg_id or partial["index"] != index or
+                partial["total"] != total):
+            logger.warning("DLT fragment out of sequence, dropping message.")
+            self._partial = None
+            return None, None
+
+        partial["data"] += fragment[DLT_FRAGMENT_HEADER_LEN:]
+        partial["index"] += 1
+        if len(partial["data"]) < total:
+            return None, None
+
+        self._partial = None
+        if len(partial["data"]) > total:
+            logger.warning("DLT fragment overran message, dropping message.")
+            return None, None
+
+        logger.info(f"DLT message reassembled, {total} bytes.")
+        return msg_code, bytes(partial["data"])
+
+    def _split(self, msg_code, data) -> list:
+        """ Split a container packet into the messages it carries. """
+        if msg_code is None or data is None:
+            return []
+        if msg_code != DLT_AGGREGATE_CODE:
+            return [(msg_code, data)]
+
+        messages = []
+        offset = 0
+        while offset < len(data):
+            header = data[offset:offset + DLT_PROTOCOL_BYTES]
+            if (len(header) < DLT_PROTOCOL_BYTES or
+                    header[0] != DLT_PREAMBLE or
+                    header[1] == DLT_AGGREGATE_CODE):
+                logger.warning("Malformed DLT container packet.")
+                break
+
+            start = offset + DLT_PROTOCOL_BYTES
+            offset = start + header[2]
+            payload = data[start:offset]
+            if len(payload) != header[2]:
+                logger.warning("Malformed DLT container packet.")
+                break
+
+            code = header[1]
+            if code & DLT_FRAGMENT_FLAG:
+                code, payload = self._reassemble(code & ~DLT_FRAGMENT_FLAG,
+                                                 payload)
+            if code is not None:
+                messages.append((code, payload))
+
+        return messages
+
+    def _aggregate(self, packets) -> list:
+        """ Pack packets into as few container packets as fit the MTU. """
+        groups = [[]]
+        for packet in packets:
+            size = (DLT_PROTOCOL_BYTES + len(packet) +
+                    sum(len(p) for p in groups[-1]))
+            if groups[-1] and size > self._mtu:
+                groups.append([])
+            groups[-1].append(packet)
+
+        containers = []
+        for group in groups:
+            if len(group) == 1:
+                containers.append(group[0])
+                continue
+
+            data = b"".join(group)
+            containers.append(bytearray([DLT_PREAMBLE, DLT_AGGREGATE_CODE,
+                                         len(data)]) + data)
+        return containers
+
+    def _write_pending(self) -> None:
+        """ Write submitted packets, packing them if aggregation is on. """
+        while not self._write_queue.empty():
+            self._pending.append(self._write_queue.get())
+        if not self._pending:
+            return
+
+        # Hold packets until the window closes or they fill a container
+        if self._aggregate_window is not None:
+            now = time.monotonic()
+            if self._pending_since is None:
+                self._pending_since = now
+
+            size = sum(len(p) for p in self._pending) + DLT_PROTOCOL_BYTES
+            if (size <= self._mtu and
+                    now - self._pending_since < self._aggregate_window):
+                return
+
+            self._pending = self._aggregate(self._pending)
+
+        for packet in self._pending:
+            self._write(packet)
+        self._pending = []
+        self._pending_since = None
+
     def _log_dlt_packet(self, packet, log_data=False):
         logger.info("==================================")
         for count, byte in enumerate(packet):
@@ -111,6 +346,26 @@ class DLTBackend(threading.Thread):
     def submit_write(self, item):
         self._write_queue.put(item)
 
+    def start_keepalive(self) -> None:
+        """ Keep the current link settings alive from now on. """
+        self._keepalive_at = self._heard_at = time.monotonic()
+        self.keepalive = True
+
+    def _keep_link(self) -> None:
+        """ Send link keepalives, falling back once they go unanswered. """
+        if not self.keepalive:
+            return
+
+        now = time.monotonic()
+        if now - self._heard_at >= DLT_LINK_KEEPALIVE_TIMEOUT:
+            logger.warning("DLT link lost, falling back.")
+            self.keepalive = False
+            self.configure(DLT_DEFAULT_BAUDRATE)
+        elif now - self._keepalive_at >= DLT_LINK_KEEPALIVE:
+            self._keepalive_at = now
+            self._write(bytes([DLT_PREAMBLE, DLT_CONTROL_CODE, 1,
+                               DLT_CTRL_LINK_CONFIRM]))
+
     def run(self):
         while True:
             # Terminate if stop condition is met
@@ -119,14 +374,25 @@ class DLTBackend(threading.Thread):
 
             # Read packet
             msg_code, data = self._read_packet()
-            if msg_code is not None and data is not None and len(data) > 0:
-                # Forward data to DLT interface
-                self._if_read_queue.put((msg_code, data))
-
-            # Check if we need to write data
-            if not self._write_queue.empty():
-                write_item = self._write_queue.get()
-                self._write(write_item)
+            if msg_code is not None:
+                self._heard_at = time.monotonic()
+            for msg_code, data in self._split(msg_code, data):
+                if len(data) == 0:
+                    continue
+                if (self.keepalive and msg_code == DLT_CONTROL_CODE and
+                        data[0] == DLT_CTRL_LINK_CONFIRM | DLT_CTRL_REPLY):
+                    # Keepalive replies only show the device is there
+                    continue
+                if (msg_code == DLT_CONTROL_CODE and
+                        self._control_queue is not None):
+                    self._control_queue.put(data)
+                else:
+                    # Forward data to DLT interface
+                    self._if_read_queue.put((msg_code, data))
+
+            # Write all pending packets, so fragments go out back to back
+            self._write_pending()
+            self._keep_link()
 
             time.sleep(0.001)
 
@@ -143,21 +409,33 @@ class SerialBackend(DLTBackend):
     Parameters:
         interface_read_queue (Queue): The queue for storing received data.
         port (str): The port to use for the serial connection.
+        baudrate (int): The baud rate to open the port at.
+        **kwargs: Passed on to DLTBackend.
     """
 
-    def __init__(self, interface_read_queue, port: str) -> None:
-        super().__init__(interface_read_queue)
+    def __init__(self, interface_read_queue, port: str,
+                 baudrate=DLT_DEFAULT_BAUDRATE, **kwargs) -> None:
+        super().__init__(interface_read_queue, **kwargs)
         self.port = port
         self._conn = None
-        self._connect()
+        self._connect(baudrate)
 
         # Start
         self.start()
 
-    def _connect(self, baudrate=115200) -> None:
+    def _connect(self, baudrate=DLT_DEFAULT_BAUDRATE, rtscts=False) -> None:
         """ Connect to the device using the specified port """
-        self._conn = serial.Serial(self.port, baudrate, timeout=0.1)
+        self._conn = serial.Serial(self.port, baudrate, timeout=0.1,
+                                   rtscts=rtscts)
+        self._conn.reset_input_buffer()
+        self.baudrate, self.rtscts = baudrate, rtscts
+
+    def configure(self, baudrate, rtscts=False) -> None:
+        """ Change the port settings without closing it. """
+        self._conn.baudrate = baudrate
+        self._conn.rtscts = rtscts
         self._conn.reset_input_buffer()
+        self.baudrate, self.rtscts = baudrate, rtscts
 
     def _disconnect(self):
         """ Disconnect from the device """
@@ -196,6 +474,10 @@ class DLTInterface:
     Parameters:
         backend (str): The type of backend to use. Only 'serial' is supported.
         port (str): The port to use with the serial backend.
+        mtu (int): The largest packet sent in one piece. Larger messages
+            are fragmented. Must match the device's link MTU.
+        aggregate_window (float | None): If set, messages sent within this
+            many seconds of each other are packed into container packets.
 
     Methods:
         request(data: bytes) -> None:
@@ -207,21 +489,43 @@ class DLTInterface:
         read() -> tuple | None:
             Reads a message from the DLT interface.
 
+        request_stats(timeout: float) -> list:
+            Requests the device's DLT statistics, one dict per endpoint.
+
+        negotiate_link(baudrates, rtscts: bool, timeout: float) -> int:
+            Switches the link to the fastest baud rate the device accepts,
+            returning the baud rate in use.
+
         close() -> None:
             Closes the DLT interface and stops the backend.
     """
-    def __init__(self, backend="serial", port="/dev/ttyACM0") -> None:
+    def __init__(self, backend="serial", port="/dev/ttyACM0",
+                 mtu=DLT_DEFAULT_MTU, aggregate_window=None) -> None:
         self._read_queue = queue.Queue()
+        self._control_queue = queue.Queue()
+        self._mtu = min(mtu, DLT_MAX_DATA_LEN + DLT_PROTOCOL_BYTES)
+        self._msg_id = 0
 
         # Create the backend
         try:
             if backend == "serial":
-                self._backend = SerialBackend(self._read_queue, port)
+                self._backend = SerialBackend(
+                    self._read_queue, port, mtu=mtu,
+                    aggregate_window=aggregate_window,
+                    control_queue=self._control_queue)
             else:
                 raise NotImplementedError(f"Backend {backend} not supported.")
         except ConnectionError:
             logger.error("Backend failed to connect")
 
+    @property
+    def baudrate(self) -> int:
+        return self._backend.baudrate
+
+    @property
+    def rtscts(self) -> bool:
+        return self._backend.rtscts
+
     def request(self, data) -> None:
         self._write(data, DLT_REQUEST_CODE)
 
@@ -233,11 +537,82 @@ class DLTInterface:
             return None
         return self._read_queue.get_nowait()
 
+    def request_stats(self, timeout=1.0) -> list:
+        reply = self._control(bytes([DLT_CTRL_STATS]), timeout)
+        if reply is None:
+            raise TimeoutError("No DLT statistics reply.")
+        return parse_stats(reply[1:])
+
+    def negotiate_link(self, baudrates=DLT_LINK_BAUDRATES, rtscts=False,
+                       timeout=0.2) -> int:
+        """
+        Try each baud rate in turn, with RTS/CTS flow control if rtscts is
+        set, until the device accepts one and it works both ways. Nothing
+        else should be sent while negotiating. Settings other than the
+        default are then kept alive, and both ends fall back to the default
+        if the other stops answering.
+        """
+        for baudrate in baudrates:
+            if self._switch_link(baudrate, rtscts, timeout):
+                logger.info(f"DLT link at {baudrate} baud.")
+                return baudrate
+        return self.baudrate
+
     def close(self) -> None:
         # Stop the backend thread
         self._backend.stop()
         self._backend.join()
 
+    def _control(self, request, timeout) -> bytes | None:
+        """ Send a control request and wait for its reply. """
+        # Discard replies to earlier requests that timed out
+        while not self._control_queue.empty():
+            self._control_queue.get_nowait()
+
+        self._write(request, DLT_CONTROL_CODE)
+
+        deadline = time.monotonic() + timeout
+        while True:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                return None
+            try:
+                reply = self._control_queue.get(timeout=remaining)
+            except queue.Empty:
+                continue
+            if reply[0] == request[0] | DLT_CTRL_REPLY:
+                return reply
+
+    def _switch_link(self, baudrate, rtscts, timeout) -> bool:
+        """ Switch both ends to new link settings, confirming them. """
+        self._backend.keepalive = False
+        flags = DLT_LINK_FLOW_RTS_CTS if rtscts else 0
+        reply = self._control(
+            DLT_LINK_CONFIG.pack(DLT_CTRL_LINK_CONFIG, baudrate, flags),
+            timeout)
+        if reply is None or len(reply) != DLT_LINK_REPLY.size:
+            return False
+        if DLT_LINK_REPLY.unpack(reply)[1] != 0:
+            logger.info(f"Device rejected {baudrate} baud.")
+            return False
+
+        # The device switches once its reply is out, give it a moment
+        self._backend.configure(baudrate, rtscts)
+        time.sleep(0.01)
+
+        reply = self._control(bytes([DLT_CTRL_LINK_CONFIRM]), timeout)
+        if reply is not None and len(reply) == DLT_LINK_REPLY.size:
+            # The device falls back without keepalives
+            if baudrate != DLT_DEFAULT_BAUDRATE or rtscts:
+                self._backend.start_keepalive()
+            return True
+
+        # The device falls back to the default settings, wait for it to
+        logger.warning(f"DLT link failed at {baudrate} baud, falling back.")
+        self._backend.configure(DLT_DEFAULT_BAUDRATE)
+        time.sleep(DLT_LINK_CONFIRM_TIMEOUT)
+        return False
+
     def _generate_dlt_packet(self, data, msg_type) -> bytearray:
         # Create a byte array from data
         byte_array = bytearray(data)
@@ -249,7 +624,28 @@ class DLTInterface:
 
         return byte_array
 
+    def _generate_dlt_packets(self, data, msg_type) -> list:
+        # Messages that fit the MTU are sent as a single packet
+        if len(data) + DLT_PROTOCOL_BYTES <= self._mtu:
+            return [self._generate_dlt_packet(data, msg_type)]
+
+        # Otherwise split the message into fragments
+        frag_max = self._mtu - DLT_PROTOCOL_BYTES - DLT_FRAGMENT_HEADER_LEN
+        fragments = [data[i:i + frag_max]
+                     for i in range(0, len(data), frag_max)]
+        if len(fragments) > DLT_MAX_FRAGMENTS or len(data) > 0xFFFF:
+            raise ValueError(f"Message of {len(data)} bytes is too large.")
+
+        msg_id = self._msg_id
+        self._msg_id = (self._msg_id + 1) & 0xFF
+
+        header = len(data).to_bytes(2, "little")
+        return [self._generate_dlt_packet(
+                    bytes([msg_id, index]) + header + fragment,
+                    msg_type | DLT_FRAGMENT_FLAG)
+                for index, fragment in enumerate(fragments)]
+
     def _write(self, data, msg_type) -> None:
-        # Generate the DLT packet and submit to backend
-        packet = self._generate_dlt_packet(data, msg_type)
-        self._backend.submit_write(packet)
+        # Generate the DLT packets and submit to backend
+        for packet in self._generate_dlt_packets(data, msg_type):
+            self._backend.submit_write(packet)
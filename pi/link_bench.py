@@ -0,0 +1,89 @@
+"""
+Measure the Pi to base DLT link at each baud rate the base can negotiate.
+
+For every rate the link is negotiated, then DLT statistics are requested
+repeatedly: each round trip is a 4 byte request and a fragmented reply of a
+few hundred bytes, answered by the base's DLT library. Each rate prints a
+DLT_BENCH line of JSON, which firmware/tests/dlt_bench/compare.py reads, and
+a table is printed at the end.
+
+Usage:
+    python link_bench.py --port /dev/ttyACM0 [--rtscts] > link.log
+    python ../firmware/tests/dlt_bench/compare.py link.log --save link.json
+"""
+
+import argparse
+import json
+import statistics
+import time
+
+import dlt
+
+
+def measure(dlt_if, rounds, timeout) -> dict | None:
+    """ Time stats round trips at the current link settings. """
+    latencies = []
+    reply_len = 0
+    endpoints = 0
+    start = time.monotonic()
+    for _ in range(rounds):
+        sent = time.monotonic()
+        reply = dlt_if._control(bytes([dlt.DLT_CTRL_STATS]), timeout)
+        if reply is None:
+            return None
+        latencies.append(time.monotonic() - sent)
+        reply_len = len(reply)
+        endpoints = len(dlt.parse_stats(reply[1:]))
+    elapsed = time.monotonic() - start
+
+    return {
+        "data_len": reply_len,
+        "endpoints": endpoints,
+        "rounds": rounds,
+        "bytes_per_s": int(rounds * reply_len / elapsed),
+        "avg_us": int(statistics.mean(latencies) * 1e6),
+        "max_us": int(max(latencies) * 1e6),
+    }
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--port", default="/dev/ttyACM0")
+    parser.add_argument("--rtscts", action="store_true")
+    parser.add_argument("--rounds", type=int, default=100)
+    parser.add_argument("--timeout", type=float, default=0.5)
+    args = parser.parse_args()
+
+    dlt_if = dlt.DLTInterface(backend="serial", port=args.port)
+    rows = []
+    try:
+        for baudrate in sorted(dlt.DLT_LINK_BAUDRATES):
+            rtscts = args.rtscts and baudrate != dlt.DLT_DEFAULT_BAUDRATE
+            if dlt_if.negotiate_link((baudrate,), rtscts) != baudrate:
+                print(f"# {baudrate} baud: negotiation failed")
+                continue
+
+            result = measure(dlt_if, args.rounds, args.timeout)
+            if result is None:
+                print(f"# {baudrate} baud: no reply")
+                continue
+
+            mode = f"{baudrate}{'-rtscts' if rtscts else ''}"
+            result = {"transport": "uart", "test": "uart_link",
+                      "mode": mode, "link_priority": "n/a", **result}
+            print("DLT_BENCH " + json.dumps(result))
+            rows.append(result)
+    finally:
+        dlt_if.negotiate_link((dlt.DLT_DEFAULT_BAUDRATE,))
+        dlt_if.close()
+
+    print()
+    print("| Link | Bytes/s | Round trip avg (us) | Round trip max (us) |")
+    print("|---|---|---|---|")
+    for row in rows:
+        print(f"| {row['mode']} | {row['bytes_per_s']} | {row['avg_us']} | "
+              f"{row['max_us']} |")
+
+
+if __name__ == "__main__":
+    main()
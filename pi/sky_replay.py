@@ -0,0 +1,149 @@
+"""
+Measure how much of a recorded ADS-B stream the base forwards to the M5.
+
+Replays a recording made by adsb_reader.py (RECORD_PATH) through the same
+de-duplication the Pi does, which skips updates the displays can predict
+unless --no-predict is given, and three base station filters, for a display
+pointed at each yaw in turn:
+
+    all      every update, as before the base filtered anything
+    bearing  azimuth within the aperture of the yaw, the old 2D filter
+    sky      the 3D patch: a cone around yaw and pitch, aircraft below
+             the horizon dropped, and an optional maximum range
+
+The geometry mirrors base_geo.c and base_sky.c. Bytes are the DLT packets
+sent over BLE, protobuf payload and header. A table of the average rate
+over all yaws is printed.
+
+Usage:
+    python sky_replay.py adsb.jsonl --lat -27.47 --lon 153.02 [--pitch 15]
+        [--aperture 30] [--max-range 0] [--alt 0] [--no-predict]
+"""
+
+import argparse
+import json
+import math
+
+import dlt
+from adsb_reader import (is_predictable, is_same_adsb, pb_encode_adsb,
+                         position_time, sent_update)
+
+EARTH_RADIUS_M = 6371008.8
+FT_TO_M = 0.3048
+
+
+def enu(origin: tuple, lat: float, lon: float, alt: float) -> tuple:
+    """ Position in the observer's East-North-Up frame, as base_geo_enu. """
+    lat0, lon0, alt0 = origin
+    dlat = lat - lat0
+    dlon = (lon - lon0 + 180.0) % 360.0 - 180.0
+
+    metres_per_deg = math.radians(EARTH_RADIUS_M)
+    north = dlat * metres_per_deg
+    east = dlon * metres_per_deg * math.cos(math.radians(lat0 + dlat / 2))
+    up = alt - alt0 - (east * east + north * north) / (2 * EARTH_RADIUS_M)
+    return east, north, up
+
+
+def in_bearing(pos: tuple, yaw: float, aperture: float) -> bool:
+    """ The old filter, azimuth only. """
+    azimuth = math.degrees(math.atan2(pos[0], pos[1])) % 360.0
+    difference = abs(azimuth - yaw)
+    return min(difference, 360.0 - difference) <= aperture
+
+
+def in_sky(pos: tuple, yaw: float, pitch: float, aperture: float,
+           max_range: float) -> bool:
+    """ The sky patch, as base_sky_patch_contains with the horizon on. """
+    if pos[2] < 0:
+        return False
+
+    distance = math.sqrt(sum(p * p for p in pos))
+    if max_range and distance > max_range:
+        return False
+
+    psi, theta = math.radians(yaw), math.radians(pitch)
+    boresight = (math.sin(psi) * math.cos(theta),
+                 math.cos(psi) * math.cos(theta), math.sin(theta))
+    dot = sum(p * b for p, b in zip(pos, boresight))
+    return dot >= distance * math.cos(math.radians(aperture))
+
+
+def load(path: str, predict: bool) -> tuple:
+    """ The packets the Pi sends for a recording, with their positions. """
+    cache = {}
+    positions = {}
+    packets = []
+    duration = 0.0
+    start = None
+    with open(path) as f:
+        for line in f:
+            snapshot = json.loads(line)
+            start = snapshot["time"] if start is None else start
+            duration = snapshot["time"] - start
+            for d in snapshot["aircraft"]:
+                h = d["hex"]
+                seen = position_time(positions, d, snapshot["time"])
+                if h in cache:
+                    prediction = cache[h]
+                    if (is_same_adsb(d, prediction.sent) or predict and
+                            is_predictable(d, prediction, seen)):
+                        continue
+                sent_update(cache, d, seen)
+                size = len(pb_encode_adsb(d)) + dlt.DLT_PROTOCOL_BYTES
+                packets.append((d["lat"], d["lon"],
+                                d["altitude"] * FT_TO_M, size))
+    return packets, max(duration, 1.0)
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("recording")
+    parser.add_argument("--lat", type=float, required=True)
+    parser.add_argument("--lon", type=float, required=True)
+    parser.add_argument("--alt", type=float, default=0.0,
+                        help="observer altitude, metres")
+    parser.add_argument("--pitch", type=float, default=15.0)
+    parser.add_argument("--aperture", type=float, default=30.0)
+    parser.add_argument("--max-range", type=float, default=0.0,
+                        help="km, 0 for no limit")
+    parser.add_argument("--yaw-step", type=int, default=10)
+    parser.add_argument("--no-predict", action="store_true",
+                        help="send every change, as before the displays "
+                             "predicted positions")
+    args = parser.parse_args()
+
+    packets, duration = load(args.recording, not args.no_predict)
+    origin = (args.lat, args.lon, args.alt)
+    positions = [(enu(origin, lat, lon, alt), size)
+                 for lat, lon, alt, size in packets]
+    yaws = range(0, 360, args.yaw_step)
+
+    totals = {"all": [0, 0], "bearing": [0, 0], "sky": [0, 0]}
+    for yaw in yaws:
+        for pos, size in positions:
+            passed = {
+                "all": True,
+                "bearing": in_bearing(pos, yaw, args.aperture),
+                "sky": in_sky(pos, yaw, args.pitch, args.aperture,
+                              args.max_range * 1000.0),
+            }
+            for name, ok in passed.items():
+                if ok:
+                    totals[name][0] += 1
+                    totals[name][1] += size
+
+    print(f"# {len(packets)} updates over {duration:.0f} s, pitch "
+          f"{args.pitch}, aperture {args.aperture}, max range "
+          f"{args.max_range or 'none'}")
+    print("| Filter | Packets/s | Bytes/s | Of all |")
+    print("|---|---|---|---|")
+    all_bytes = max(totals["all"][1], 1)
+    for name, (count, size) in totals.items():
+        print(f"| {name} | {count / len(yaws) / duration:.1f} | "
+              f"{size / len(yaws) / duration:.0f} | "
+              f"{100.0 * size / all_bytes:.1f}% |")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,124 @@
+import math
+import adsb_reader
+import pytest
+
+
+@pytest.fixture
+def aircraft():
+    return {"hex": "7c6b2d", "flight": "QFA1", "lat": -27.4698,
+            "lon": 153.0251, "altitude": 12000, "speed": 250, "track": 90}
+
+
+def moved(d, north, east, **changes):
+    # Move an aircraft by metres north and east, and change other fields
+    metres_per_deg = math.radians(adsb_reader.EARTH_RADIUS_M)
+    d = dict(d, **changes)
+    d["lat"] += north / metres_per_deg
+    d["lon"] += east / (metres_per_deg * math.cos(math.radians(d["lat"])))
+    return d
+
+
+def predictable(d, sent, elapsed):
+    # Whether d is predictable from a single update sent elapsed seconds ago
+    return adsb_reader.is_predictable(
+        d, adsb_reader.AircraftPrediction(sent, 0.0), elapsed)
+
+
+def test_predict_first(aircraft):
+    prediction = adsb_reader.AircraftPrediction(aircraft, 0.0)
+    lat, lon, altitude = prediction.at(10.0)
+    expected = moved(aircraft, 0, 250 * adsb_reader.KT_TO_MPS * 10.0)
+
+    assert lat == pytest.approx(expected["lat"], abs=1e-6)
+    assert lon == pytest.approx(expected["lon"], abs=1e-5)
+    assert altitude == pytest.approx(aircraft["altitude"])
+
+
+def test_predict_climb(aircraft):
+    # Successive altitudes give the climb ADS-B doesn't report
+    prediction = adsb_reader.AircraftPrediction(aircraft, 0.0)
+    step = 250 * adsb_reader.KT_TO_MPS * 5.0
+    for i in range(1, 6):
+        prediction.update(moved(aircraft, 0, step * i,
+                                altitude=12000 + 50 * i), 5.0 * i)
+
+    _, _, altitude = prediction.at(30.0)
+    assert altitude == pytest.approx(12300, abs=30)
+
+
+def test_predict_horizon(aircraft):
+    prediction = adsb_reader.AircraftPrediction(aircraft, 0.0)
+    held = prediction.at(adsb_reader.PREDICT_HORIZON_S)
+    assert prediction.at(adsb_reader.PREDICT_HORIZON_S + 10.0) == held
+
+
+def test_predictable_on_track(aircraft):
+    ahead = moved(aircraft, 20, 250 * adsb_reader.KT_TO_MPS * 5.0)
+    assert predictable(ahead, aircraft, 5.0)
+
+
+def test_predictable_off_track(aircraft):
+    ahead = moved(aircraft, 100, 250 * adsb_reader.KT_TO_MPS * 5.0)
+    assert not predictable(ahead, aircraft, 5.0)
+
+
+def test_predictable_changes(aircraft):
+    ahead = moved(aircraft, 0, 250 * adsb_reader.KT_TO_MPS * 5.0)
+
+    assert not predictable(dict(ahead, track=95), aircraft, 5.0)
+    assert not predictable(dict(ahead, speed=260), aircraft, 5.0)
+    assert not predictable(dict(ahead, altitude=12500), aircraft, 5.0)
+
+    # Small changes are within the tolerance
+    assert predictable(dict(ahead, track=91, altitude=12025), aircraft, 5.0)
+
+
+def test_predictable_filtered(aircraft):
+    # After a jump 40 m north of the first update, the estimate only moves
+    # part of the way, where dead reckoning from the last update would not
+    cache = {}
+    step = 250 * adsb_reader.KT_TO_MPS * 2.0
+    adsb_reader.sent_update(cache, aircraft, 0.0)
+    for i in range(1, 4):
+        adsb_reader.sent_update(cache, moved(aircraft, 40, step * i), 2.0 * i)
+
+    ahead = moved(aircraft, 40, step * 4)
+    lat, _, _ = cache["7c6b2d"].at(8.0)
+    lag = math.radians(ahead["lat"] - lat) * adsb_reader.EARTH_RADIUS_M
+    assert 1.0 < lag < adsb_reader.PREDICT_TOLERANCE_M
+    assert adsb_reader.is_predictable(ahead, cache["7c6b2d"], 8.0)
+
+
+def test_predictable_silence(aircraft):
+    elapsed = adsb_reader.PREDICT_MAX_SILENCE_S
+    ahead = moved(aircraft, 0, 250 * adsb_reader.KT_TO_MPS * elapsed)
+    assert not predictable(ahead, aircraft, elapsed)
+
+
+def test_predictable_antimeridian(aircraft):
+    sent = dict(aircraft, lon=179.999)
+    ahead = moved(sent, 0, 250 * adsb_reader.KT_TO_MPS * 2.0)
+    ahead["lon"] -= 360.0
+    assert predictable(ahead, sent, 2.0)
+
+
+def test_sent_update(aircraft):
+    cache = {}
+    adsb_reader.sent_update(cache, aircraft, 1.0)
+    assert cache["7c6b2d"].sent is aircraft
+
+    ahead = moved(aircraft, 0, 100)
+    adsb_reader.sent_update(cache, ahead, 2.0)
+    assert cache["7c6b2d"].sent is ahead
+    assert cache["7c6b2d"].time == 2.0
+
+
+def test_position_time(aircraft):
+    positions = {}
+
+    # A repeated position is as old as the poll that first reported it
+    assert adsb_reader.position_time(positions, aircraft, 1.0) == 1.0
+    assert adsb_reader.position_time(positions, aircraft, 1.5) == 1.0
+
+    ahead = moved(aircraft, 0, 100)
+    assert adsb_reader.position_time(positions, ahead, 2.0) == 2.0
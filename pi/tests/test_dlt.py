@@ -2,6 +2,8 @@ import os
 import pty
 import dlt
 import pytest
+import struct
+import threading
 import time
 
 
@@ -18,6 +20,20 @@ def dlt_serial():
     dlt_if.close()
 
 
+@pytest.fixture
+def dlt_serial_aggregate():
+    # Create a virtual serial port
+    master, slave = pty.openpty()
+
+    # Create the DLTInterface with packet aggregation enabled
+    dlt_if = dlt.DLTInterface(backend="serial", port=os.ttyname(slave),
+                              aggregate_window=0.05)
+    yield dlt_if, master
+
+    # Teardown the interface
+    dlt_if.close()
+
+
 def validate_dlt_packet(packet, input_data, msg_type):
     # Check preamble byte
     assert packet[0] == dlt.DLT_PREAMBLE
@@ -80,3 +96,237 @@ def test_dlt_if_ser_read_no_data_available(dlt_serial):
 
     # Check that None is returned when no data is available
     assert dlt_if.read() is None
+
+
+def read_dlt_packets(master, count):
+    # Read back-to-back packets from master, using each length byte
+    packets = []
+    buffer = bytes()
+    while len(packets) < count:
+        buffer += os.read(master, 256)
+        while len(buffer) >= 3 and len(buffer) >= buffer[2] + 3:
+            length = buffer[2] + 3
+            packets.append(buffer[:length])
+            buffer = buffer[length:]
+    return packets
+
+
+def test_dlt_if_ser_request_fragmented(dlt_serial):
+    dlt_if, master = dlt_serial
+
+    # Setup dummy data larger than the MTU
+    data = bytes(range(256)) * 2
+    dlt_if.request(data)
+
+    # Every fragment fits the MTU and carries the message header
+    frag_max = dlt.DLT_DEFAULT_MTU - 3 - dlt.DLT_FRAGMENT_HEADER_LEN
+    count = -(-len(data) // frag_max)
+    packets = read_dlt_packets(master, count)
+
+    reassembled = bytes()
+    for index, packet in enumerate(packets):
+        assert len(packet) <= dlt.DLT_DEFAULT_MTU
+        assert packet[0] == dlt.DLT_PREAMBLE
+        assert packet[1] == dlt.DLT_REQUEST_CODE | dlt.DLT_FRAGMENT_FLAG
+        assert packet[4] == index
+        assert int.from_bytes(packet[5:7], "little") == len(data)
+        reassembled += packet[7:]
+
+    assert reassembled == data
+
+
+def test_dlt_if_ser_read_fragmented(dlt_serial):
+    dlt_if, master = dlt_serial
+
+    # Imitate an external device writing a fragmented message
+    data = bytes(range(200)) * 10
+    for packet in dlt_if._generate_dlt_packets(data, dlt.DLT_RESPONSE_CODE):
+        os.write(master, packet)
+    time.sleep(0.1)
+
+    # Read and validate the reassembled message
+    msg_type, read_data = dlt_if.read()
+    assert msg_type == dlt.DLT_RESPONSE_CODE
+    assert read_data == data
+
+
+def test_dlt_if_ser_read_fragment_out_of_sequence(dlt_serial):
+    dlt_if, master = dlt_serial
+
+    # Drop the second fragment of a message
+    data = bytes(200)
+    packets = dlt_if._generate_dlt_packets(data, dlt.DLT_REQUEST_CODE)
+    for packet in packets[:1] + packets[2:]:
+        os.write(master, packet)
+    time.sleep(0.1)
+
+    # The incomplete message is discarded
+    assert dlt_if.read() is None
+
+
+def read_dlt_packets_from(buffer):
+    # Split back-to-back packets held in a buffer
+    packets = []
+    while buffer:
+        length = buffer[2] + 3
+        packets.append(buffer[:length])
+        buffer = buffer[length:]
+    return packets
+
+
+def test_dlt_if_ser_request_aggregated(dlt_serial_aggregate):
+    dlt_if, master = dlt_serial_aggregate
+
+    # Send a burst of messages that fit in a single container
+    messages = [b"one", b"two", b"three"]
+    for message in messages:
+        dlt_if.request(message)
+
+    # The burst arrives as one container packet
+    packet = read_dlt_packets(master, 1)[0]
+    assert packet[0] == dlt.DLT_PREAMBLE
+    assert packet[1] == dlt.DLT_AGGREGATE_CODE
+    assert len(packet) <= dlt.DLT_DEFAULT_MTU
+
+    inner = read_dlt_packets_from(packet[3:])
+    assert [p[3:] for p in inner] == messages
+    assert all(p[1] == dlt.DLT_REQUEST_CODE for p in inner)
+
+
+def test_dlt_if_ser_read_aggregated(dlt_serial):
+    dlt_if, master = dlt_serial
+
+    # Imitate an external device writing a container packet
+    inner = [dlt_if._generate_dlt_packet(b"first", dlt.DLT_REQUEST_CODE),
+             dlt_if._generate_dlt_packet(b"second", dlt.DLT_RESPONSE_CODE)]
+    data = b"".join(inner)
+    os.write(master, bytes([dlt.DLT_PREAMBLE, dlt.DLT_AGGREGATE_CODE,
+                            len(data)]) + data)
+    time.sleep(0.01)
+
+    # Each message is read separately
+    assert dlt_if.read() == (dlt.DLT_REQUEST_CODE, b"first")
+    assert dlt_if.read() == (dlt.DLT_RESPONSE_CODE, b"second")
+    assert dlt_if.read() is None
+
+
+def test_dlt_if_ser_request_stats(dlt_serial):
+    dlt_if, master = dlt_serial
+
+    # Build a dump for one endpoint, larger than a single packet
+    bins = 16
+    counters = (10, 320, 4, 128, 1, 0, 3, 2)
+    tx_latency = list(range(bins))
+    rx_latency = [0] * (bins - 1) + [7]
+    link = (2000000, 7500, 0, 251)
+    dump = (struct.pack("<BBB", dlt.DLT_STATS_VERSION, 1, bins) +
+            struct.pack("<6I2H", *counters) +
+            struct.pack(f"<{bins}I", *tx_latency) +
+            struct.pack(f"<{bins}I", *rx_latency) +
+            struct.pack("<2I2H", *link))
+    reply = bytes([dlt.DLT_CTRL_STATS | dlt.DLT_CTRL_REPLY]) + dump
+
+    # Imitate the device answering the request with a fragmented reply
+    def device():
+        request = os.read(master, 4)
+        assert request == bytes([dlt.DLT_PREAMBLE, dlt.DLT_CONTROL_CODE, 1,
+                                 dlt.DLT_CTRL_STATS])
+        for packet in dlt_if._generate_dlt_packets(reply,
+                                                   dlt.DLT_CONTROL_CODE):
+            os.write(master, packet)
+
+    responder = threading.Thread(target=device)
+    responder.start()
+    stats = dlt_if.request_stats(timeout=1.0)
+    responder.join()
+
+    assert len(stats) == 1
+    assert stats[0]["tx_msgs"] == 10
+    assert stats[0]["rx_bytes"] == 128
+    assert stats[0]["drops"] == 1
+    assert stats[0]["tx_max_depth"] == 3
+    assert stats[0]["tx_latency"] == tx_latency
+    assert stats[0]["rx_latency"] == rx_latency
+    assert stats[0]["link"] == {"bit_rate": 2000000, "interval_us": 7500,
+                                "latency": 0, "data_len": 251}
+
+    # Control replies never reach the read queue
+    assert dlt_if.read() is None
+
+
+def test_dlt_if_ser_negotiate_link(dlt_serial):
+    dlt_if, master = dlt_serial
+
+    def reply(opcode, status, baudrate, flags):
+        payload = dlt.DLT_LINK_REPLY.pack(opcode | dlt.DLT_CTRL_REPLY, status,
+                                          baudrate, flags)
+        os.write(master, dlt_if._generate_dlt_packet(payload,
+                                                     dlt.DLT_CONTROL_CODE))
+
+    # Imitate a device that rejects 1 Mbaud and accepts 921600 baud
+    def device():
+        request = os.read(master, 9)
+        assert request[1] == dlt.DLT_CONTROL_CODE
+        opcode, baudrate, flags = dlt.DLT_LINK_CONFIG.unpack(request[3:])
+        assert (opcode, baudrate, flags) == (dlt.DLT_CTRL_LINK_CONFIG,
+                                             1000000, 0)
+        reply(opcode, 22, 115200, 0)
+
+        request = os.read(master, 9)
+        opcode, baudrate, flags = dlt.DLT_LINK_CONFIG.unpack(request[3:])
+        assert baudrate == 921600
+        reply(opcode, 0, baudrate, flags)
+
+        request = os.read(master, 4)
+        assert request[3] == dlt.DLT_CTRL_LINK_CONFIRM
+        reply(dlt.DLT_CTRL_LINK_CONFIRM, 0, baudrate, flags)
+
+    responder = threading.Thread(target=device)
+    responder.start()
+    baudrate = dlt_if.negotiate_link(baudrates=(1000000, 921600))
+    responder.join()
+
+    assert baudrate == 921600
+    assert dlt_if.baudrate == 921600
+    assert dlt_if._backend._conn.baudrate == 921600
+    assert dlt_if.read() is None
+
+
+def test_dlt_if_ser_keepalive(dlt_serial, monkeypatch):
+    dlt_if, master = dlt_serial
+    monkeypatch.setattr(dlt.dlt, "DLT_LINK_KEEPALIVE", 0.05)
+    monkeypatch.setattr(dlt.dlt, "DLT_LINK_KEEPALIVE_TIMEOUT", 0.5)
+
+    def reply(opcode, baudrate):
+        payload = dlt.DLT_LINK_REPLY.pack(opcode | dlt.DLT_CTRL_REPLY, 0,
+                                          baudrate, 0)
+        os.write(master, dlt_if._generate_dlt_packet(payload,
+                                                     dlt.DLT_CONTROL_CODE))
+
+    # Imitate a device that accepts 921600 baud, answers one keepalive and
+    # then resets
+    def device():
+        os.read(master, 9)
+        reply(dlt.DLT_CTRL_LINK_CONFIG, 921600)
+        os.read(master, 4)
+        reply(dlt.DLT_CTRL_LINK_CONFIRM, 921600)
+
+        keepalive = os.read(master, 4)
+        assert keepalive == bytes([dlt.DLT_PREAMBLE, dlt.DLT_CONTROL_CODE, 1,
+                                   dlt.DLT_CTRL_LINK_CONFIRM])
+        reply(dlt.DLT_CTRL_LINK_CONFIRM, 921600)
+
+    responder = threading.Thread(target=device)
+    responder.start()
+    assert dlt_if.negotiate_link(baudrates=(921600,)) == 921600
+    responder.join()
+
+    # Keepalive replies never reach the application
+    time.sleep(0.2)
+    assert dlt_if.baudrate == 921600
+    assert dlt_if._control_queue.empty()
+
+    # Unanswered keepalives fall back to the default settings
+    time.sleep(0.6)
+    assert dlt_if.baudrate == dlt.DLT_DEFAULT_BAUDRATE
+    assert dlt_if._backend._conn.baudrate == dlt.DLT_DEFAULT_BAUDRATE